@@ -0,0 +1,179 @@
+#include "AssetCache.h"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <format>
+#include <cstring>
+#include <thread>
+
+#include "MappedFile.h"
+
+std::string AssetCache::directory = "Cache";
+
+std::mutex AssetCache::sourceHashMutex;
+std::map<std::string, SourceHash> AssetCache::sourceHashes;
+
+std::atomic<std::size_t> AssetCache::hits = 0;
+std::atomic<std::size_t> AssetCache::misses = 0;
+std::atomic<std::size_t> AssetCache::writes = 0;
+
+namespace
+{
+	const std::uint64_t PRIME_1 = 0x9E3779B97F4A7C15ull;
+	const std::uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+	const std::uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+
+	std::uint64_t rotateLeft(const std::uint64_t value, const int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	std::uint64_t mixLane(const std::uint64_t lane)
+	{
+		return rotateLeft(lane * PRIME_2, 31) * PRIME_1;
+	}
+}
+
+void AssetCache::init(const std::string& directory)
+{
+	AssetCache::directory = directory;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		spdlog::error("Could not create asset cache directory '{}', {}", directory, error.message());
+	}
+}
+
+std::uint64_t AssetCache::hash(const void* data, const std::size_t size, const std::uint64_t seed)
+{
+	// 8 bytes per step, fast enough that hashing a source is far cheaper than importing it
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	std::uint64_t hash = seed ^ (size * PRIME_1);
+
+	std::size_t offset = 0;
+	for (; offset + 8 <= size; offset += 8)
+	{
+		std::uint64_t lane;
+		std::memcpy(&lane, bytes + offset, 8);
+		hash = rotateLeft(hash ^ mixLane(lane), 27) * PRIME_1 + PRIME_3;
+	}
+
+	if (offset < size)
+	{
+		std::uint64_t lane = 0;
+		std::memcpy(&lane, bytes + offset, size - offset);
+		hash = rotateLeft(hash ^ mixLane(lane), 27) * PRIME_1 + PRIME_3;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME_2;
+	hash ^= hash >> 29;
+	hash *= PRIME_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+bool AssetCache::hashSource(const std::string& path, std::uint64_t& hash)
+{
+	std::error_code error;
+	std::int64_t timestamp = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+	if (error)
+	{
+		return false;
+	}
+	std::uintmax_t size = std::filesystem::file_size(path, error);
+	if (error)
+	{
+		return false;
+	}
+
+	// sources are only rehashed once per run unless they change on disk
+	{
+		std::lock_guard<std::mutex> lock(AssetCache::sourceHashMutex);
+		auto it = AssetCache::sourceHashes.find(path);
+		if (it != AssetCache::sourceHashes.end() && it->second.timestamp == timestamp && it->second.size == size)
+		{
+			hash = it->second.hash;
+			return true;
+		}
+	}
+
+	MappedFile file;
+	if (size > 0 && !file.open(path))
+	{
+		return false;
+	}
+	hash = AssetCache::hash(file.getData(), file.getSize());
+
+	std::lock_guard<std::mutex> lock(AssetCache::sourceHashMutex);
+	AssetCache::sourceHashes[path] = { timestamp, size, hash };
+	return true;
+}
+
+std::string AssetCache::getKey(const std::vector<std::string>& sources, const std::string& settings, const std::uint32_t version)
+{
+	std::uint64_t key = AssetCache::hash(settings.data(), settings.size(), version);
+	for (const std::string& source : sources)
+	{
+		std::uint64_t sourceHash;
+		if (!AssetCache::hashSource(source, sourceHash))
+		{
+			return "";
+		}
+		key = AssetCache::hash(&sourceHash, sizeof(sourceHash), key);
+	}
+
+	return std::format("{:016x}", key);
+}
+
+std::string AssetCache::getEntryPath(const std::string& key, const std::string& extension)
+{
+	// first byte of the key as a sub directory keeps directory sizes small
+	return AssetCache::directory + '/' + key.substr(0, 2) + '/' + key + extension;
+}
+
+bool AssetCache::prepareEntry(const std::string& entryPath)
+{
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(entryPath).parent_path(), error);
+	if (error)
+	{
+		spdlog::error("Could not create asset cache entry '{}', {}", entryPath, error.message());
+		return false;
+	}
+	return true;
+}
+
+std::string AssetCache::getTemporaryPath(const std::string& entryPath)
+{
+	return std::format("{}.{:x}.tmp", entryPath, std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+void AssetCache::recordHit()
+{
+	AssetCache::hits++;
+}
+
+void AssetCache::recordMiss()
+{
+	AssetCache::misses++;
+}
+
+void AssetCache::recordWrite()
+{
+	AssetCache::writes++;
+}
+
+AssetCacheStats AssetCache::getStats()
+{
+	return { AssetCache::hits, AssetCache::misses, AssetCache::writes };
+}
+
+void AssetCache::logStats()
+{
+	AssetCacheStats stats = AssetCache::getStats();
+	spdlog::info("Asset cache '{}', {:d} hits, {:d} misses, {:d} writes", AssetCache::directory, stats.hits, stats.misses, stats.writes);
+}
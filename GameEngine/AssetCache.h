@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <map>
+
+struct AssetCacheStats
+{
+	std::size_t hits;
+	std::size_t misses;
+	std::size_t writes;
+};
+
+struct SourceHash
+{
+	std::int64_t timestamp;
+	std::uintmax_t size;
+	std::uint64_t hash;
+};
+
+// content addressed store for cooked assets, entries are named by a hash of the source bytes, import settings and format version
+struct AssetCache
+{
+private:
+	static std::string directory;
+
+	static std::mutex sourceHashMutex;
+	static std::map<std::string, SourceHash> sourceHashes;
+
+	static std::atomic<std::size_t> hits;
+	static std::atomic<std::size_t> misses;
+	static std::atomic<std::size_t> writes;
+
+	static bool hashSource(const std::string& path, std::uint64_t& hash);
+
+public:
+	static void init(const std::string& directory);
+
+	static std::uint64_t hash(const void* data, const std::size_t size, const std::uint64_t seed = 0);
+
+	// empty when a source cannot be read
+	static std::string getKey(const std::vector<std::string>& sources, const std::string& settings, const std::uint32_t version);
+
+	static std::string getEntryPath(const std::string& key, const std::string& extension);
+
+	static bool prepareEntry(const std::string& entryPath);
+
+	// unique per thread, entries are written there and renamed into place so concurrent cooks of one asset cannot interleave
+	static std::string getTemporaryPath(const std::string& entryPath);
+
+	static void recordHit();
+
+	static void recordMiss();
+
+	static void recordWrite();
+
+	static AssetCacheStats getStats();
+
+	static void logStats();
+};
@@ -0,0 +1,229 @@
+#include "AudioStreamer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "OpenALFunctions.h"
+#include "Loader.h"
+
+std::vector<AudioStream*> AudioStreamer::streams;
+std::mutex AudioStreamer::streamMutex;
+std::thread AudioStreamer::thread;
+std::atomic<bool> AudioStreamer::running = false;
+
+std::size_t AudioStreamer::bufferSize = 0;
+unsigned int AudioStreamer::bufferCount = 0;
+
+void AudioStreamer::init(const std::size_t bufferSize, const unsigned int bufferCount)
+{
+	if (AudioStreamer::running)
+	{
+		return;
+	}
+
+	AudioStreamer::bufferSize = bufferSize;
+	AudioStreamer::bufferCount = std::max(bufferCount, 2u);
+	AudioStreamer::running = true;
+	AudioStreamer::thread = std::thread(AudioStreamer::threadLoop);
+
+	spdlog::debug("Started audio streamer with {:d} buffers of {:d} bytes per stream", AudioStreamer::bufferCount, AudioStreamer::bufferSize);
+}
+
+bool AudioStreamer::open(AudioStream& stream, const std::string& filename, const ALuint source, const bool looping)
+{
+	if (!AudioStreamer::running)
+	{
+		spdlog::error("Audio streamer is not running, cannot stream '{}'", filename);
+		return false;
+	}
+
+	stream.file.open(filename, std::ios::binary);
+	if (!stream.file.is_open() || !Loader::loadWavFileHeader(stream.file, stream.sound))
+	{
+		spdlog::error("Could not open '{}' for streaming", filename);
+		return false;
+	}
+
+	stream.sound.Format = Loader::getSoundFormat(stream.sound);
+	if (stream.sound.Format == AL_NONE)
+	{
+		spdlog::error("Unrecognized wave format '{}'", filename);
+		return false;
+	}
+
+	stream.source = source;
+	stream.looping = looping;
+	stream.playing = false;
+	stream.dataStart = stream.file.tellg();
+	stream.dataRemaining = stream.sound.DataSize;
+
+	// whole sample frames per chunk so a buffer never splits a frame between channels
+	std::size_t frameSize = (std::size_t)stream.sound.Channels * stream.sound.BitsPerSample / 8;
+	stream.chunk.resize(std::max(AudioStreamer::bufferSize / frameSize, (std::size_t)1) * frameSize);
+
+	stream.buffers.resize(AudioStreamer::bufferCount);
+	alCall(alGenBuffers, (ALsizei)stream.buffers.size(), stream.buffers.data());
+	stream.freeBuffers = stream.buffers;
+
+	std::lock_guard<std::mutex> lock(AudioStreamer::streamMutex);
+	AudioStreamer::queueChunk(stream);
+	AudioStreamer::streams.push_back(&stream);
+	return true;
+}
+
+void AudioStreamer::close(AudioStream& stream)
+{
+	std::lock_guard<std::mutex> lock(AudioStreamer::streamMutex);
+	AudioStreamer::streams.erase(std::remove(AudioStreamer::streams.begin(), AudioStreamer::streams.end(), &stream), AudioStreamer::streams.end());
+
+	if (!stream.buffers.empty())
+	{
+		alCall(alSourceStop, stream.source);
+		alCall(alSourcei, stream.source, AL_BUFFER, 0);
+		alCall(alDeleteBuffers, (ALsizei)stream.buffers.size(), stream.buffers.data());
+		stream.buffers.clear();
+		stream.freeBuffers.clear();
+	}
+	stream.file.close();
+}
+
+void AudioStreamer::play(AudioStream& stream)
+{
+	std::lock_guard<std::mutex> lock(AudioStreamer::streamMutex);
+
+	// a finished track has nothing queued, start it over
+	ALint queued = 0;
+	alCall(alGetSourcei, stream.source, AL_BUFFERS_QUEUED, &queued);
+	if (queued == 0)
+	{
+		AudioStreamer::rewind(stream);
+		AudioStreamer::queueChunk(stream);
+	}
+
+	stream.playing = true;
+	alCall(alSourcePlay, stream.source);
+}
+
+void AudioStreamer::pause(AudioStream& stream)
+{
+	std::lock_guard<std::mutex> lock(AudioStreamer::streamMutex);
+	stream.playing = false;
+	alCall(alSourcePause, stream.source);
+}
+
+void AudioStreamer::stop(AudioStream& stream)
+{
+	std::lock_guard<std::mutex> lock(AudioStreamer::streamMutex);
+	stream.playing = false;
+	alCall(alSourceStop, stream.source);
+
+	// detaching the queue returns every buffer, prime the first chunk again for the next play
+	alCall(alSourcei, stream.source, AL_BUFFER, 0);
+	stream.freeBuffers = stream.buffers;
+	AudioStreamer::rewind(stream);
+	AudioStreamer::queueChunk(stream);
+}
+
+void AudioStreamer::shutdown()
+{
+	AudioStreamer::running = false;
+	if (AudioStreamer::thread.joinable())
+	{
+		AudioStreamer::thread.join();
+	}
+}
+
+void AudioStreamer::threadLoop()
+{
+	while (AudioStreamer::running)
+	{
+		{
+			std::lock_guard<std::mutex> lock(AudioStreamer::streamMutex);
+			for (AudioStream* stream : AudioStreamer::streams)
+			{
+				AudioStreamer::update(*stream);
+			}
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+void AudioStreamer::update(AudioStream& stream)
+{
+	ALint processed = 0;
+	alCall(alGetSourcei, stream.source, AL_BUFFERS_PROCESSED, &processed);
+	for (ALint i = 0; i < processed; i++)
+	{
+		ALuint buffer;
+		alCall(alSourceUnqueueBuffers, stream.source, 1, &buffer);
+		stream.freeBuffers.push_back(buffer);
+	}
+
+	while (AudioStreamer::queueChunk(stream))
+	{
+	}
+
+	if (!stream.playing)
+	{
+		return;
+	}
+
+	// the source stops by itself when the queue runs dry, restart it if there is more to play
+	ALint state = 0, queued = 0;
+	alCall(alGetSourcei, stream.source, AL_SOURCE_STATE, &state);
+	alCall(alGetSourcei, stream.source, AL_BUFFERS_QUEUED, &queued);
+	if (state != AL_PLAYING && state != AL_PAUSED)
+	{
+		if (queued > 0)
+		{
+			alCall(alSourcePlay, stream.source);
+		}
+		else
+		{
+			stream.playing = false;
+		}
+	}
+}
+
+void AudioStreamer::rewind(AudioStream& stream)
+{
+	stream.file.clear();
+	stream.file.seekg(stream.dataStart);
+	stream.dataRemaining = stream.sound.DataSize;
+}
+
+bool AudioStreamer::queueChunk(AudioStream& stream)
+{
+	if (stream.freeBuffers.empty())
+	{
+		return false;
+	}
+
+	if (stream.dataRemaining == 0)
+	{
+		if (!stream.looping)
+		{
+			return false;
+		}
+		AudioStreamer::rewind(stream);
+	}
+
+	std::size_t size = std::min(stream.chunk.size(), stream.dataRemaining);
+	stream.file.read(stream.chunk.data(), size);
+	size = (std::size_t)stream.file.gcount();
+	if (size == 0)
+	{
+		stream.dataRemaining = 0;
+		return false;
+	}
+	stream.dataRemaining -= size;
+
+	ALuint buffer = stream.freeBuffers.back();
+	stream.freeBuffers.pop_back();
+	alCall(alBufferData, buffer, stream.sound.Format, stream.chunk.data(), (ALsizei)size, stream.sound.SampleRate);
+	alCall(alSourceQueueBuffers, stream.source, 1, &buffer);
+	return true;
+}
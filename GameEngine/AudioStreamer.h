@@ -0,0 +1,64 @@
+#pragma once
+
+#include <openAL/al.h>
+
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include "Sound.h"
+
+// wav file played through a small ring of queued buffers, memory use does not depend on track length
+struct AudioStream
+{
+	ALuint source = 0;
+	std::ifstream file;
+	Sound sound;
+	std::streamoff dataStart = 0;
+	std::size_t dataRemaining = 0;
+	bool looping = false;
+	bool playing = false;
+
+	std::vector<ALuint> buffers;
+	std::vector<ALuint> freeBuffers;
+	std::vector<char> chunk;
+};
+
+struct AudioStreamer
+{
+private:
+	static std::vector<AudioStream*> streams;
+	static std::mutex streamMutex;
+	static std::thread thread;
+	static std::atomic<bool> running;
+
+	static std::size_t bufferSize;
+	static unsigned int bufferCount;
+
+	static void threadLoop();
+
+	static void update(AudioStream& stream);
+
+	static void rewind(AudioStream& stream);
+
+	static bool queueChunk(AudioStream& stream);
+
+public:
+	static void init(const std::size_t bufferSize, const unsigned int bufferCount);
+
+	// opens the file and queues the first chunk so playback can start straight away
+	static bool open(AudioStream& stream, const std::string& filename, const ALuint source, const bool looping);
+
+	static void close(AudioStream& stream);
+
+	static void play(AudioStream& stream);
+
+	static void pause(AudioStream& stream);
+
+	static void stop(AudioStream& stream);
+
+	static void shutdown();
+};
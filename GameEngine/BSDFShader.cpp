@@ -1,9 +1,6 @@
 
 #include "BSDFShader.h"
 
-#include "Camera.h"
-#include "Maths.h"
-
 BSDFShader::BSDFShader(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename) : ShaderProgram::ShaderProgram(vertexShaderFilename, fragmentShaderFilename)
 {
 	this->getAllUniformLocations();
@@ -20,9 +17,6 @@ void BSDFShader::bindAttributes()
 
 void BSDFShader::getAllUniformLocations()
 {
-	this->location_transformationMatrix = this->getUniformLocation("transformationMatrix");
-	this->location_projectionMatrix = this->getUniformLocation("projectionMatrix");
-	this->location_viewMatrix = this->getUniformLocation("viewMatrix");
 	this->location_materialKa = this->getUniformLocation("materialKa");
 	this->location_materialKd = this->getUniformLocation("materialKd");
 	this->location_materialKs = this->getUniformLocation("materialKs");
@@ -32,21 +26,6 @@ void BSDFShader::getAllUniformLocations()
 	this->location_materialIllum = this->getUniformLocation("materialIllum");
 }
 
-void BSDFShader::loadTransformationMatrix(const glm::mat4& matrix)
-{
-	this->loadMat4(this->location_transformationMatrix, matrix);
-}
-
-void BSDFShader::loadProjectionMatrix(const glm::mat4 matrix)
-{
-	this->loadMat4(this->location_projectionMatrix, matrix);
-}
-
-void BSDFShader::loadViewMatrix()
-{
-	this->loadMat4(this->location_viewMatrix, Camera::viewMatrix);
-}
-
 void BSDFShader::loadMaterialInfo(const Material& mat)
 {
 	this->loadVec3(this->location_materialKa, mat.Ka);
@@ -3,13 +3,11 @@
 #include "ShaderProgram.h"
 
 #include "Material.h"
+#include "Vertex.h"
 
 class BSDFShader : public ShaderProgram 
 {
 public:
-	int location_transformationMatrix;
-	int location_projectionMatrix;
-	int location_viewMatrix;
 	int location_materialKa;
 	int location_materialKd;
 	int location_materialKs;
@@ -28,11 +26,5 @@ public:
 
 	void getAllUniformLocations();
 
-	void loadTransformationMatrix(const glm::mat4& matrix);
-
-	void loadProjectionMatrix(const glm::mat4 matrix);
-
-	void loadViewMatrix();
-
 	void loadMaterialInfo(const Material& mat);
 };
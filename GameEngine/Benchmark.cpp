@@ -0,0 +1,968 @@
+#include "Benchmark.h"
+
+#include <glad/glad.h>
+
+#include "stb_image.h"
+
+#include <spdlog/spdlog.h>
+
+#include <unordered_map>
+#include <filesystem>
+#include <algorithm>
+#include <format>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <cmath>
+
+#include "BoundingVolumeHierarchy.h"
+#include "ReflectionShader.h"
+#include "OpenGLFunctions.h"
+#include "OcclusionCuller.h"
+#include "TextureStreamer.h"
+#include "UniformBuffers.h"
+#include "MeshletBuilder.h"
+#include "TextureCache.h"
+#include "VertexPacker.h"
+#include "TextRenderer.h"
+#include "SkyboxShader.h"
+#include "OpenGLState.h"
+#include "RenderStats.h"
+#include "RenderQueue.h"
+#include "AssetCache.h"
+#include "BSDFShader.h"
+#include "RingBuffer.h"
+#include "TextShader.h"
+#include "Config.h"
+#include "Loader.h"
+#include "Model.h"
+
+namespace
+{
+	double getMilliseconds(const std::chrono::high_resolution_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	double getMebibytes(const std::size_t bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	// uploads every streamed texture requested so far, so draws are timed with the real textures bound rather than placeholders
+	void finishTextureStreaming()
+	{
+		while (TextureStreamer::getPendingCount() > 0)
+		{
+			TextureStreamer::update();
+			std::this_thread::yield();
+		}
+	}
+
+	// resolves every uniform by name on each call, the baseline the material binding tables are measured against
+	void bindTexturesByName(Mesh& mesh, GLuint programID)
+	{
+		std::unordered_map<std::string, unsigned int> textureCount({
+			{"texture_diffuse", 0},
+			{"texture_specular", 0},
+			{"texture_normal", 0},
+			{"texture_displacement", 0},
+			{"texture_cubeMap", 0}
+		});
+
+		bool cubeMapBound = false;
+		for (unsigned int i = 0; i < mesh.textures.size(); i++)
+		{
+			OpenGLState::activeTexture(GL_TEXTURE0 + i);
+
+			std::string name = mesh.textures[i].Type;
+			std::string number = std::to_string(textureCount[name]++);
+
+			glCall(glUniform1i, glGetUniformLocation(programID, (name + number).c_str()), i);
+			if (name == "texture_cubeMap")
+			{
+				OpenGLState::bindTexture(GL_TEXTURE_CUBE_MAP, mesh.textures[i].ID);
+				cubeMapBound = true;
+			}
+			else
+			{
+				OpenGLState::bindTexture(GL_TEXTURE_2D, mesh.textures[i].ID);
+			}
+
+			// bind empty cubemap if none exists
+			if (!cubeMapBound && i == mesh.textures.size() - 1)
+			{
+				Texture empty = Loader::createEmptyCubeMap();
+				OpenGLState::activeTexture(GL_TEXTURE0 + i + 1);
+				glCall(glUniform1i, glGetUniformLocation(programID, "texture_cubeMap0"), i + 1);
+				OpenGLState::bindTexture(GL_TEXTURE_CUBE_MAP, empty.ID);
+			}
+		}
+
+		for (const auto& [name, amount] : textureCount)
+		{
+			bool isBound = (amount > 0);
+			std::string boundName = name.substr(8) + "Bound";
+			glCall(glUniform1i, glGetUniformLocation(programID, boundName.c_str()), isBound);
+		}
+	}
+}
+
+bool Benchmark::run(const std::string& name, const std::vector<std::string>& arguments)
+{
+	if (name == "textures")
+	{
+		Benchmark::textures(arguments);
+		return true;
+	}
+
+	if (name == "vertexFormats")
+	{
+		Benchmark::vertexFormats(arguments);
+		return true;
+	}
+
+	if (name == "materialBindings")
+	{
+		Benchmark::materialBindings(arguments);
+		return true;
+	}
+
+	if (name == "instancing")
+	{
+		Benchmark::instancing(arguments);
+		return true;
+	}
+
+	if (name == "multiDrawIndirect")
+	{
+		Benchmark::multiDrawIndirect(arguments);
+		return true;
+	}
+
+	if (name == "boundingVolumeHierarchy")
+	{
+		Benchmark::boundingVolumeHierarchy(arguments);
+		return true;
+	}
+
+	if (name == "occlusion")
+	{
+		Benchmark::occlusion(arguments);
+		return true;
+	}
+
+	if (name == "text")
+	{
+		Benchmark::text(arguments);
+		return true;
+	}
+
+	if (name == "programs")
+	{
+		Benchmark::programs(arguments);
+		return true;
+	}
+
+	spdlog::error("Unknown benchmark '{}'", name);
+	return false;
+}
+
+void Benchmark::textures(const std::vector<std::string>& paths)
+{
+	std::vector<std::string> texturePaths = paths;
+	if (texturePaths.empty())
+	{
+		texturePaths = { "Resources/Crate/Textures/crate.png", "Resources/Crate/Textures/crateNormal.png",
+			"Resources/TestScene/Textures/gridDiffuse.png", "Resources/TestScene/Textures/boomBoxDiffuse.png", "Resources/skyboxDay" };
+	}
+
+	double totalUncompressedTime = 0.0, totalCompressedTime = 0.0;
+	std::size_t totalUncompressedSize = 0, totalCompressedSize = 0;
+	for (const std::string& path : texturePaths)
+	{
+		bool cubeMap = std::filesystem::is_directory(path);
+		GLenum target = cubeMap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+		std::vector<std::string> sources = { path };
+		if (cubeMap)
+		{
+			sources = { path + "/right.png", path + "/left.png", path + "/top.png", path + "/bottom.png", path + "/back.png", path + "/front.png" };
+		}
+		std::string typeName = cubeMap ? "texture_cubeMap" : (path.find("ormal") != std::string::npos ? "texture_normal" : "texture_diffuse");
+
+		// cooking is an offline step and is kept out of the measurement
+		if (!TextureCache::isCookedFileValid(sources, typeName, false) && !TextureCache::cook(sources, typeName, false))
+		{
+			continue;
+		}
+
+		// uncompressed, decode the source images, upload and build mips on the gpu
+		auto start = std::chrono::high_resolution_clock::now();
+		GLuint textureID;
+		glCall(glGenTextures, 1, &textureID);
+		OpenGLState::bindTexture(target, textureID);
+
+		std::size_t uncompressedSize = 0;
+		for (unsigned int i = 0; i < sources.size(); i++)
+		{
+			int width, height, nrComponents;
+			unsigned char* data = Loader::decodeImage(sources[i], false, width, height, nrComponents);
+			if (!data)
+			{
+				continue;
+			}
+
+			GLenum format = Loader::getTextureFormat(nrComponents);
+			GLenum imageTarget = cubeMap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + i : target;
+			glCall(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+			glCall(glTexImage2D, imageTarget, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+			glCall(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+			stbi_image_free(data);
+
+			for (int mipWidth = width, mipHeight = height; ; mipWidth = std::max(mipWidth / 2, 1), mipHeight = std::max(mipHeight / 2, 1))
+			{
+				uncompressedSize += (std::size_t)mipWidth * mipHeight * nrComponents;
+				if (mipWidth == 1 && mipHeight == 1)
+				{
+					break;
+				}
+			}
+		}
+		glCall(glGenerateMipmap, target);
+		glCall(glFinish);
+		double uncompressedTime = getMilliseconds(start);
+		OpenGLState::deleteTextures(1, &textureID);
+
+		// compressed, read the cooked mip chain and upload it as is
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<TextureImage> images;
+		TextureCache::load(sources, typeName, false, target, images);
+		glCall(glGenTextures, 1, &textureID);
+		OpenGLState::bindTexture(target, textureID);
+		Loader::uploadCompressedImages(target, images);
+		glCall(glFinish);
+		double compressedTime = getMilliseconds(start);
+		OpenGLState::deleteTextures(1, &textureID);
+
+		std::size_t compressedSize = 0;
+		for (const TextureImage& image : images)
+		{
+			compressedSize += image.size;
+		}
+
+		spdlog::info("{:<48} uncompressed {:8.2f} ms {:7.2f} MiB | compressed {:8.2f} ms {:7.2f} MiB", path,
+			uncompressedTime, getMebibytes(uncompressedSize), compressedTime, getMebibytes(compressedSize));
+
+		totalUncompressedTime += uncompressedTime;
+		totalCompressedTime += compressedTime;
+		totalUncompressedSize += uncompressedSize;
+		totalCompressedSize += compressedSize;
+	}
+
+	spdlog::info("{:<48} uncompressed {:8.2f} ms {:7.2f} MiB | compressed {:8.2f} ms {:7.2f} MiB", "total",
+		totalUncompressedTime, getMebibytes(totalUncompressedSize), totalCompressedTime, getMebibytes(totalCompressedSize));
+}
+
+void Benchmark::vertexFormats(const std::vector<std::string>& paths)
+{
+	std::vector<std::string> modelPaths = paths;
+	if (modelPaths.empty())
+	{
+		modelPaths = { "Resources/TestScene/Mesh.obj", "Resources/Crate/crate.obj" };
+	}
+
+	const int DRAWS = 500;
+	BSDFShader shader = BSDFShader("Shaders/BSDFShader/bsdfShader.vert", "Shaders/BSDFShader/bsdfShader.frag");
+	bool packedVertices = Config::Models::PACKED_VERTICES;
+
+	// a tiny viewport keeps fragment work negligible so the timing is dominated by vertex fetch and transform
+	OpenGLState::viewport(0, 0, 8, 8);
+	OpenGLState::enable(GL_DEPTH_TEST);
+
+	GLuint query;
+	glCall(glGenQueries, 1, &query);
+
+	double times[2] = { 0.0, 0.0 };
+	std::size_t sizes[2] = { 0, 0 };
+	std::size_t vertexCount = 0;
+	for (int packed = 0; packed < 2; packed++)
+	{
+		Config::Models::PACKED_VERTICES = packed == 1;
+
+		std::vector<std::unique_ptr<Model>> models;
+		for (const std::string& path : modelPaths)
+		{
+			models.push_back(std::make_unique<Model>(path));
+		}
+		finishTextureStreaming();
+
+		vertexCount = 0;
+		for (const std::unique_ptr<Model>& model : models)
+		{
+			for (const Mesh& mesh : model->meshes)
+			{
+				vertexCount += mesh.positions.size();
+			}
+		}
+		sizes[packed] = vertexCount * (packed ? sizeof(PackedVertex) : sizeof(Vertex));
+
+		shader.start();
+		glm::mat4 projectionMatrix = glm::perspective(glm::radians(70.0f), 1.0f, 0.1f, 1000.0f);
+		UniformBuffers::updateFrame(projectionMatrix, {}, 0.0f);
+		for (const std::unique_ptr<Model>& model : models)
+		{
+			model->draw(shader, glm::mat4(1.0f), projectionMatrix);
+		}
+		glCall(glFinish);
+
+		glCall(glBeginQuery, GL_TIME_ELAPSED, query);
+		for (int i = 0; i < DRAWS; i++)
+		{
+			for (const std::unique_ptr<Model>& model : models)
+			{
+				model->draw(shader, glm::mat4(1.0f), projectionMatrix);
+			}
+		}
+		glCall(glEndQuery, GL_TIME_ELAPSED);
+		shader.stop();
+
+		GLuint64 elapsed = 0;
+		glCall(glGetQueryObjectui64v, query, GL_QUERY_RESULT, &elapsed);
+		times[packed] = elapsed / 1000000.0;
+
+		spdlog::info("{:<8} {:3d} B/vertex {:8d} vertices {:7.2f} MiB | {:d} draws of the set {:8.2f} ms", packed ? "packed" : "float",
+			packed ? sizeof(PackedVertex) : sizeof(Vertex), vertexCount, getMebibytes(sizes[packed]), DRAWS, times[packed]);
+	}
+
+	glCall(glDeleteQueries, 1, &query);
+	Config::Models::PACKED_VERTICES = packedVertices;
+
+	// precision lost to quantization, measured on the cpu with the same decode the shaders use
+	float positionError = 0.0f, normalError = 0.0f, texCoordError = 0.0f;
+	for (const std::string& path : modelPaths)
+	{
+		std::vector<MeshData> meshes;
+		if (!Model::importModel(path, meshes))
+		{
+			continue;
+		}
+
+		for (const MeshData& mesh : meshes)
+		{
+			std::vector<PackedVertex> packed;
+			VertexQuantization quantization = VertexPacker::pack(mesh.vertices, packed);
+			for (std::size_t i = 0; i < packed.size(); i++)
+			{
+				Vertex decoded = VertexPacker::unpack(packed[i], quantization);
+				positionError = std::max(positionError, glm::length(decoded.Position - mesh.vertices[i].Position));
+				texCoordError = std::max(texCoordError, glm::length(decoded.TexCoords - mesh.vertices[i].TexCoords));
+				if (glm::length(mesh.vertices[i].Normal) > 0.0f)
+				{
+					float cosine = glm::dot(decoded.Normal, glm::normalize(mesh.vertices[i].Normal));
+					normalError = std::max(normalError, glm::degrees(std::acos(std::clamp(cosine, -1.0f, 1.0f))));
+				}
+			}
+		}
+	}
+
+	spdlog::info("packed is {:.1f}% of the float size and draws in {:.1f}% of the time", 100.0 * sizes[1] / std::max(sizes[0], (std::size_t)1),
+		100.0 * times[1] / std::max(times[0], 1e-6));
+	spdlog::info("max error, position {:.6f} units, normal {:.4f} degrees, texture coordinates {:.6f}", positionError, normalError, texCoordError);
+}
+
+void Benchmark::materialBindings(const std::vector<std::string>& paths)
+{
+	std::vector<std::string> modelPaths = paths;
+	if (modelPaths.empty())
+	{
+		modelPaths = { "Resources/TestScene/Mesh.obj", "Resources/Crate/crate.obj" };
+	}
+
+	const int ITERATIONS = 10000;
+	BSDFShader shader = BSDFShader("Shaders/BSDFShader/bsdfShader.vert", "Shaders/BSDFShader/bsdfShader.frag");
+
+	std::vector<std::unique_ptr<Model>> models;
+	std::size_t meshCount = 0;
+	for (const std::string& path : modelPaths)
+	{
+		models.push_back(std::make_unique<Model>(path));
+		meshCount += models.back()->meshes.size();
+	}
+	finishTextureStreaming();
+
+	shader.start();
+	double times[2] = { 0.0, 0.0 };
+	for (int tables = 0; tables < 2; tables++)
+	{
+		// the first pass resolves the tables and warms the driver, only the second is timed
+		for (int pass = 0; pass < 2; pass++)
+		{
+			glCall(glFinish);
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < (pass == 0 ? 1 : ITERATIONS); i++)
+			{
+				for (const std::unique_ptr<Model>& model : models)
+				{
+					for (Mesh& mesh : model->meshes)
+					{
+						if (tables)
+						{
+							mesh.bindTextures(shader.getProgramID());
+						}
+						else
+						{
+							bindTexturesByName(mesh, shader.getProgramID());
+						}
+					}
+				}
+			}
+			times[tables] = getMilliseconds(start);
+		}
+
+		double nanoseconds = times[tables] * 1000000.0 / ((double)ITERATIONS * std::max(meshCount, (std::size_t)1));
+		spdlog::info("{:<8} {:d} binds of {:d} meshes {:8.2f} ms | {:8.1f} ns per draw", tables ? "table" : "by name", ITERATIONS, meshCount,
+			times[tables], nanoseconds);
+	}
+	shader.stop();
+	glCall(glFinish);
+
+	spdlog::info("binding tables take {:.1f}% of the cpu time of binding by name", 100.0 * times[1] / std::max(times[0], 1e-6));
+}
+
+void Benchmark::instancing(const std::vector<std::string>& arguments)
+{
+	std::string path = arguments.size() > 0 ? arguments[0] : "Resources/Crate/crate.obj";
+	int copies = arguments.size() > 1 ? std::max(std::stoi(arguments[1]), 1) : 4096;
+
+	BSDFShader shader = BSDFShader("Shaders/BSDFShader/bsdfShader.vert", "Shaders/BSDFShader/bsdfShader.frag");
+	Model model = Model(path);
+	finishTextureStreaming();
+
+	// a grid in front of the camera, the tiny viewport keeps fragment work out of the timing
+	int side = (int)std::ceil(std::sqrt((double)copies));
+	std::vector<glm::mat4> transforms;
+	for (int i = 0; i < copies; i++)
+	{
+		glm::vec3 position = glm::vec3((i % side - side * 0.5f) * 3.0f, (i / side - side * 0.5f) * 3.0f, -side * 3.0f);
+		transforms.push_back(glm::translate(glm::mat4(1.0f), position));
+	}
+
+	OpenGLState::viewport(0, 0, 8, 8);
+	OpenGLState::enable(GL_DEPTH_TEST);
+	glm::mat4 projectionMatrix = glm::perspective(glm::radians(70.0f), 1.0f, 0.1f, 1000.0f);
+	UniformBuffers::updateFrame(projectionMatrix, {}, 0.0f);
+
+	GLuint query;
+	glCall(glGenQueries, 1, &query);
+
+	shader.start();
+	double cpuTimes[2] = { 0.0, 0.0 };
+	double gpuTimes[2] = { 0.0, 0.0 };
+	for (int instanced = 0; instanced < 2; instanced++)
+	{
+		// the first pass warms the driver, only the second is timed
+		for (int pass = 0; pass < 2; pass++)
+		{
+			// every pass is a frame of its own, so the ring buffer hands out the same slices as in the main loop
+			glCall(glFinish);
+			RingBuffer::endFrame();
+			UniformBuffers::updateFrame(projectionMatrix, {}, 0.0f);
+			std::size_t drawCalls = RenderStats::current.drawCalls;
+			auto start = std::chrono::high_resolution_clock::now();
+			glCall(glBeginQuery, GL_TIME_ELAPSED, query);
+			if (instanced)
+			{
+				model.drawInstanced(shader, transforms, projectionMatrix);
+			}
+			else
+			{
+				for (const glm::mat4& transform : transforms)
+				{
+					model.draw(shader, transform, projectionMatrix);
+				}
+			}
+			glCall(glEndQuery, GL_TIME_ELAPSED);
+			cpuTimes[instanced] = getMilliseconds(start);
+			drawCalls = RenderStats::current.drawCalls - drawCalls;
+
+			GLuint64 elapsed = 0;
+			glCall(glGetQueryObjectui64v, query, GL_QUERY_RESULT, &elapsed);
+			gpuTimes[instanced] = elapsed / 1000000.0;
+
+			if (pass == 1)
+			{
+				spdlog::info("{:<9} {:d} copies {:6d} draw calls | cpu {:8.2f} ms gpu {:8.2f} ms", instanced ? "instanced" : "single", copies, drawCalls,
+					cpuTimes[instanced], gpuTimes[instanced]);
+			}
+		}
+	}
+	shader.stop();
+	glCall(glDeleteQueries, 1, &query);
+
+	spdlog::info("instancing takes {:.1f}% of the cpu time and {:.1f}% of the gpu time", 100.0 * cpuTimes[1] / std::max(cpuTimes[0], 1e-6),
+		100.0 * gpuTimes[1] / std::max(gpuTimes[0], 1e-6));
+}
+
+void Benchmark::multiDrawIndirect(const std::vector<std::string>& arguments)
+{
+	int placements = arguments.size() > 0 ? std::max(std::stoi(arguments[0]), 1) : 20000;
+	std::vector<std::string> modelPaths(arguments.begin() + std::min(arguments.size(), (std::size_t)1), arguments.end());
+	if (modelPaths.empty())
+	{
+		modelPaths = { "Resources/TestScene/Mesh.obj", "Resources/Crate/crate.obj" };
+	}
+
+	BSDFShader bsdfShader = BSDFShader("Shaders/BSDFShader/bsdfShader.vert", "Shaders/BSDFShader/bsdfShader.frag");
+	ReflectionShader reflectionShader = ReflectionShader("Shaders/ReflectionShader/reflectionShader.vert", "Shaders/ReflectionShader/reflectionShader.frag");
+	RenderQueue queue = RenderQueue(bsdfShader, reflectionShader);
+
+	std::vector<std::unique_ptr<Model>> models;
+	for (const std::string& path : modelPaths)
+	{
+		models.push_back(std::make_unique<Model>(path));
+	}
+	finishTextureStreaming();
+
+	// placements alternate between the models so the sort has to interleave them, instancing is off so every placement is its own draw
+	int side = (int)std::ceil(std::sqrt((double)placements));
+	std::vector<glm::mat4> transforms;
+	for (int i = 0; i < placements; i++)
+	{
+		glm::vec3 position = glm::vec3((i % side - side * 0.5f) * 3.0f, (i / side - side * 0.5f) * 3.0f, -side * 3.0f);
+		transforms.push_back(glm::translate(glm::mat4(1.0f), position));
+	}
+
+	OpenGLState::viewport(0, 0, 8, 8);
+	OpenGLState::enable(GL_DEPTH_TEST);
+	glm::mat4 projectionMatrix = glm::perspective(glm::radians(70.0f), 1.0f, 0.1f, 1000.0f);
+	UniformBuffers::updateFrame(projectionMatrix, {}, 0.0f);
+
+	bool instancing = Config::Models::INSTANCING;
+	bool multiDrawIndirect = Config::Models::MULTI_DRAW_INDIRECT;
+	Config::Models::INSTANCING = false;
+
+	double times[2] = { 0.0, 0.0 };
+	for (int indirect = 0; indirect < 2; indirect++)
+	{
+		Config::Models::MULTI_DRAW_INDIRECT = indirect == 1;
+
+		// the first pass warms the driver, only the second is timed
+		for (int pass = 0; pass < 2; pass++)
+		{
+			// every pass is a frame of its own, so the ring buffer hands out the same slices as in the main loop
+			glCall(glFinish);
+			RingBuffer::endFrame();
+			UniformBuffers::updateFrame(projectionMatrix, {}, 0.0f);
+			FrameStats before = RenderStats::current;
+			auto start = std::chrono::high_resolution_clock::now();
+			queue.begin(projectionMatrix);
+			for (int i = 0; i < placements; i++)
+			{
+				queue.submit(*models[i % models.size()], RenderShader::bsdf, transforms[i]);
+			}
+			queue.flush();
+			times[indirect] = getMilliseconds(start);
+
+			if (pass == 1)
+			{
+				spdlog::info("{:<8} {:d} placements {:6d} draw calls {:6d} commands | cpu {:8.2f} ms {:8.1f} ns per placement", indirect ? "indirect" : "direct",
+					placements, RenderStats::current.drawCalls - before.drawCalls, RenderStats::current.indirectCommands - before.indirectCommands, times[indirect],
+					times[indirect] * 1000000.0 / placements);
+			}
+		}
+	}
+	glCall(glFinish);
+
+	Config::Models::INSTANCING = instancing;
+	Config::Models::MULTI_DRAW_INDIRECT = multiDrawIndirect;
+	spdlog::info("multi draw indirect takes {:.1f}% of the cpu time of a draw call per placement", 100.0 * times[1] / std::max(times[0], 1e-6));
+}
+
+void Benchmark::boundingVolumeHierarchy(const std::vector<std::string>& counts)
+{
+	std::vector<std::size_t> objectCounts;
+	for (const std::string& count : counts)
+	{
+		objectCounts.push_back(std::stoull(count));
+	}
+	if (objectCounts.empty())
+	{
+		objectCounts = { 1000, 10000, 100000, 1000000 };
+	}
+
+	const int QUERIES = 100;
+	std::mt19937 random(1);
+	glm::mat4 viewProjection = glm::perspective(glm::radians(70.0f), 1.0f, 0.1f, 100.0f) * glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	std::array<glm::vec4, 6> frustumPlanes = MeshletBuilder::getFrustumPlanes(viewProjection);
+
+	for (std::size_t objectCount : objectCounts)
+	{
+		// constant density, the world grows with the object count so every query touches a similar number of objects
+		float extent = 10.0f * std::cbrt((float)objectCount);
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::uniform_real_distribution<float> size(0.5f, 2.0f);
+		std::vector<glm::vec3> mins, maxs;
+		for (std::size_t i = 0; i < objectCount; i++)
+		{
+			glm::vec3 center = glm::vec3(position(random), position(random), position(random));
+			glm::vec3 halfSize = glm::vec3(size(random));
+			mins.push_back(center - halfSize);
+			maxs.push_back(center + halfSize);
+		}
+
+		BoundingVolumeHierarchy hierarchy;
+		std::vector<std::int32_t> proxies;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (std::size_t i = 0; i < objectCount; i++)
+		{
+			proxies.push_back(hierarchy.insert(mins[i], maxs[i], (std::uint32_t)i));
+		}
+		double buildTime = getMilliseconds(start);
+
+		// a tenth of the objects move, mostly within their margin
+		std::uniform_real_distribution<float> offset(-0.2f, 0.2f);
+		start = std::chrono::high_resolution_clock::now();
+		for (std::size_t i = 0; i < objectCount; i += 10)
+		{
+			glm::vec3 move = glm::vec3(offset(random), offset(random), offset(random));
+			mins[i] += move;
+			maxs[i] += move;
+			hierarchy.move(proxies[i], mins[i], maxs[i]);
+		}
+		double moveTime = getMilliseconds(start);
+
+		std::vector<std::uint32_t> results;
+		std::size_t frustumResults = 0, sphereResults = 0, rayResults = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < QUERIES; i++)
+		{
+			results.clear();
+			hierarchy.queryFrustum(frustumPlanes, results);
+			frustumResults += results.size();
+		}
+		double frustumTime = getMilliseconds(start) / QUERIES;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < QUERIES; i++)
+		{
+			results.clear();
+			hierarchy.querySphere(glm::vec3(position(random), position(random), position(random)), 20.0f, results);
+			sphereResults += results.size();
+		}
+		double sphereTime = getMilliseconds(start) / QUERIES;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < QUERIES; i++)
+		{
+			results.clear();
+			glm::vec3 direction = glm::normalize(glm::vec3(position(random), position(random), position(random)));
+			hierarchy.queryRay(glm::vec3(position(random), position(random), position(random)), direction, 100.0f, results);
+			rayResults += results.size();
+		}
+		double rayTime = getMilliseconds(start) / QUERIES;
+
+		// the same sphere query by testing every box
+		start = std::chrono::high_resolution_clock::now();
+		std::size_t scanResults = 0;
+		for (int i = 0; i < QUERIES; i++)
+		{
+			glm::vec3 center = glm::vec3(position(random), position(random), position(random));
+			for (std::size_t j = 0; j < objectCount; j++)
+			{
+				glm::vec3 closest = glm::clamp(center, mins[j], maxs[j]) - center;
+				scanResults += glm::dot(closest, closest) <= 400.0f;
+			}
+		}
+		double scanTime = getMilliseconds(start) / QUERIES;
+
+		spdlog::info("{:8d} objects height {:2d} | build {:9.2f} ms move {:8.2f} ms | frustum {:7.3f} ms ({:d}) sphere {:7.4f} ms ({:d}) ray {:7.4f} ms ({:d}) | scan {:8.3f} ms ({:d})",
+			objectCount, hierarchy.getHeight(), buildTime, moveTime, frustumTime, frustumResults / QUERIES, sphereTime, sphereResults / QUERIES, rayTime,
+			rayResults / QUERIES, scanTime, scanResults / QUERIES);
+	}
+}
+
+void Benchmark::occlusion(const std::vector<std::string>& counts)
+{
+	std::vector<std::size_t> objectCounts;
+	for (const std::string& count : counts)
+	{
+		objectCounts.push_back(std::stoull(count));
+	}
+	if (objectCounts.empty())
+	{
+		objectCounts = { 10000 };
+	}
+
+	// rooms of ROOM_SIZE on a side with a doorway in the middle of every wall, the camera stands in the middle room
+	const int ROOMS = 8;
+	const float ROOM_SIZE = 8.0f;
+	const float WALL_HEIGHT = 3.0f;
+	const float DOOR_WIDTH = 1.5f;
+	const int QUERIES = 100;
+
+	std::vector<glm::vec3> cube = { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 1.0f, 1.0f) };
+	std::vector<unsigned int> cubeIndices = { 0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 4, 5, 0, 5, 1, 3, 2, 6, 3, 6, 7, 0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2 };
+
+	OcclusionCuller culler;
+	float extent = ROOMS * ROOM_SIZE * 0.5f;
+	float segment = (ROOM_SIZE - DOOR_WIDTH) * 0.5f;
+	for (int line = 0; line <= ROOMS; line++)
+	{
+		float offset = -extent + line * ROOM_SIZE;
+		for (int room = 0; room < ROOMS; room++)
+		{
+			float start = -extent + room * ROOM_SIZE;
+			for (float part : { start, start + segment + DOOR_WIDTH })
+			{
+				glm::mat4 alongX = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(part, 0.0f, offset - 0.1f)), glm::vec3(segment, WALL_HEIGHT, 0.2f));
+				glm::mat4 alongZ = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(offset - 0.1f, 0.0f, part)), glm::vec3(0.2f, WALL_HEIGHT, segment));
+				culler.addOccluder(cube, cubeIndices, alongX);
+				culler.addOccluder(cube, cubeIndices, alongZ);
+			}
+		}
+	}
+
+	glm::vec3 eye = glm::vec3(ROOM_SIZE * 0.5f, 1.7f, ROOM_SIZE * 0.5f);
+	glm::mat4 viewProjection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 200.0f) *
+		glm::lookAt(eye, eye + glm::vec3(0.3f, -0.1f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	std::array<glm::vec4, 6> frustumPlanes = MeshletBuilder::getFrustumPlanes(viewProjection);
+
+	std::mt19937 random(1);
+	for (std::size_t objectCount : objectCounts)
+	{
+		std::uniform_real_distribution<float> position(-extent + 0.5f, extent - 0.5f);
+		std::uniform_real_distribution<float> size(0.2f, 0.6f);
+		std::vector<glm::vec3> mins, maxs;
+		for (std::size_t i = 0; i < objectCount; i++)
+		{
+			glm::vec3 halfSize = glm::vec3(size(random));
+			glm::vec3 center = glm::vec3(position(random), halfSize.y, position(random));
+			mins.push_back(center - halfSize);
+			maxs.push_back(center + halfSize);
+		}
+
+		// only objects inside the frustum reach the occlusion test, as in submitScene
+		std::vector<std::size_t> inFrustum;
+		auto testFrustum = [&]()
+			{
+				inFrustum.clear();
+				for (std::size_t i = 0; i < objectCount; i++)
+				{
+					bool inside = true;
+					for (const glm::vec4& plane : frustumPlanes)
+					{
+						glm::vec3 corner = glm::vec3(plane.x >= 0.0f ? maxs[i].x : mins[i].x, plane.y >= 0.0f ? maxs[i].y : mins[i].y,
+							plane.z >= 0.0f ? maxs[i].z : mins[i].z);
+						inside = inside && glm::dot(glm::vec3(plane), corner) + plane.w >= 0.0f;
+					}
+					if (inside)
+					{
+						inFrustum.push_back(i);
+					}
+				}
+			};
+		testFrustum();
+
+		double rasterizeTime = 0.0, pyramidTime = 0.0, testTime = 0.0;
+		std::size_t occluded = 0;
+		for (int i = 0; i < QUERIES; i++)
+		{
+			culler.render(viewProjection);
+			rasterizeTime += culler.getTimings().rasterize;
+			pyramidTime += culler.getTimings().pyramid;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			occluded = 0;
+			for (std::size_t object : inFrustum)
+			{
+				occluded += culler.isOccluded(mins[object], maxs[object]);
+			}
+			testTime += getMilliseconds(start);
+		}
+
+		// the worker renders while the frustum test of the frame runs, only the rest of its time is waited for
+		double waitTime = 0.0;
+		for (int i = 0; i < QUERIES; i++)
+		{
+			culler.begin(viewProjection);
+			testFrustum();
+			waitTime += culler.wait();
+		}
+
+		spdlog::info("{:8d} objects {:6d} in frustum {:6d} occluded | {:d} occluder triangles at {:d}x{:d} | rasterize {:7.3f} ms pyramid {:7.3f} ms test {:7.3f} ms | threaded wait {:7.3f} ms",
+			objectCount, inFrustum.size(), occluded, culler.getTriangleCount(), OcclusionCuller::WIDTH, OcclusionCuller::HEIGHT, rasterizeTime / QUERIES,
+			pyramidTime / QUERIES, testTime / QUERIES, waitTime / QUERIES);
+	}
+}
+
+void Benchmark::text(const std::vector<std::string>& arguments)
+{
+	int strings = arguments.size() > 0 ? std::max(std::stoi(arguments[0]), 1) : 200;
+	TextShader shader = TextShader("Shaders/TextShader/textShader.vert", "Shaders/TextShader/textShader.frag");
+
+	// the first run bakes the ascii distance fields, later runs restore them from the asset cache
+	AssetCacheStats cacheBefore = AssetCache::getStats();
+	auto fontStart = std::chrono::high_resolution_clock::now();
+	TextRenderer renderer;
+	double fontTime = getMilliseconds(fontStart);
+	spdlog::info("font      atlas ready in {:.2f} ms, {} | {:d} glyphs rasterized", fontTime,
+		AssetCache::getStats().hits > cacheBefore.hits ? "restored from the baked atlas" : "baked", RenderStats::current.glyphsRasterized);
+
+	// the controls text drawn by the main loop
+	const std::string text = "Controls\n--------------------------------------------------------\nW - Move Forward\nS - Move Backward\nA - Move Left\n"
+		"D - Move Right\nSpace - Move Up\nLShift - Move Down\nESC - Close Window";
+	std::vector<std::string> characters;
+	for (char c : text)
+	{
+		if (c != '\n')
+		{
+			characters.push_back(std::string(1, c));
+		}
+	}
+	std::size_t glyphs = characters.size() * strings;
+
+	OpenGLState::viewport(0, 0, 8, 8);
+	OpenGLState::enable(GL_BLEND);
+	OpenGLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glm::mat4 projectionMatrix = glm::ortho(0.0f, 1280.0f, 0.0f, 720.0f);
+
+	// per glyph and instanced lay the string out on every draw, retained lays it out once into a text object
+	const std::array<const char*, 3> modes = { "per glyph", "instanced", "retained" };
+	TextObject retained;
+	glm::mat4 transformationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(640.0f, 360.0f, 0.0f));
+	double times[3] = { 0.0, 0.0, 0.0 };
+	for (int mode = 0; mode < 3; mode++)
+	{
+		// the first pass warms the driver, only the second is timed
+		for (int pass = 0; pass < 2; pass++)
+		{
+			glCall(glFinish);
+			renderer.endFrame();
+			RingBuffer::endFrame();
+			FrameStats before = RenderStats::current;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < strings; i++)
+			{
+				if (mode == 2)
+				{
+					renderer.updateText(retained, text, glm::vec2(24.0f), glm::vec3(1.0f), Align::center, Origin::center);
+					renderer.drawText(shader, retained, transformationMatrix, glm::mat4(1.0f), projectionMatrix);
+				}
+				else if (mode == 1)
+				{
+					renderer.drawText(shader, text, glm::mat4(1.0f), glm::mat4(1.0f), projectionMatrix, glm::vec2(640.0f, 360.0f), glm::vec2(24.0f),
+						glm::vec3(1.0f), Align::center, Origin::center);
+				}
+				else
+				{
+					for (const std::string& character : characters)
+					{
+						renderer.drawText(shader, character, glm::mat4(1.0f), glm::mat4(1.0f), projectionMatrix, glm::vec2(640.0f, 360.0f), glm::vec2(24.0f),
+							glm::vec3(1.0f), Align::center, Origin::center);
+					}
+				}
+			}
+			glCall(glFinish);
+			times[mode] = getMilliseconds(start);
+
+			if (pass == 1)
+			{
+				spdlog::info("{:<9} {:d} strings {:7d} draw calls {:6d} layouts {:7d} glyphs uploaded | {:8.2f} ms {:10.1f} glyphs per ms", modes[mode], strings,
+					mode == 0 ? glyphs : strings, RenderStats::current.textLayouts - before.textLayouts, RenderStats::current.glyphUploads - before.glyphUploads,
+					times[mode], glyphs / std::max(times[mode], 1e-6));
+			}
+		}
+	}
+
+	// a counter where only the last digits change between frames, as in the stats overlay
+	glCall(glFinish);
+	FrameStats before = RenderStats::current;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < strings; i++)
+	{
+		renderer.updateText(retained, std::format("Frame {:08d}", i), glm::vec2(24.0f), glm::vec3(1.0f), Align::left, Origin::topLeft);
+		renderer.drawText(shader, retained, transformationMatrix, glm::mat4(1.0f), projectionMatrix);
+	}
+	glCall(glFinish);
+	spdlog::info("counter   {:d} strings {:7d} glyphs uploaded of {:d} | {:8.2f} ms", strings, RenderStats::current.glyphUploads - before.glyphUploads,
+		strings * std::string("Frame 00000000").size(), getMilliseconds(start));
+
+	// lines of distinct cjk ideographs, more than the atlas holds, so pages are cleared as the text moves through the range
+	const int LINE_LENGTH = 32;
+	const int ATLAS_FRAMES = 256;
+	glCall(glFinish);
+	before = RenderStats::current;
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < ATLAS_FRAMES; frame++)
+	{
+		std::string line;
+		for (int i = 0; i < LINE_LENGTH; i++)
+		{
+			char32_t codePoint = 0x4E00 + (frame * LINE_LENGTH + i) % 0x5000;
+			line += (char)(0xE0 | (codePoint >> 12));
+			line += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			line += (char)(0x80 | (codePoint & 0x3F));
+		}
+		renderer.drawText(shader, line, glm::mat4(1.0f), glm::mat4(1.0f), projectionMatrix, glm::vec2(640.0f, 360.0f), glm::vec2(24.0f), glm::vec3(1.0f),
+			Align::center, Origin::center);
+		renderer.endFrame();
+		RingBuffer::endFrame();
+	}
+	glCall(glFinish);
+	spdlog::info("atlas     {:d} frames {:7d} glyphs rasterized {:d} atlas uploads {:d} pages evicted | {:8.2f} ms", ATLAS_FRAMES,
+		RenderStats::current.glyphsRasterized - before.glyphsRasterized, RenderStats::current.atlasUploads - before.atlasUploads,
+		RenderStats::current.atlasEvictions - before.atlasEvictions, getMilliseconds(start));
+	OpenGLState::disable(GL_BLEND);
+
+	spdlog::info("one draw per string takes {:.1f}% of the time of one draw per glyph, a retained string {:.1f}%", 100.0 * times[1] / std::max(times[0], 1e-6),
+		100.0 * times[2] / std::max(times[0], 1e-6));
+}
+
+void Benchmark::programs(const std::vector<std::string>& arguments)
+{
+	int runs = arguments.size() > 0 ? std::max(std::stoi(arguments[0]), 1) : 5;
+	bool programBinaries = Config::AssetCache::PROGRAM_BINARIES;
+
+	// every program the main loop creates, cleaned up right away so each run starts from nothing
+	auto createPrograms = []()
+	{
+		BSDFShader bsdfShader = BSDFShader("Shaders/BSDFShader/bsdfShader.vert", "Shaders/BSDFShader/bsdfShader.frag");
+		ReflectionShader reflectionShader = ReflectionShader("Shaders/ReflectionShader/reflectionShader.vert", "Shaders/ReflectionShader/reflectionShader.frag");
+		SkyboxShader skyboxShader = SkyboxShader("Shaders/SkyboxShader/skyboxShader.vert", "Shaders/SkyboxShader/skyboxShader.frag");
+		TextShader textShader = TextShader("Shaders/TextShader/textShader.vert", "Shaders/TextShader/textShader.frag");
+		glCall(glFinish);
+		bsdfShader.cleanUp();
+		reflectionShader.cleanUp();
+		skyboxShader.cleanUp();
+		textShader.cleanUp();
+	};
+
+	// cold compiles with binaries off, then one run to write the binaries before the warm runs read them
+	Config::AssetCache::PROGRAM_BINARIES = false;
+	ProgramCacheStats before = ShaderProgram::getCacheStats();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < runs; i++)
+	{
+		createPrograms();
+	}
+	double coldTime = getMilliseconds(start) / runs;
+	std::size_t programCount = (ShaderProgram::getCacheStats().compiled - before.compiled) / runs;
+
+	Config::AssetCache::PROGRAM_BINARIES = true;
+	createPrograms();
+	before = ShaderProgram::getCacheStats();
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < runs; i++)
+	{
+		createPrograms();
+	}
+	double warmTime = getMilliseconds(start) / runs;
+	std::size_t restored = ShaderProgram::getCacheStats().restored - before.restored;
+	Config::AssetCache::PROGRAM_BINARIES = programBinaries;
+
+	spdlog::info("{:d} programs | compiled {:8.2f} ms | restored {:8.2f} ms ({:d} of {:d} restored)", programCount, coldTime, warmTime, restored,
+		programCount * runs);
+	spdlog::info("restoring takes {:.1f}% of the time of compiling, drivers with their own shader cache narrow the gap", 100.0 * warmTime / std::max(coldTime, 1e-6));
+}
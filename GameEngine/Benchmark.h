@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+// offline measurements, run with "GameEngine --benchmark <name> [arguments]"
+struct Benchmark
+{
+	static bool run(const std::string& name, const std::vector<std::string>& arguments);
+
+	// load time and memory of uncompressed uploads against cooked bcn textures, directories are loaded as cube maps
+	static void textures(const std::vector<std::string>& paths);
+
+	// vertex buffer size, quantization error and vertex bound draw time of float against packed vertices
+	static void vertexFormats(const std::vector<std::string>& paths);
+
+	// cpu time per draw of binding a mesh's textures by uniform name against its precompiled binding table
+	static void materialBindings(const std::vector<std::string>& paths);
+
+	// cpu and gpu time of drawing many copies of a model one draw at a time against one instanced draw per mesh
+	static void instancing(const std::vector<std::string>& arguments);
+
+	// cpu time of flushing many placements through the render queue with a draw call each against multi draw indirect
+	static void multiDrawIndirect(const std::vector<std::string>& arguments);
+
+	// build, move and query times of the scene's bounding volume hierarchy against a linear scan, from 1k to 1M objects by default
+	static void boundingVolumeHierarchy(const std::vector<std::string>& counts);
+
+	// software occlusion of boxes spread over a grid of walled rooms, with the time of each step and on the worker thread, 10k objects by default
+	static void occlusion(const std::vector<std::string>& counts);
+
+	// glyphs per millisecond of drawing strings one glyph per draw, one instanced draw per string and from a retained text object, 200 strings by default,
+	// then text running through more distinct glyphs than the atlas holds
+	static void text(const std::vector<std::string>& arguments);
+
+	// startup time of the engine's shader programs compiled from source against restored from cached program binaries
+	static void programs(const std::vector<std::string>& arguments);
+};
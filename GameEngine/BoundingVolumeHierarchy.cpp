@@ -0,0 +1,414 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <limits>
+
+const std::int32_t BoundingVolumeHierarchy::NULL_NODE = -1;
+const float BoundingVolumeHierarchy::MARGIN = 0.1f;
+
+namespace
+{
+	enum class PlaneSide
+	{
+		outside,
+		intersecting,
+		inside
+	};
+
+	PlaneSide testFrustum(const BvhNode& node, const std::array<glm::vec4, 6>& frustumPlanes)
+	{
+		PlaneSide side = PlaneSide::inside;
+		for (const glm::vec4& plane : frustumPlanes)
+		{
+			// the corner furthest along the normal decides outside, the nearest one decides fully inside
+			glm::vec3 positive = glm::vec3(plane.x >= 0.0f ? node.max.x : node.min.x, plane.y >= 0.0f ? node.max.y : node.min.y, plane.z >= 0.0f ? node.max.z : node.min.z);
+			glm::vec3 negative = glm::vec3(plane.x >= 0.0f ? node.min.x : node.max.x, plane.y >= 0.0f ? node.min.y : node.max.y, plane.z >= 0.0f ? node.min.z : node.max.z);
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+			{
+				return PlaneSide::outside;
+			}
+			if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f)
+			{
+				side = PlaneSide::intersecting;
+			}
+		}
+		return side;
+	}
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+	this->clear();
+}
+
+float BoundingVolumeHierarchy::getSurfaceArea(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+std::int32_t BoundingVolumeHierarchy::allocateNode()
+{
+	if (this->freeList == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		this->nodes.emplace_back();
+		this->nodes.back().parent = BoundingVolumeHierarchy::NULL_NODE;
+		this->nodes.back().height = -1;
+		this->freeList = (std::int32_t)this->nodes.size() - 1;
+	}
+
+	std::int32_t node = this->freeList;
+	this->freeList = this->nodes[node].parent;
+	this->nodes[node].parent = BoundingVolumeHierarchy::NULL_NODE;
+	this->nodes[node].child1 = BoundingVolumeHierarchy::NULL_NODE;
+	this->nodes[node].child2 = BoundingVolumeHierarchy::NULL_NODE;
+	this->nodes[node].height = 0;
+	this->nodes[node].userData = 0;
+	return node;
+}
+
+void BoundingVolumeHierarchy::freeNode(const std::int32_t node)
+{
+	this->nodes[node].parent = this->freeList;
+	this->nodes[node].height = -1;
+	this->freeList = node;
+}
+
+void BoundingVolumeHierarchy::refit(const std::int32_t node)
+{
+	BvhNode& parent = this->nodes[node];
+	const BvhNode& child1 = this->nodes[parent.child1];
+	const BvhNode& child2 = this->nodes[parent.child2];
+	parent.min = glm::min(child1.min, child2.min);
+	parent.max = glm::max(child1.max, child2.max);
+	parent.height = 1 + std::max(child1.height, child2.height);
+}
+
+void BoundingVolumeHierarchy::insertLeaf(const std::int32_t leaf)
+{
+	if (this->root == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		this->root = leaf;
+		this->nodes[leaf].parent = BoundingVolumeHierarchy::NULL_NODE;
+		return;
+	}
+
+	// descend while pushing the leaf further down is cheaper than pairing it with the current node
+	glm::vec3 leafMin = this->nodes[leaf].min;
+	glm::vec3 leafMax = this->nodes[leaf].max;
+	std::int32_t index = this->root;
+	while (this->nodes[index].child1 != BoundingVolumeHierarchy::NULL_NODE)
+	{
+		const BvhNode& node = this->nodes[index];
+		float area = BoundingVolumeHierarchy::getSurfaceArea(node.min, node.max);
+		float combinedArea = BoundingVolumeHierarchy::getSurfaceArea(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+
+		// pairing here creates a parent of the combined size, every ancestor below grows by the difference
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		for (int i = 0; i < 2; i++)
+		{
+			const BvhNode& child = this->nodes[i == 0 ? node.child1 : node.child2];
+			float childArea = BoundingVolumeHierarchy::getSurfaceArea(glm::min(child.min, leafMin), glm::max(child.max, leafMax));
+			bool isLeaf = child.child1 == BoundingVolumeHierarchy::NULL_NODE;
+			childCosts[i] = (isLeaf ? childArea : childArea - BoundingVolumeHierarchy::getSurfaceArea(child.min, child.max)) + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+		{
+			break;
+		}
+		index = childCosts[0] < childCosts[1] ? node.child1 : node.child2;
+	}
+
+	std::int32_t sibling = index;
+	std::int32_t oldParent = this->nodes[sibling].parent;
+	std::int32_t newParent = this->allocateNode();
+	this->nodes[newParent].parent = oldParent;
+	this->nodes[newParent].min = glm::min(leafMin, this->nodes[sibling].min);
+	this->nodes[newParent].max = glm::max(leafMax, this->nodes[sibling].max);
+	this->nodes[newParent].height = this->nodes[sibling].height + 1;
+	this->nodes[newParent].child1 = sibling;
+	this->nodes[newParent].child2 = leaf;
+	this->nodes[sibling].parent = newParent;
+	this->nodes[leaf].parent = newParent;
+
+	if (oldParent == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		this->root = newParent;
+	}
+	else if (this->nodes[oldParent].child1 == sibling)
+	{
+		this->nodes[oldParent].child1 = newParent;
+	}
+	else
+	{
+		this->nodes[oldParent].child2 = newParent;
+	}
+
+	for (index = this->nodes[leaf].parent; index != BoundingVolumeHierarchy::NULL_NODE; index = this->nodes[index].parent)
+	{
+		index = this->balance(index);
+		this->refit(index);
+	}
+}
+
+void BoundingVolumeHierarchy::removeLeaf(const std::int32_t leaf)
+{
+	if (leaf == this->root)
+	{
+		this->root = BoundingVolumeHierarchy::NULL_NODE;
+		return;
+	}
+
+	// the sibling takes the parent's place
+	std::int32_t parent = this->nodes[leaf].parent;
+	std::int32_t grandParent = this->nodes[parent].parent;
+	std::int32_t sibling = this->nodes[parent].child1 == leaf ? this->nodes[parent].child2 : this->nodes[parent].child1;
+
+	this->nodes[sibling].parent = grandParent;
+	this->freeNode(parent);
+	if (grandParent == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		this->root = sibling;
+		return;
+	}
+
+	if (this->nodes[grandParent].child1 == parent)
+	{
+		this->nodes[grandParent].child1 = sibling;
+	}
+	else
+	{
+		this->nodes[grandParent].child2 = sibling;
+	}
+
+	for (std::int32_t index = grandParent; index != BoundingVolumeHierarchy::NULL_NODE; index = this->nodes[index].parent)
+	{
+		index = this->balance(index);
+		this->refit(index);
+	}
+}
+
+std::int32_t BoundingVolumeHierarchy::balance(const std::int32_t iA)
+{
+	BvhNode& a = this->nodes[iA];
+	if (a.child1 == BoundingVolumeHierarchy::NULL_NODE || a.height < 2)
+	{
+		return iA;
+	}
+
+	std::int32_t iB = a.child1;
+	std::int32_t iC = a.child2;
+	BvhNode& b = this->nodes[iB];
+	BvhNode& c = this->nodes[iC];
+	std::int32_t difference = c.height - b.height;
+	if (difference >= -1 && difference <= 1)
+	{
+		return iA;
+	}
+
+	// the taller child takes a's place, a keeps the other child and the shorter of the taller child's children
+	std::int32_t iUp = difference > 1 ? iC : iB;
+	std::int32_t iStay = difference > 1 ? iB : iC;
+	BvhNode& up = this->nodes[iUp];
+	std::int32_t iF = up.child1;
+	std::int32_t iG = up.child2;
+	if (this->nodes[iF].height < this->nodes[iG].height)
+	{
+		std::swap(iF, iG);
+	}
+
+	up.child1 = iA;
+	up.parent = a.parent;
+	a.parent = iUp;
+	if (up.parent == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		this->root = iUp;
+	}
+	else if (this->nodes[up.parent].child1 == iA)
+	{
+		this->nodes[up.parent].child1 = iUp;
+	}
+	else
+	{
+		this->nodes[up.parent].child2 = iUp;
+	}
+
+	// f is the taller grandchild and stays under the rotated node, g moves under a
+	up.child2 = iF;
+	a.child1 = iStay;
+	a.child2 = iG;
+	this->nodes[iG].parent = iA;
+
+	this->refit(iA);
+	this->refit(iUp);
+	return iUp;
+}
+
+std::int32_t BoundingVolumeHierarchy::insert(const glm::vec3& min, const glm::vec3& max, const std::uint32_t userData)
+{
+	std::int32_t proxy = this->allocateNode();
+	this->nodes[proxy].min = min - glm::vec3(BoundingVolumeHierarchy::MARGIN);
+	this->nodes[proxy].max = max + glm::vec3(BoundingVolumeHierarchy::MARGIN);
+	this->nodes[proxy].userData = userData;
+	this->insertLeaf(proxy);
+	this->leafCount++;
+	return proxy;
+}
+
+void BoundingVolumeHierarchy::remove(const std::int32_t proxy)
+{
+	this->removeLeaf(proxy);
+	this->freeNode(proxy);
+	this->leafCount--;
+}
+
+bool BoundingVolumeHierarchy::move(const std::int32_t proxy, const glm::vec3& min, const glm::vec3& max)
+{
+	BvhNode& node = this->nodes[proxy];
+	if (glm::all(glm::lessThanEqual(node.min, min)) && glm::all(glm::greaterThanEqual(node.max, max)))
+	{
+		return false;
+	}
+
+	this->removeLeaf(proxy);
+	this->nodes[proxy].min = min - glm::vec3(BoundingVolumeHierarchy::MARGIN);
+	this->nodes[proxy].max = max + glm::vec3(BoundingVolumeHierarchy::MARGIN);
+	this->insertLeaf(proxy);
+	return true;
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+	this->nodes.clear();
+	this->root = BoundingVolumeHierarchy::NULL_NODE;
+	this->freeList = BoundingVolumeHierarchy::NULL_NODE;
+	this->leafCount = 0;
+}
+
+void BoundingVolumeHierarchy::collectLeaves(const std::int32_t node, std::vector<std::uint32_t>& results)
+{
+	std::size_t base = this->stack.size();
+	this->stack.push_back(node);
+	while (this->stack.size() > base)
+	{
+		const BvhNode& current = this->nodes[this->stack.back()];
+		this->stack.pop_back();
+		if (current.child1 == BoundingVolumeHierarchy::NULL_NODE)
+		{
+			results.push_back(current.userData);
+			continue;
+		}
+		this->stack.push_back(current.child1);
+		this->stack.push_back(current.child2);
+	}
+}
+
+void BoundingVolumeHierarchy::queryFrustum(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<std::uint32_t>& results)
+{
+	if (this->root == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		return;
+	}
+
+	this->stack.clear();
+	this->stack.push_back(this->root);
+	while (!this->stack.empty())
+	{
+		std::int32_t index = this->stack.back();
+		this->stack.pop_back();
+
+		// a subtree fully inside needs no more plane tests
+		const BvhNode& node = this->nodes[index];
+		PlaneSide side = testFrustum(node, frustumPlanes);
+		if (side == PlaneSide::outside)
+		{
+			continue;
+		}
+		if (side == PlaneSide::inside || node.child1 == BoundingVolumeHierarchy::NULL_NODE)
+		{
+			this->collectLeaves(index, results);
+			continue;
+		}
+		this->stack.push_back(node.child1);
+		this->stack.push_back(node.child2);
+	}
+}
+
+void BoundingVolumeHierarchy::querySphere(const glm::vec3& center, const float radius, std::vector<std::uint32_t>& results)
+{
+	if (this->root == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		return;
+	}
+
+	this->stack.clear();
+	this->stack.push_back(this->root);
+	while (!this->stack.empty())
+	{
+		const BvhNode& node = this->nodes[this->stack.back()];
+		this->stack.pop_back();
+
+		glm::vec3 offset = glm::clamp(center, node.min, node.max) - center;
+		if (glm::dot(offset, offset) > radius * radius)
+		{
+			continue;
+		}
+		if (node.child1 == BoundingVolumeHierarchy::NULL_NODE)
+		{
+			results.push_back(node.userData);
+			continue;
+		}
+		this->stack.push_back(node.child1);
+		this->stack.push_back(node.child2);
+	}
+}
+
+void BoundingVolumeHierarchy::queryRay(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, std::vector<std::uint32_t>& results)
+{
+	if (this->root == BoundingVolumeHierarchy::NULL_NODE)
+	{
+		return;
+	}
+
+	// slab test, a zero component gives infinities that still compare correctly
+	glm::vec3 inverseDirection = 1.0f / direction;
+	this->stack.clear();
+	this->stack.push_back(this->root);
+	while (!this->stack.empty())
+	{
+		const BvhNode& node = this->nodes[this->stack.back()];
+		this->stack.pop_back();
+
+		glm::vec3 t1 = (node.min - origin) * inverseDirection;
+		glm::vec3 t2 = (node.max - origin) * inverseDirection;
+		glm::vec3 closest = glm::min(t1, t2);
+		glm::vec3 furthest = glm::max(t1, t2);
+		float enter = std::max({ closest.x, closest.y, closest.z, 0.0f });
+		float exit = std::min({ furthest.x, furthest.y, furthest.z, maxDistance });
+		if (enter > exit)
+		{
+			continue;
+		}
+		if (node.child1 == BoundingVolumeHierarchy::NULL_NODE)
+		{
+			results.push_back(node.userData);
+			continue;
+		}
+		this->stack.push_back(node.child1);
+		this->stack.push_back(node.child2);
+	}
+}
+
+std::size_t BoundingVolumeHierarchy::size() const
+{
+	return this->leafCount;
+}
+
+std::int32_t BoundingVolumeHierarchy::getHeight() const
+{
+	return this->root == BoundingVolumeHierarchy::NULL_NODE ? 0 : this->nodes[this->root].height;
+}
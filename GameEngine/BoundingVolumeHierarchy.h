@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <array>
+
+#include <glm/glm.hpp>
+
+// 48 bytes with the box first, so the test made at each traversal step reads the start of one node
+struct alignas(16) BvhNode
+{
+	glm::vec3 min;
+	std::int32_t parent; // next free node while the node is on the free list
+	glm::vec3 max;
+	std::int32_t height; // 0 for leaves, -1 for free nodes
+	std::int32_t child1;
+	std::int32_t child2;
+	std::uint32_t userData;
+};
+
+// dynamic aabb tree over the renderables of a scene, leaves hold a box fattened by MARGIN so small moves do not touch the tree
+//
+// nodes live in one array addressed by index, inserts pick the sibling with the smallest surface area increase and
+// rotations keep the heights of siblings within one, as in Box2D's b2DynamicTree
+class BoundingVolumeHierarchy
+{
+private:
+	std::vector<BvhNode> nodes;
+	std::int32_t root;
+	std::int32_t freeList;
+	std::size_t leafCount;
+
+	// traversal stack, kept between queries to avoid reallocating
+	std::vector<std::int32_t> stack;
+
+	std::int32_t allocateNode();
+
+	void freeNode(const std::int32_t node);
+
+	void insertLeaf(const std::int32_t leaf);
+
+	void removeLeaf(const std::int32_t leaf);
+
+	// rotates the taller grandchild up when the children of a node differ in height by more than one, returns the node now at its place
+	std::int32_t balance(const std::int32_t node);
+
+	void refit(const std::int32_t node);
+
+	void collectLeaves(const std::int32_t node, std::vector<std::uint32_t>& results);
+
+	static float getSurfaceArea(const glm::vec3& min, const glm::vec3& max);
+
+public:
+	static const std::int32_t NULL_NODE;
+	static const float MARGIN;
+
+	BoundingVolumeHierarchy();
+
+	// returns the proxy used to move and remove the leaf
+	std::int32_t insert(const glm::vec3& min, const glm::vec3& max, const std::uint32_t userData);
+
+	void remove(const std::int32_t proxy);
+
+	// the leaf is only reinserted when the box leaves its fattened box, returns whether the tree changed
+	bool move(const std::int32_t proxy, const glm::vec3& min, const glm::vec3& max);
+
+	void clear();
+
+	// queries test the fattened leaf boxes, so results are conservative by up to MARGIN
+	//
+	// planes with normalized normals pointing inside, as from MeshletBuilder::getFrustumPlanes
+	void queryFrustum(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<std::uint32_t>& results);
+
+	void querySphere(const glm::vec3& center, const float radius, std::vector<std::uint32_t>& results);
+
+	// leaves whose box the ray enters before maxDistance, measured in lengths of the direction
+	void queryRay(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, std::vector<std::uint32_t>& results);
+
+	std::size_t size() const;
+
+	// longest path from the root to a leaf, 0 for an empty tree
+	std::int32_t getHeight() const;
+};
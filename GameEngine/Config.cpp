@@ -39,6 +39,48 @@ void Config::loadConfigs(const std::string& filename)
 	Config::Camera::PITCH_MIN = reader.GetFloat("Camera", "PitchMin", 0.0f);
 
 	Config::Camera::PITCH_MAX = reader.GetFloat("Camera", "PitchMax", 0.0f);
+
+	Config::Textures::STREAMING = reader.GetBoolean("Textures", "Streaming", false);
+
+	Config::Textures::STREAMING_THREADS = reader.GetInteger("Textures", "StreamingThreads", 0);
+
+	Config::Textures::UPLOAD_BUDGET = reader.GetInteger("Textures", "UploadBudget", 0);
+
+	Config::Textures::STAGING_BUFFER_SIZE = reader.GetInteger("Textures", "StagingBufferSize", 0);
+
+	Config::Textures::STAGING_BUFFER_COUNT = reader.GetInteger("Textures", "StagingBufferCount", 0);
+
+	Config::Textures::COMPRESSION = reader.GetBoolean("Textures", "Compression", false);
+
+	Config::Textures::HIGH_QUALITY_COMPRESSION = reader.GetBoolean("Textures", "HighQualityCompression", false);
+
+	Config::Models::PACKED_VERTICES = reader.GetBoolean("Models", "PackedVertices", false);
+
+	Config::Models::OPTIMIZE_MESHES = reader.GetBoolean("Models", "OptimizeMeshes", false);
+
+	Config::Models::LOD_COUNT = reader.GetInteger("Models", "LodCount", 1);
+
+	Config::Models::LOD_ERROR_THRESHOLD = reader.GetFloat("Models", "LodErrorThreshold", 0.001f);
+
+	Config::Models::LOD_HYSTERESIS = reader.GetFloat("Models", "LodHysteresis", 0.25f);
+
+	Config::Models::FRUSTUM_CULLING = reader.GetBoolean("Models", "FrustumCulling", false);
+
+	Config::Models::CLUSTER_CULLING = reader.GetBoolean("Models", "ClusterCulling", false);
+
+	Config::Models::INSTANCING = reader.GetBoolean("Models", "Instancing", false);
+
+	Config::Models::MULTI_DRAW_INDIRECT = reader.GetBoolean("Models", "MultiDrawIndirect", false);
+
+	Config::Models::OCCLUSION_CULLING = reader.GetBoolean("Models", "OcclusionCulling", false);
+
+	Config::AssetCache::DIRECTORY = reader.Get("AssetCache", "Directory", "Cache");
+
+	Config::AssetCache::PROGRAM_BINARIES = reader.GetBoolean("AssetCache", "ProgramBinaries", false);
+
+	Config::Audio::STREAM_BUFFER_SIZE = reader.GetInteger("Audio", "StreamBufferSize", 32768);
+
+	Config::Audio::STREAM_BUFFER_COUNT = reader.GetInteger("Audio", "StreamBufferCount", 4);
 }
 
 std::string Config::Display::TITLE;
@@ -58,3 +100,32 @@ float Config::Camera::LOOK_SPEED;
 
 float Config::Camera::PITCH_MIN;
 float Config::Camera::PITCH_MAX;
+
+bool Config::Textures::STREAMING;
+int Config::Textures::STREAMING_THREADS;
+
+int Config::Textures::UPLOAD_BUDGET;
+int Config::Textures::STAGING_BUFFER_SIZE;
+int Config::Textures::STAGING_BUFFER_COUNT;
+
+bool Config::Textures::COMPRESSION;
+bool Config::Textures::HIGH_QUALITY_COMPRESSION;
+
+bool Config::Models::PACKED_VERTICES;
+bool Config::Models::OPTIMIZE_MESHES;
+
+int Config::Models::LOD_COUNT;
+float Config::Models::LOD_ERROR_THRESHOLD;
+float Config::Models::LOD_HYSTERESIS;
+
+bool Config::Models::FRUSTUM_CULLING;
+bool Config::Models::CLUSTER_CULLING;
+bool Config::Models::INSTANCING;
+bool Config::Models::MULTI_DRAW_INDIRECT;
+bool Config::Models::OCCLUSION_CULLING;
+
+std::string Config::AssetCache::DIRECTORY;
+bool Config::AssetCache::PROGRAM_BINARIES;
+
+int Config::Audio::STREAM_BUFFER_SIZE;
+int Config::Audio::STREAM_BUFFER_COUNT;
@@ -28,4 +28,45 @@ struct Config
 		static float PITCH_MIN;
 		static float PITCH_MAX;
 	};
+
+	struct Textures
+	{
+		static bool STREAMING;
+		static int STREAMING_THREADS;
+
+		static int UPLOAD_BUDGET;
+		static int STAGING_BUFFER_SIZE;
+		static int STAGING_BUFFER_COUNT;
+
+		static bool COMPRESSION;
+		static bool HIGH_QUALITY_COMPRESSION;
+	};
+
+	struct Models
+	{
+		static bool PACKED_VERTICES;
+		static bool OPTIMIZE_MESHES;
+
+		static int LOD_COUNT;
+		static float LOD_ERROR_THRESHOLD;
+		static float LOD_HYSTERESIS;
+
+		static bool FRUSTUM_CULLING;
+		static bool CLUSTER_CULLING;
+		static bool INSTANCING;
+		static bool MULTI_DRAW_INDIRECT;
+		static bool OCCLUSION_CULLING;
+	};
+
+	struct AssetCache
+	{
+		static std::string DIRECTORY;
+		static bool PROGRAM_BINARIES;
+	};
+
+	struct Audio
+	{
+		static int STREAM_BUFFER_SIZE;
+		static int STREAM_BUFFER_COUNT;
+	};
 };
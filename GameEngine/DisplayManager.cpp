@@ -4,6 +4,7 @@
 #include <spdlog/spdlog.h>
 
 #include "OpenGLFunctions.h"
+#include "OpenGLState.h"
 #include "Config.h"
 
 // -------------------------------------
@@ -31,13 +32,14 @@ Display::Display(const unsigned int width, const unsigned int height, const std:
 	{
 		spdlog::error("Failed to load glad");
 	}
+	OpenGLState::invalidate();
 
-	glCall(glViewport, 0, 0, this->resolution.x, this->resolution.y);
+	OpenGLState::viewport(0, 0, this->resolution.x, this->resolution.y);
 	glfwSetFramebufferSizeCallback(window, DisplayManager::framebuffer_size_callback);
 
-	glCall(glEnable, GL_CULL_FACE);
+	OpenGLState::enable(GL_CULL_FACE);
 	glCall(glCullFace, GL_BACK);
-	glCall(glEnable, GL_DEPTH_TEST);
+	OpenGLState::enable(GL_DEPTH_TEST);
 
 	this->window = window;
 
@@ -136,7 +138,7 @@ void DisplayManager::framebuffer_size_callback(GLFWwindow* window, int width, in
 	if (DisplayManager::displays.find(window) != DisplayManager::displays.end())
 	{
 		Display* display = DisplayManager::displays.at(window);
-		glCall(glViewport, 0, 0, width, height); // <-------------- Separate into window start functions
+		OpenGLState::viewport(0, 0, width, height); // <-------------- Separate into window start functions
 		display->setResolution(width, height);
 	}
 	else
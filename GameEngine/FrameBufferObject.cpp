@@ -4,14 +4,15 @@
 
 #include "OpenGLFunctions.h"
 #include "DisplayManager.h"
+#include "OpenGLState.h"
 
 FrameBufferObject::FrameBufferObject()
 {
 	glCall(glGenFramebuffers, 1, &this->fbo);
-	glCall(glBindFramebuffer, GL_FRAMEBUFFER, this->fbo);
+	OpenGLState::bindFramebuffer(GL_FRAMEBUFFER, this->fbo);
 
 	glCall(glGenTextures, 1, &this->textureColorID);
-	glCall(glBindTexture, GL_TEXTURE_2D, this->textureColorID);
+	OpenGLState::bindTexture(GL_TEXTURE_2D, this->textureColorID);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1024, 1024, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL); // Currently Incompatible With glCall, Needs Fixed
 	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -27,28 +28,28 @@ FrameBufferObject::FrameBufferObject()
 		spdlog::error("Framebuffer incomplete");
 	}
 
-	glCall(glBindFramebuffer, GL_FRAMEBUFFER, 0);
+	OpenGLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 FrameBufferObject::~FrameBufferObject() {}
 
 void FrameBufferObject::bind()
 {
-	glCall(glBindFramebuffer, GL_FRAMEBUFFER, this->fbo);
+	OpenGLState::bindFramebuffer(GL_FRAMEBUFFER, this->fbo);
 	glCall(glClearColor, 0.0f, 1.0f, 1.0f, 1.0f);
 	glCall(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glCall(glViewport, 0, 0, 1024, 1024);
+	OpenGLState::viewport(0, 0, 1024, 1024);
 }
 
 void FrameBufferObject::unbind(glm::ivec2 resolution)
 {
-	glCall(glBindFramebuffer, GL_FRAMEBUFFER, 0);
-	glCall(glViewport, 0, 0, resolution.x, resolution.y);
+	OpenGLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+	OpenGLState::viewport(0, 0, resolution.x, resolution.y);
 }
 
 void FrameBufferObject::destroy()
 {
-	glCall(glDeleteFramebuffers, 1, &this->fbo);
-	glCall(glDeleteTextures, 1, &this->textureColorID);
+	OpenGLState::deleteFramebuffers(1, &this->fbo);
+	OpenGLState::deleteTextures(1, &this->textureColorID);
 	glCall(glDeleteRenderbuffers, 1, &this->rbo);
 }
\ No newline at end of file
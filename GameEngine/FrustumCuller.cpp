@@ -0,0 +1,106 @@
+#include "FrustumCuller.h"
+
+#include <xmmintrin.h>
+
+#include <algorithm>
+
+WorldBounds FrustumCuller::transformBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& sphereCenter, const float sphereRadius,
+	const glm::mat4& transformationMatrix)
+{
+	// the extent of the transformed box along each axis is the absolute matrix applied to the local extent
+	glm::mat3 rotationScale = glm::mat3(transformationMatrix);
+	glm::mat3 absolute = glm::mat3(glm::abs(rotationScale[0]), glm::abs(rotationScale[1]), glm::abs(rotationScale[2]));
+	glm::vec3 center = glm::vec3(transformationMatrix * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+	glm::vec3 extent = absolute * ((boundsMax - boundsMin) * 0.5f);
+
+	float scale = std::max({ glm::length(rotationScale[0]), glm::length(rotationScale[1]), glm::length(rotationScale[2]) });
+
+	WorldBounds bounds;
+	bounds.min = center - extent;
+	bounds.max = center + extent;
+	bounds.center = glm::vec3(transformationMatrix * glm::vec4(sphereCenter, 1.0f));
+	bounds.radius = sphereRadius * scale;
+	return bounds;
+}
+
+void FrustumCuller::clear()
+{
+	this->count = 0;
+	for (std::vector<float>* values : { &this->centerX, &this->centerY, &this->centerZ, &this->radius,
+		&this->minX, &this->minY, &this->minZ, &this->maxX, &this->maxY, &this->maxZ })
+	{
+		values->clear();
+	}
+}
+
+std::size_t FrustumCuller::add(const WorldBounds& bounds)
+{
+	this->centerX.push_back(bounds.center.x);
+	this->centerY.push_back(bounds.center.y);
+	this->centerZ.push_back(bounds.center.z);
+	this->radius.push_back(bounds.radius);
+	this->minX.push_back(bounds.min.x);
+	this->minY.push_back(bounds.min.y);
+	this->minZ.push_back(bounds.min.z);
+	this->maxX.push_back(bounds.max.x);
+	this->maxY.push_back(bounds.max.y);
+	this->maxZ.push_back(bounds.max.z);
+	return this->count++;
+}
+
+std::size_t FrustumCuller::size() const
+{
+	return this->count;
+}
+
+void FrustumCuller::cull(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<std::uint8_t>& visible)
+{
+	// padded to whole groups of four, the padding's results are never read
+	std::size_t padded = (this->count + 3) & ~(std::size_t)3;
+	for (std::vector<float>* values : { &this->centerX, &this->centerY, &this->centerZ, &this->radius,
+		&this->minX, &this->minY, &this->minZ, &this->maxX, &this->maxY, &this->maxZ })
+	{
+		values->resize(padded, 0.0f);
+	}
+	visible.resize(this->count);
+
+	// the box corner furthest along a plane's normal only depends on the signs of the normal, so it is picked once per plane
+	std::array<std::array<const float*, 3>, 6> corners;
+	std::array<std::array<__m128, 4>, 6> planes;
+	for (std::size_t p = 0; p < frustumPlanes.size(); p++)
+	{
+		const glm::vec4& plane = frustumPlanes[p];
+		corners[p] = { plane.x >= 0.0f ? this->maxX.data() : this->minX.data(), plane.y >= 0.0f ? this->maxY.data() : this->minY.data(),
+			plane.z >= 0.0f ? this->maxZ.data() : this->minZ.data() };
+		planes[p] = { _mm_set1_ps(plane.x), _mm_set1_ps(plane.y), _mm_set1_ps(plane.z), _mm_set1_ps(plane.w) };
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for (std::size_t i = 0; i < padded; i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(this->centerX.data() + i);
+		__m128 centerY = _mm_loadu_ps(this->centerY.data() + i);
+		__m128 centerZ = _mm_loadu_ps(this->centerZ.data() + i);
+		__m128 radius = _mm_loadu_ps(this->radius.data() + i);
+
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (std::size_t p = 0; p < planes.size(); p++)
+		{
+			const std::array<__m128, 4>& plane = planes[p];
+
+			__m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[0], centerX), _mm_mul_ps(plane[1], centerY)),
+				_mm_add_ps(_mm_mul_ps(plane[2], centerZ), plane[3]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(sphereDistance, radius), zero));
+
+			__m128 boxDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[0], _mm_loadu_ps(corners[p][0] + i)), _mm_mul_ps(plane[1], _mm_loadu_ps(corners[p][1] + i))),
+				_mm_add_ps(_mm_mul_ps(plane[2], _mm_loadu_ps(corners[p][2] + i)), plane[3]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(boxDistance, zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (std::size_t k = 0; k < 4 && i + k < this->count; k++)
+		{
+			visible[i + k] = (std::uint8_t)((mask >> k) & 1);
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <array>
+
+#include <glm/glm.hpp>
+
+// world space box and sphere of one mesh of a placement
+struct WorldBounds
+{
+	glm::vec3 min;
+	glm::vec3 max;
+	glm::vec3 center;
+	float radius;
+};
+
+// bounds of every mesh of a placement and the box around all of them, recomputed only when the placement's transform changes
+struct PlacementBounds
+{
+	glm::mat4 transform = glm::mat4(0.0f);
+	std::vector<WorldBounds> meshes;
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+};
+
+// bounds kept as structure of arrays so one sse instruction tests four of them against a plane
+//
+// a mesh is visible when both its sphere and its box reach the inside of every plane, both tests are conservative
+class FrustumCuller
+{
+private:
+	std::size_t count = 0;
+	std::vector<float> centerX, centerY, centerZ, radius;
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+public:
+	// box from transforming the corners of a local box, sphere scaled by the largest axis of the transform
+	static WorldBounds transformBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& sphereCenter, const float sphereRadius,
+		const glm::mat4& transformationMatrix);
+
+	void clear();
+
+	// returns the index the result of the bounds is written to by cull
+	std::size_t add(const WorldBounds& bounds);
+
+	std::size_t size() const;
+
+	// planes with normalized normals pointing inside as from MeshletBuilder::getFrustumPlanes, visible[i] is 1 when bounds i are not culled
+	void cull(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<std::uint8_t>& visible);
+};
@@ -0,0 +1,137 @@
+#include "GeometryArena.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#include "OpenGLFunctions.h"
+#include "OpenGLState.h"
+#include "Loader.h"
+#include "Vertex.h"
+
+std::vector<GeometryArena::Pool> GeometryArena::pools;
+
+const std::size_t GeometryArena::INITIAL_VERTICES = 1 << 16;
+const std::size_t GeometryArena::INITIAL_INDICES = 1 << 18;
+
+unsigned int GeometryArena::getPool(const bool packed, const GLenum indexType)
+{
+	for (unsigned int i = 0; i < GeometryArena::pools.size(); i++)
+	{
+		if (GeometryArena::pools[i].packed == packed && GeometryArena::pools[i].indexType == indexType)
+		{
+			return i;
+		}
+	}
+
+	Pool pool;
+	pool.packed = packed;
+	pool.indexType = indexType;
+	glCall(glGenVertexArrays, 1, &pool.vao);
+	GeometryArena::pools.push_back(pool);
+	return (unsigned int)GeometryArena::pools.size() - 1;
+}
+
+void GeometryArena::reserve(GLuint& buffer, std::size_t& capacity, const std::size_t used, const std::size_t required, const std::size_t elementSize)
+{
+	if (buffer != 0 && required <= capacity)
+	{
+		return;
+	}
+
+	std::size_t newCapacity = std::max(capacity * 2, required);
+	GLuint newBuffer;
+	glCall(glGenBuffers, 1, &newBuffer);
+	OpenGLState::bindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glCall(glBufferData, GL_COPY_WRITE_BUFFER, newCapacity * elementSize, nullptr, GL_STATIC_DRAW);
+	if (buffer != 0)
+	{
+		OpenGLState::bindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCall(glCopyBufferSubData, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used * elementSize);
+		OpenGLState::deleteBuffers(1, &buffer);
+		spdlog::debug("Grew geometry arena buffer to {} elements", newCapacity);
+	}
+	buffer = newBuffer;
+	capacity = newCapacity;
+}
+
+void GeometryArena::setupVertexArray(const Pool& pool)
+{
+	// attribute pointers capture the array buffer, so they are set again whenever the pool's buffers are replaced
+	OpenGLState::bindVertexArray(pool.vao);
+	OpenGLState::bindBuffer(GL_ARRAY_BUFFER, pool.vbo);
+	OpenGLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.ebo);
+
+	if (pool.packed)
+	{
+		// the bitangent attribute is left disabled, shaders rebuild it from the normal, tangent and the sign in position.w
+		Loader::createAttibutePointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+		Loader::createAttibutePointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+		Loader::createAttibutePointer(2, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+		Loader::createAttibutePointer(3, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
+		return;
+	}
+
+	Loader::createAttibutePointer(0, 3, sizeof(Vertex), (void*)0);
+	Loader::createAttibutePointer(1, 2, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+	Loader::createAttibutePointer(2, 3, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+	Loader::createAttibutePointer(3, 3, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+	Loader::createAttibutePointer(4, 3, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+}
+
+GeometryAllocation GeometryArena::allocate(const bool packed, const GLenum indexType, const void* vertices, const std::size_t vertexCount,
+	const void* indices, const std::size_t indexCount)
+{
+	GeometryAllocation allocation;
+	allocation.pool = GeometryArena::getPool(packed, indexType);
+
+	Pool& pool = GeometryArena::pools[allocation.pool];
+	std::size_t vertexSize = packed ? sizeof(PackedVertex) : sizeof(Vertex);
+	std::size_t indexSize = GeometryArena::getIndexSize(allocation.pool);
+
+	GLuint vbo = pool.vbo, ebo = pool.ebo;
+	GeometryArena::reserve(pool.vbo, pool.vertexCapacity, pool.vertexCount, std::max(pool.vertexCount + vertexCount, GeometryArena::INITIAL_VERTICES), vertexSize);
+	GeometryArena::reserve(pool.ebo, pool.indexCapacity, pool.indexCount, std::max(pool.indexCount + indexCount, GeometryArena::INITIAL_INDICES), indexSize);
+	if (pool.vbo != vbo || pool.ebo != ebo)
+	{
+		GeometryArena::setupVertexArray(pool);
+	}
+
+	allocation.baseVertex = (std::uint32_t)pool.vertexCount;
+	allocation.firstIndex = (std::uint32_t)pool.indexCount;
+
+	OpenGLState::bindBuffer(GL_COPY_WRITE_BUFFER, pool.vbo);
+	glCall(glBufferSubData, GL_COPY_WRITE_BUFFER, pool.vertexCount * vertexSize, vertexCount * vertexSize, vertices);
+	OpenGLState::bindBuffer(GL_COPY_WRITE_BUFFER, pool.ebo);
+	glCall(glBufferSubData, GL_COPY_WRITE_BUFFER, pool.indexCount * indexSize, indexCount * indexSize, indices);
+
+	pool.vertexCount += vertexCount;
+	pool.indexCount += indexCount;
+	return allocation;
+}
+
+GLuint GeometryArena::getVertexArray(const unsigned int pool)
+{
+	return GeometryArena::pools[pool].vao;
+}
+
+GLenum GeometryArena::getIndexType(const unsigned int pool)
+{
+	return GeometryArena::pools[pool].indexType;
+}
+
+std::size_t GeometryArena::getIndexSize(const unsigned int pool)
+{
+	return GeometryArena::pools[pool].indexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+}
+
+void GeometryArena::destroy()
+{
+	for (Pool& pool : GeometryArena::pools)
+	{
+		OpenGLState::deleteVertexArrays(1, &pool.vao);
+		OpenGLState::deleteBuffers(1, &pool.vbo);
+		OpenGLState::deleteBuffers(1, &pool.ebo);
+	}
+	GeometryArena::pools.clear();
+}
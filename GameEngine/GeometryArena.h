@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+// where a mesh lives in the arena, indices stay relative to the mesh and are offset by baseVertex when drawn
+struct GeometryAllocation
+{
+	unsigned int pool = 0;
+	std::uint32_t baseVertex = 0;
+	std::uint32_t firstIndex = 0;
+};
+
+// vertices and indices of every mesh suballocated from a few large buffers, one pool and vertex array per vertex format and index width
+//
+// pools only grow, a full buffer is reallocated at twice the size and its contents copied on the gpu
+struct GeometryArena
+{
+private:
+	struct Pool
+	{
+		bool packed;
+		GLenum indexType;
+		GLuint vao = 0;
+		GLuint vbo = 0;
+		GLuint ebo = 0;
+		std::size_t vertexCapacity = 0;
+		std::size_t vertexCount = 0;
+		std::size_t indexCapacity = 0;
+		std::size_t indexCount = 0;
+	};
+
+	static std::vector<Pool> pools;
+
+	static unsigned int getPool(const bool packed, const GLenum indexType);
+
+	static void reserve(GLuint& buffer, std::size_t& capacity, const std::size_t used, const std::size_t required, const std::size_t elementSize);
+
+	static void setupVertexArray(const Pool& pool);
+
+public:
+	static const std::size_t INITIAL_VERTICES;
+	static const std::size_t INITIAL_INDICES;
+
+	// vertices are PackedVertex when packed and Vertex otherwise, indices are 16 or 32 bit as given by indexType
+	static GeometryAllocation allocate(const bool packed, const GLenum indexType, const void* vertices, const std::size_t vertexCount,
+		const void* indices, const std::size_t indexCount);
+
+	static GLuint getVertexArray(const unsigned int pool);
+
+	static GLenum getIndexType(const unsigned int pool);
+
+	static std::size_t getIndexSize(const unsigned int pool);
+
+	static void destroy();
+};
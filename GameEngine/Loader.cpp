@@ -1,39 +1,237 @@
 #include "Loader.h"
 
 #include "stb_image.h"
-#include <rapidjson/istreamwrapper.h>
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <iterator>
 #include <fstream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
 
+#include "TextureStreamer.h"
+#include "TextureCache.h"
 #include "OpenGLFunctions.h"
 #include "OpenALFunctions.h"
+#include "OpenGLState.h"
+#include "Config.h"
+#include "Scene.h"
+#include "Maths.h"
 
-std::map<std::string, Sound> Loader::sounds;
 std::map<std::string, Texture> Loader::textures;
 std::vector<GLuint> Loader::vaos;
 std::vector<GLuint> Loader::vbos;
 std::vector<GLuint> Loader::ebos;
 
-void Loader::loadSceneJSON(const std::string& filename)
+namespace
 {
-	spdlog::debug("Loaded scene json '{}'", filename);
-	std::ifstream jsonFile(filename);
-	rapidjson::IStreamWrapper jsonFileWrapped(jsonFile);
+	double getMilliseconds(const std::chrono::high_resolution_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	float getFloat(const rapidjson::Value& object, const char* name, const float fallback)
+	{
+		rapidjson::Value::ConstMemberIterator member = object.FindMember(name);
+		return member != object.MemberEnd() && member->value.IsNumber() ? member->value.GetFloat() : fallback;
+	}
+
+	bool getBool(const rapidjson::Value& object, const char* name, const bool fallback)
+	{
+		rapidjson::Value::ConstMemberIterator member = object.FindMember(name);
+		return member != object.MemberEnd() && member->value.IsBool() ? member->value.GetBool() : fallback;
+	}
+
+	std::string getString(const rapidjson::Value& object, const char* name, const std::string& fallback = "")
+	{
+		rapidjson::Value::ConstMemberIterator member = object.FindMember(name);
+		return member != object.MemberEnd() && member->value.IsString() ? 
+			std::string(member->value.GetString(), member->value.GetStringLength()) : fallback;
+	}
+
+	glm::vec3 getVec3(const rapidjson::Value& object, const char* name, const glm::vec3& fallback)
+	{
+		rapidjson::Value::ConstMemberIterator member = object.FindMember(name);
+		if (member == object.MemberEnd() || !member->value.IsObject())
+		{
+			return fallback;
+		}
+		return glm::vec3(getFloat(member->value, "x", fallback.x), getFloat(member->value, "y", fallback.y), getFloat(member->value, "z", fallback.z));
+	}
+
+	// missing sections are treated as empty
+	rapidjson::Value::ConstArray getArray(const rapidjson::Value& object, const char* name)
+	{
+		static const rapidjson::Value empty(rapidjson::kArrayType);
+		rapidjson::Value::ConstMemberIterator member = object.FindMember(name);
+		return member != object.MemberEnd() && member->value.IsArray() ? member->value.GetArray() : empty.GetArray();
+	}
+}
+
+bool Loader::loadSceneJSON(const std::string& filename, Scene& scene)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	auto phaseStart = start;
+
+	std::ifstream jsonFile(filename, std::ios::binary);
+	if (!jsonFile.is_open())
+	{
+		spdlog::error("Could not open scene '{}'", filename);
+		return false;
+	}
+
+	// parsed in situ, strings in the document point into this buffer instead of being copied out
+	std::vector<char> json((std::istreambuf_iterator<char>(jsonFile)), std::istreambuf_iterator<char>());
+	json.push_back('\0');
 
 	rapidjson::Document jsonDocument;
-	jsonDocument.ParseStream(jsonFileWrapped);
+	jsonDocument.ParseInsitu(json.data());
+	if (jsonDocument.HasParseError() || !jsonDocument.IsObject())
+	{
+		spdlog::error("Failed to parse scene '{}' at offset {:d}, {}", filename, jsonDocument.GetErrorOffset(), rapidjson::GetParseError_En(jsonDocument.GetParseError()));
+		return false;
+	}
 
-	/*
-	const rapidjson::Value& shaders = jsonDocument["Shaders"];
-	for (rapidjson::Value::ConstMemberIterator shader = shaders.MemberBegin(); shader != shaders.MemberEnd(); shader++)
+	rapidjson::Value::ConstArray models = getArray(jsonDocument, "Models");
+	rapidjson::Value::ConstArray lights = getArray(jsonDocument, "Lights");
+	rapidjson::Value::ConstArray audio = getArray(jsonDocument, "Audio");
+	rapidjson::Value::ConstArray physics = getArray(jsonDocument, "Physics");
+
+	// placements only reference assets, each unique model is cooked and loaded once however many entries use it
+	std::vector<std::string> modelPaths;
+	std::map<std::string, std::size_t> modelIndices;
+	for (const rapidjson::Value& entry : models)
+	{
+		std::string path = getString(entry, "path");
+		if (!path.empty() && modelIndices.emplace(path, modelPaths.size()).second)
+		{
+			modelPaths.push_back(path);
+		}
+	}
+	scene.timings.parse = getMilliseconds(phaseStart);
+
+	// importing and cooking is the expensive part and touches no gl state, spread it over worker threads
+	phaseStart = std::chrono::high_resolution_clock::now();
+	std::atomic<std::size_t> nextModel = 0;
+	unsigned int workerCount = std::min((unsigned int)modelPaths.size(), std::max(std::thread::hardware_concurrency(), 1u));
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < workerCount; i++)
 	{
-		std::cout << shader->name.GetString() << std::endl;
-		std::cout << "   " << shader->value["VertexPath"].GetString() << std::endl;
-		std::cout << "   " << shader->value["FragmentPath"].GetString() << std::endl;
-	}*/
+		workers.emplace_back([&modelPaths, &nextModel]()
+		{
+			for (std::size_t index = nextModel++; index < modelPaths.size(); index = nextModel++)
+			{
+				Model::cook(modelPaths[index]);
+			}
+		});
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	scene.timings.cook = getMilliseconds(phaseStart);
+
+	// gl objects are created here on the calling thread from the now cooked entries
+	phaseStart = std::chrono::high_resolution_clock::now();
+	for (const std::string& path : modelPaths)
+	{
+		scene.models.push_back(std::make_unique<Model>(path));
+		if (scene.models.back()->meshes.empty())
+		{
+			spdlog::error("Scene '{}' model '{}' has no meshes", filename, path);
+		}
+	}
+
+	std::map<std::string, Texture> cubeMaps;
+	for (const rapidjson::Value& entry : models)
+	{
+		std::string path = getString(entry, "path");
+		if (path.empty())
+		{
+			spdlog::error("Scene '{}' has a model without a path", filename);
+			continue;
+		}
+
+		// a cube map belongs to the placement, so entries with different cube maps still share one model
+		std::string cubeMap = getString(entry, "cubeMap");
+		if (!cubeMap.empty() && !cubeMaps.contains(cubeMap))
+		{
+			cubeMaps[cubeMap] = Loader::loadCubeMap(cubeMap);
+		}
+
+		glm::vec3 rotation = getVec3(entry, "rotation", glm::vec3(0.0f));
+		SceneObject object;
+		object.name = getString(entry, "name");
+		object.shader = getString(entry, "shader", "bsdf");
+		object.occluder = getBool(entry, "occluder", false);
+		object.model = scene.models[modelIndices.at(path)].get();
+		object.cubeMap = cubeMap.empty() ? 0 : cubeMaps[cubeMap].ID;
+		Maths::createTransformationMatrix(object.transform, getVec3(entry, "position", glm::vec3(0.0f)), 
+			rotation.x, rotation.y, rotation.z, getFloat(entry, "scale", 1.0f));
+		scene.objects.push_back(object);
+	}
+	scene.buildIndex();
+
+	for (const rapidjson::Value& entry : lights)
+	{
+		scene.lights.push_back(Light(getVec3(entry, "position", glm::vec3(0.0f)), getVec3(entry, "color", glm::vec3(1.0f))));
+	}
+	scene.timings.models = getMilliseconds(phaseStart);
+
+	phaseStart = std::chrono::high_resolution_clock::now();
+	for (const rapidjson::Value& entry : audio)
+	{
+		std::string path = getString(entry, "path");
+		if (path.empty())
+		{
+			spdlog::error("Scene '{}' has an audio source without a path", filename);
+			continue;
+		}
+
+		scene.sources.push_back(std::make_unique<Source>(path, getVec3(entry, "position", glm::vec3(0.0f)), getVec3(entry, "velocity", glm::vec3(0.0f)),
+			getFloat(entry, "pitch", 1.0f), getFloat(entry, "gain", 1.0f), getFloat(entry, "referenceDistance", 0.0f), getFloat(entry, "maxDistance", 10.0f),
+			getFloat(entry, "rolloffFactor", 1.0f), getBool(entry, "looping", false) ? AL_TRUE : AL_FALSE, getBool(entry, "streaming", false)));
+		if (getBool(entry, "play", false))
+		{
+			scene.sources.back()->play();
+		}
+	}
+	scene.timings.audio = getMilliseconds(phaseStart);
+
+	phaseStart = std::chrono::high_resolution_clock::now();
+	if (!physics.Empty())
+	{
+		scene.physicsManager = std::make_unique<PhysicsManager>();
+	}
+	for (const rapidjson::Value& entry : physics)
+	{
+		// dimensions are the full box size, bullet wants half extents
+		glm::vec3 dimensions = getVec3(entry, "dimensions", glm::vec3(1.0f)) * 0.5f;
+		glm::vec3 position = getVec3(entry, "position", glm::vec3(0.0f));
+		glm::vec3 rotation = glm::radians(getVec3(entry, "rotation", glm::vec3(0.0f)));
+		PhysicsBox box = PhysicsBox(btVector3(dimensions.x, dimensions.y, dimensions.z), btVector3(position.x, position.y, position.z), getFloat(entry, "mass", 0.0f));
+
+		btTransform transform = box.getBody()->getWorldTransform();
+		transform.setRotation(btQuaternion(rotation.y, rotation.x, rotation.z));
+		box.getBody()->setWorldTransform(transform);
+		box.getBody()->getMotionState()->setWorldTransform(transform);
+
+		scene.physicsManager->addCollisionShape(box.getShape(), box.getBody());
+		scene.bodies.push_back(box);
+	}
+	scene.timings.physics = getMilliseconds(phaseStart);
+	scene.timings.total = getMilliseconds(start);
+
+	spdlog::info("Loaded scene '{}', {:d} objects using {:d} models, {:d} lights, {:d} sources, {:d} bodies", filename,
+		scene.objects.size(), scene.models.size(), scene.lights.size(), scene.sources.size(), scene.bodies.size());
+	spdlog::info("Scene load took {:.2f} ms, parse {:.2f} ms, cook {:.2f} ms, models {:.2f} ms, audio {:.2f} ms, physics {:.2f} ms",
+		scene.timings.total, scene.timings.parse, scene.timings.cook, scene.timings.models, scene.timings.audio, scene.timings.physics);
+	return true;
 }
 
 std::int32_t Loader::convertToInt(char* buffer, std::size_t len)
@@ -186,39 +384,54 @@ bool Loader::loadWavFileHeader(std::ifstream& file, Sound& sound)
 
 Sound Loader::loadWav(const std::string& filename)
 {
-	if (Loader::sounds.count(filename) == 0)
-	{
-		Sound sound;
+	Sound sound;
 
-		std::ifstream in(filename, std::ios::binary);
-		if (!in.is_open())
-		{
-			spdlog::error("Could not open '{}'", filename);
-			exit(-1);
-		}
-		if (!Loader::loadWavFileHeader(in, sound))
-		{
-			spdlog::error("Could not load wav header of '{}'", filename);
-			exit(-1);
-		}
-
-		sound.RawSoundData = new char[sound.DataSize];
+	std::ifstream in(filename, std::ios::binary);
+	if (!in.is_open())
+	{
+		spdlog::error("Could not open '{}'", filename);
+		exit(-1);
+	}
+	if (!Loader::loadWavFileHeader(in, sound))
+	{
+		spdlog::error("Could not load wav header of '{}'", filename);
+		exit(-1);
+	}
 
-		in.read(sound.RawSoundData, sound.DataSize);
+	// pcm is owned by the returned sound and released once it has been handed to openAL
+	sound.Data.resize(sound.DataSize);
+	in.read(sound.Data.data(), sound.DataSize);
+	sound.Format = Loader::getSoundFormat(sound);
 
-		Loader::sounds.insert(std::pair<std::string, Sound>(filename, sound));
+	return sound;
+}
 
-		return sound;
+ALenum Loader::getSoundFormat(const Sound& sound)
+{
+	if (sound.Channels == 1 && sound.BitsPerSample == 8)
+	{
+		return AL_FORMAT_MONO8;
 	}
-	else
-		return Loader::sounds[filename];
+	else if (sound.Channels == 1 && sound.BitsPerSample == 16)
+	{
+		return AL_FORMAT_MONO16;
+	}
+	else if (sound.Channels == 2 && sound.BitsPerSample == 8)
+	{
+		return AL_FORMAT_STEREO8;
+	}
+	else if (sound.Channels == 2 && sound.BitsPerSample == 16)
+	{
+		return AL_FORMAT_STEREO16;
+	}
+	return AL_NONE;
 }
 
 GLuint Loader::createVAO()
 {
 	unsigned int vaoID;
 	glCall(glGenVertexArrays, 1, &vaoID);
-	glCall(glBindVertexArray, vaoID);
+	OpenGLState::bindVertexArray(vaoID);
 	Loader::vaos.push_back(vaoID);
 	return vaoID;
 }
@@ -227,7 +440,7 @@ GLuint Loader::createEBO(const std::vector<GLuint>& indices)
 {
 	GLuint eboID;
 	glCall(glGenBuffers, 1, &eboID);
-	glCall(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, eboID);
+	OpenGLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboID);
 	glCall(glBufferData, GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
 	Loader::ebos.push_back(eboID);
 	return eboID;
@@ -235,31 +448,113 @@ GLuint Loader::createEBO(const std::vector<GLuint>& indices)
 
 void Loader::unbindVAO()
 {
-	glCall(glBindVertexArray, 0);
+	OpenGLState::bindVertexArray(0);
+}
+
+unsigned char* Loader::decodeImage(const std::string& filename, const bool flipVertically, int& width, int& height, int& nrComponents)
+{
+	// stb's flip flag is global, so it is left off and rows are flipped here to keep decoding safe on worker threads
+	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+	if (data && flipVertically)
+	{
+		std::size_t rowSize = (std::size_t)width * nrComponents;
+		std::vector<unsigned char> row(rowSize);
+		for (int y = 0; y < height / 2; y++)
+		{
+			unsigned char* top = data + y * rowSize;
+			unsigned char* bottom = data + (height - 1 - y) * rowSize;
+			std::memcpy(row.data(), top, rowSize);
+			std::memcpy(top, bottom, rowSize);
+			std::memcpy(bottom, row.data(), rowSize);
+		}
+	}
+	return data;
+}
+
+GLenum Loader::getTextureFormat(const int nrComponents)
+{
+	if (nrComponents == 1)
+		return GL_RED;
+	else if (nrComponents == 2)
+		return GL_RG;
+	else if (nrComponents == 3)
+		return GL_RGB;
+	else
+		return GL_RGBA;
+}
+
+void Loader::uploadCompressedImages(const GLenum target, const std::vector<TextureImage>& images)
+{
+	GLint maxLevel = 0;
+	for (const TextureImage& image : images)
+	{
+		glCall(glCompressedTexImage2D, image.target, image.level, image.internalFormat, image.width, image.height, 0, (GLsizei)image.size, image.pixels.get());
+		maxLevel = std::max(maxLevel, image.level);
+	}
+	glCall(glTexParameteri, target, GL_TEXTURE_MAX_LEVEL, maxLevel);
+}
+
+bool Loader::loadCompressedTexture(const std::string& path, const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically,
+	const GLenum target, const GLint wrapMode, Texture& texture)
+{
+	std::vector<TextureImage> images;
+	if (!TextureCache::loadOrCook(sources, typeName, flipVertically, target, images))
+	{
+		return false;
+	}
+
+	GLuint textureID;
+	glCall(glGenTextures, 1, &textureID);
+	OpenGLState::bindTexture(target, textureID);
+	Loader::uploadCompressedImages(target, images);
+
+	glCall(glTexParameteri, target, GL_TEXTURE_WRAP_S, wrapMode);
+	glCall(glTexParameteri, target, GL_TEXTURE_WRAP_T, wrapMode);
+	if (target == GL_TEXTURE_CUBE_MAP)
+	{
+		glCall(glTexParameteri, target, GL_TEXTURE_WRAP_R, wrapMode);
+		glCall(glTexParameteri, target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	}
+	else
+	{
+		glCall(glTexParameteri, target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	}
+	glCall(glTexParameteri, target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	texture.ID = textureID;
+	texture.Type = typeName;
+	texture.Path = path;
+	return true;
 }
 
 Texture Loader::loadTexture(const std::string& filename, const std::string& typeName)
 {
 	if (Loader::textures.count(filename) == 0)
 	{
+		if (Config::Textures::STREAMING)
+		{
+			Texture texture = TextureStreamer::requestTexture(filename, typeName, true, GL_CLAMP_TO_EDGE);
+			Loader::textures.insert(std::pair(filename, texture));
+			return texture;
+		}
+
+		Texture texture;
+		if (Config::Textures::COMPRESSION && Loader::loadCompressedTexture(filename, { filename }, typeName, true, GL_TEXTURE_2D, GL_CLAMP_TO_EDGE, texture))
+		{
+			Loader::textures.insert(std::pair(filename, texture));
+			return texture;
+		}
+
 		GLuint textureID;
 		glCall(glGenTextures, 1, &textureID);
 
 		int width, height, nrComponents;
-		stbi_set_flip_vertically_on_load(true);
-
-		unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+		unsigned char* data = Loader::decodeImage(filename, true, width, height, nrComponents);
 		if (data)
 		{
-			GLenum format;
-			if (nrComponents == 1)
-				format = GL_RED;
-			else if (nrComponents == 3)
-				format = GL_RGB;
-			else if (nrComponents == 4)
-				format = GL_RGBA;
-
-			glCall(glBindTexture, GL_TEXTURE_2D, textureID);
+			GLenum format = Loader::getTextureFormat(nrComponents);
+
+			OpenGLState::bindTexture(GL_TEXTURE_2D, textureID);
 			glCall(glTexImage2D, GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 			glCall(glGenerateMipmap, GL_TEXTURE_2D);
 
@@ -276,7 +571,6 @@ Texture Loader::loadTexture(const std::string& filename, const std::string& type
 			stbi_image_free(data);
 		}
 
-		Texture texture;
 		texture.ID = textureID;
 		texture.Type = typeName;
 		texture.Path = filename;
@@ -296,15 +590,28 @@ Texture Loader::loadCubeMap(const std::string& path)
 
 	if (Loader::textures.count(path) == 0)
 	{
+		if (Config::Textures::STREAMING)
+		{
+			Texture texture = TextureStreamer::requestCubeMap(faces, path);
+			Loader::textures.insert(std::pair(path, texture));
+			return texture;
+		}
+
+		Texture texture;
+		if (Config::Textures::COMPRESSION && Loader::loadCompressedTexture(path, faces, "texture_cubeMap", false, GL_TEXTURE_CUBE_MAP, GL_CLAMP_TO_EDGE, texture))
+		{
+			Loader::textures.insert(std::pair(path, texture));
+			return texture;
+		}
+
 		GLuint textureID;
 		glCall(glGenTextures, 1, &textureID);
-		glCall(glBindTexture, GL_TEXTURE_CUBE_MAP, textureID);
+		OpenGLState::bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-		stbi_set_flip_vertically_on_load(false);
 		for (unsigned int i = 0; i < faces.size(); i++)
 		{
 			int width, height, nrChannels;
-			unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+			unsigned char* data = Loader::decodeImage(faces[i], false, width, height, nrChannels);
 			if (data)
 			{
 				glCall(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
@@ -322,7 +629,6 @@ Texture Loader::loadCubeMap(const std::string& path)
 		glCall(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glCall(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-		Texture texture;
 		texture.ID = textureID;
 		texture.Type = "texture_cubeMap";
 		texture.Path = path;
@@ -341,7 +647,7 @@ Texture Loader::createEmptyCubeMap()
 	{
 		GLuint textureID;
 		glCall(glGenTextures, 1, &textureID);
-		glCall(glBindTexture, GL_TEXTURE_CUBE_MAP, textureID);
+		OpenGLState::bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
 		std::vector<GLubyte> empty(4, 0);
 		glCall(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_RGB, 1, 1, 0, GL_BGRA, GL_UNSIGNED_BYTE, &empty);
@@ -377,23 +683,32 @@ Texture Loader::loadTextureFromPath(const std::string& path, const std::string&
 
 	if (Loader::textures.count(filename) == 0)
 	{
+		if (Config::Textures::STREAMING)
+		{
+			Texture texture = TextureStreamer::requestTexture(filename, type, false, GL_REPEAT);
+			texture.Path = path;
+			Loader::textures.insert(std::pair(filename, texture));
+			return texture;
+		}
+
+		Texture texture;
+		if (Config::Textures::COMPRESSION && Loader::loadCompressedTexture(filename, { filename }, type, false, GL_TEXTURE_2D, GL_REPEAT, texture))
+		{
+			texture.Path = path;
+			Loader::textures.insert(std::pair(filename, texture));
+			return texture;
+		}
+
 		GLuint textureID;
 		glCall(glGenTextures, 1, &textureID);
 
-		stbi_set_flip_vertically_on_load(false);
 		int width, height, nrComponents;
-		unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+		unsigned char* data = Loader::decodeImage(filename, false, width, height, nrComponents);
 		if (data)
 		{
-			GLenum format;
-			if (nrComponents == 1)
-				format = GL_RED;
-			else if (nrComponents == 3)
-				format = GL_RGB;
-			else if (nrComponents == 4)
-				format = GL_RGBA;
-
-			glCall(glBindTexture, GL_TEXTURE_2D, textureID);
+			GLenum format = Loader::getTextureFormat(nrComponents);
+
+			OpenGLState::bindTexture(GL_TEXTURE_2D, textureID);
 			glCall(glTexImage2D, GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 			glCall(glGenerateMipmap, GL_TEXTURE_2D);
 
@@ -410,11 +725,12 @@ Texture Loader::loadTextureFromPath(const std::string& path, const std::string&
 			stbi_image_free(data);
 		}
 
-		Texture texture;
 		texture.ID = textureID;
 		texture.Path = path;
 		texture.Type = type;
 
+		Loader::textures.insert(std::pair(filename, texture));
+
 		return texture;
 	}
 	else
@@ -424,11 +740,11 @@ Texture Loader::loadTextureFromPath(const std::string& path, const std::string&
 void Loader::destroy()
 {
 	for (GLuint vao : Loader::vaos)
-		glCall(glDeleteVertexArrays, 1, &vao);
+		OpenGLState::deleteVertexArrays(1, &vao);
 	for (GLuint vbo : Loader::vbos)
-		glCall(glDeleteBuffers, 1, &vbo);
+		OpenGLState::deleteBuffers(1, &vbo);
 	for (GLuint ebo : Loader::ebos)
-		glCall(glDeleteBuffers, 1, &ebo);
+		OpenGLState::deleteBuffers(1, &ebo);
 	for (std::pair<std::string, Texture> texture : Loader::textures)
-		glCall(glDeleteTextures, 1, &texture.second.ID);
+		OpenGLState::deleteTextures(1, &texture.second.ID);
 }
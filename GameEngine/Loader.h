@@ -7,19 +7,23 @@
 #include <map>
 
 #include "OpenGLFunctions.h"
+#include "TextureImage.h"
+#include "OpenGLState.h"
 #include "Texture.h"
 #include "Model.h"
 #include "Sound.h"
 
+class Scene;
+
 struct Loader
 {
-	static std::map<std::string, Sound> sounds;
 	static std::map<std::string, Texture> textures;
 	static std::vector<GLuint> vaos;
 	static std::vector<GLuint> vbos;
 	static std::vector<GLuint> ebos;
 
-	static void loadSceneJSON(const std::string& filename);
+	// models, lights, audio sources and physics bodies described by a scene file
+	static bool loadSceneJSON(const std::string& filename, Scene& scene);
 
 	static std::int32_t convertToInt(char* buffer, std::size_t len);
 
@@ -27,12 +31,23 @@ struct Loader
 
 	static Sound loadWav(const std::string& filename);
 
+	static ALenum getSoundFormat(const Sound& sound);
+
 	static GLuint createVAO();
 
 	static GLuint createEBO(const std::vector<GLuint>& indices);
 
 	static void unbindVAO();
 
+	static unsigned char* decodeImage(const std::string& filename, const bool flipVertically, int& width, int& height, int& nrComponents);
+
+	static GLenum getTextureFormat(const int nrComponents);
+
+	static void uploadCompressedImages(const GLenum target, const std::vector<TextureImage>& images);
+
+	static bool loadCompressedTexture(const std::string& path, const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically,
+		const GLenum target, const GLint wrapMode, Texture& texture);
+
 	static Texture loadTexture(const std::string& filename, const std::string& typeName);
 
 	static Texture loadCubeMap(const std::string& path);
@@ -45,6 +60,9 @@ struct Loader
 
 	template <typename dataSize_t, typename offset_t> static void createAttibutePointer(const GLuint attributeNumber, const GLuint coordinateSize, const dataSize_t dataType, const offset_t offset);
 
+	template <typename dataSize_t, typename offset_t> static void createAttibutePointer(const GLuint attributeNumber, const GLuint coordinateSize, const GLenum type,
+		const GLboolean normalized, const dataSize_t dataSize, const offset_t offset);
+
 	static void destroy();
 };
 
@@ -53,7 +71,7 @@ template <typename dataType_t> void Loader::storeDataInAttributeList(const GLuin
 	GLuint vbo;
 	glGenBuffers(1, &vbo);
 
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	OpenGLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(dataType_t), &data[0], GL_STATIC_DRAW);
 	glVertexAttribPointer(attributeNumber, coordinateSize, GL_FLOAT, GL_FALSE, 0, 0);
 }
@@ -63,3 +81,10 @@ template <typename dataSize_t, typename offset_t> void Loader::createAttibutePoi
 	glEnableVertexAttribArray(attributeNumber);
 	glVertexAttribPointer(attributeNumber, coordinateSize, GL_FLOAT, GL_FALSE, (GLsizei)dataSize, offset);
 }
+
+template <typename dataSize_t, typename offset_t> void Loader::createAttibutePointer(const GLuint attributeNumber, const GLuint coordinateSize, const GLenum type,
+	const GLboolean normalized, const dataSize_t dataSize, const offset_t offset)
+{
+	glEnableVertexAttribArray(attributeNumber);
+	glVertexAttribPointer(attributeNumber, coordinateSize, type, normalized, (GLsizei)dataSize, offset);
+}
@@ -19,7 +19,11 @@
 #include "stb_image.h"
 
 // STD
+#include <filesystem>
+#include <algorithm>
 #include <format>
+#include <chrono>
+#include <thread>
 
 // Headers
 #include "TessellationShader.h"
@@ -27,15 +31,28 @@
 #include "ReflectionShader.h"
 #include "OpenALFunctions.h"
 #include "OpenGLFunctions.h"
+#include "TextureStreamer.h"
+#include "OcclusionCuller.h"
 #include "DisplayManager.h"
+#include "UniformBuffers.h"
+#include "MeshletBuilder.h"
+#include "GeometryArena.h"
+#include "AudioStreamer.h"
 #include "StatsTracker.h"
 #include "NormalShader.h"
 #include "SkyboxShader.h"
+#include "TextureCache.h"
 #include "TextRenderer.h"
 #include "SkyboxModel.h"
+#include "RenderStats.h"
+#include "RenderQueue.h"
 #include "PhysicsMesh.h"
+#include "OpenGLState.h"
+#include "AssetCache.h"
 #include "BSDFShader.h"
 #include "TextShader.h"
+#include "RingBuffer.h"
+#include "Benchmark.h"
 #include "Listener.h"
 #include "Texture.h"
 #include "Source.h"
@@ -43,6 +60,7 @@
 #include "Shader.h"
 #include "Config.h"
 #include "Camera.h"
+#include "Scene.h"
 #include "Maths.h"
 #include "Model.h"
 #include "Light.h"
@@ -54,23 +72,126 @@
 
 #include <bullet3/btBulletDynamicsCommon.h>
 
+void submitScene(Scene& scene, RenderQueue& queue, const glm::mat4& projectionMatrix, const glm::mat4& spinMatrix, const bool reflections,
+	OcclusionCuller* occlusionCuller)
+{
+	// only placements the index finds in the frustum are submitted, the queue then culls their meshes
+	static std::vector<std::uint32_t> visibleObjects;
+	visibleObjects.clear();
+	if (Config::Models::FRUSTUM_CULLING)
+	{
+		scene.queryFrustum(MeshletBuilder::getFrustumPlanes(projectionMatrix * Camera::viewMatrix), visibleObjects);
+		RenderStats::current.objectsTested += scene.objects.size();
+		RenderStats::current.objectsCulled += scene.objects.size() - visibleObjects.size();
+	}
+	else
+	{
+		for (std::uint32_t i = 0; i < scene.objects.size(); i++)
+		{
+			visibleObjects.push_back(i);
+		}
+	}
+
+	// the occluders were drawn for this view on the culler's thread since the start of the frame, occluders are never hidden
+	if (occlusionCuller)
+	{
+		RenderStats::current.occlusionWait += occlusionCuller->wait();
+		RenderStats::current.occlusionRasterize = occlusionCuller->getTimings().rasterize;
+		RenderStats::current.occlusionPyramid = occlusionCuller->getTimings().pyramid;
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		std::size_t occluded = std::erase_if(visibleObjects, [&scene, occlusionCuller](std::uint32_t index)
+			{
+				const SceneObject& object = scene.objects[index];
+				return !object.occluder && occlusionCuller->isOccluded(object.bounds.min, object.bounds.max);
+			});
+		RenderStats::current.objectsOccluded += occluded;
+		RenderStats::current.occlusionTest += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	for (std::uint32_t index : visibleObjects)
+	{
+		SceneObject& object = scene.objects[index];
+		if (object.shader == "bsdf")
+		{
+			queue.submit(*object.model, RenderShader::bsdf, object.transform, &object.lod, &object.bounds, object.cubeMap);
+		}
+		else if (object.shader == "reflection" && reflections)
+		{
+			queue.submit(*object.model, RenderShader::reflection, object.transform * spinMatrix, &object.lod, &object.bounds, object.cubeMap);
+		}
+	}
+}
 
-int main()
+int main(int argc, char** argv)
 {
 	spdlog::set_level(spdlog::level::debug);
 	spdlog::set_pattern("[%H:%M:%S %z] [%n] [%^---%L---%$] [thread %t] %v");
 
-	// Loader::loadSceneJSON("Resources/TestScene/test.json");
+	// offline cook step, "GameEngine --cook <model.obj | texture.png | cubeMapDirectory>..." writes cooked meshes and textures without opening a window
+	if (argc > 1 && std::string(argv[1]) == "--cook")
+	{
+		Config::loadConfigs("Settings/settings.ini");
+		AssetCache::init(Config::AssetCache::DIRECTORY);
+
+		bool success = true;
+		for (int i = 2; i < argc; i++)
+		{
+			std::filesystem::path path = argv[i];
+			std::string extension = path.extension().string();
+			if (std::filesystem::is_directory(path))
+			{
+				std::string directory = path.string();
+				std::vector<std::string> faces = { directory + "/right.png", directory + "/left.png", directory + "/top.png",
+					directory + "/bottom.png", directory + "/back.png", directory + "/front.png" };
+				success = TextureCache::cook(faces, "texture_cubeMap", false) && success;
+			}
+			else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+			{
+				success = TextureCache::cook({ path.string() }, "texture_diffuse", false) && success;
+			}
+			else
+			{
+				success = Model::cook(path.string()) && success;
+			}
+		}
+		AssetCache::logStats();
+		return success ? 0 : 1;
+	}
+
 	Config::loadConfigs("Settings/settings.ini");
+	AssetCache::init(Config::AssetCache::DIRECTORY);
 	StatsTracker statsTracker = StatsTracker();
 
 	Listener listener = Listener();
+	AudioStreamer::init(Config::Audio::STREAM_BUFFER_SIZE, Config::Audio::STREAM_BUFFER_COUNT);
 
-	Source source1 = Source("Resources/audio/ambientMono.wav", glm::vec3(-4.25f, 0.125f, -4.25f), glm::vec3(0.0f), 1.0f, 1.0f, 0.0f, 10.0f, 1.0f, AL_FALSE);
 	Source source2 = Source("Resources/audio/heavy.wav");
 
 	Display display = Display(1280, 720, "OpenGL Game Engine");
 	// Display display2 = Display(1280, 720, "Second Window", display.getWindow());
+	RingBuffer::init();
+	UniformBuffers::init();
+
+	if (Config::Textures::STREAMING)
+	{
+		unsigned int streamingThreads = Config::Textures::STREAMING_THREADS;
+		if (streamingThreads == 0)
+		{
+			streamingThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		}
+		TextureStreamer::init(streamingThreads, Config::Textures::UPLOAD_BUDGET,
+			Config::Textures::STAGING_BUFFER_SIZE, Config::Textures::STAGING_BUFFER_COUNT);
+	}
+
+	// "GameEngine --benchmark <name> [arguments]" runs a measurement against the window's context and exits
+	if (argc > 2 && std::string(argv[1]) == "--benchmark")
+	{
+		bool success = Benchmark::run(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+		TextureStreamer::shutdown();
+		AudioStreamer::shutdown();
+		return success ? 0 : 1;
+	}
 
 	BSDFShader bsdfShader = BSDFShader(
 		"Shaders/BSDFShader/bsdfShader.vert",
@@ -87,29 +208,48 @@ int main()
 	TextShader textShader = TextShader(
 		"Shaders/TextShader/textShader.vert",
 		"Shaders/TextShader/textShader.frag");
+	ShaderProgram::logCacheStats();
 
 	TextRenderer textRenderer = TextRenderer();
-
-	std::vector<Light> lights;
-	lights.push_back(Light(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
+	// the controls panel never changes and the stats only patch the glyphs that did
+	TextObject controlsText;
+	TextObject statsText;
 
 	SkyboxModel skyboxModel = SkyboxModel("Resources/skyboxDay");
 
-	Model model = Model("Resources/TestScene/Mesh.obj");
-	Model barrel = Model("Resources/Crate/crate.obj");
-	Model barrel2 = Model("Resources/Crate/crate.obj");
-	Texture skyboxTexture = Loader::loadCubeMap("Resources/skyboxDay");
-	barrel2.setCubeMap(skyboxTexture);
+	Scene scene;
+	if (!Loader::loadSceneJSON("Resources/TestScene/test.json", scene) || !scene.findObject("Room"))
+	{
+		TextureStreamer::shutdown();
+		AudioStreamer::shutdown();
+		return -1;
+	}
+	Model& model = *scene.findObject("Room")->model;
+
+	// reflective objects are drawn spinning, the rest of the scene is static
+	std::vector<std::uint32_t> spinningObjects;
+	for (std::uint32_t i = 0; i < scene.objects.size(); i++)
+	{
+		if (scene.objects[i].shader == "reflection")
+		{
+			spinningObjects.push_back(i);
+		}
+	}
+
+	OcclusionCuller occlusionCuller;
+	scene.addOccluders(occlusionCuller);
+	OcclusionCuller* sceneOcclusion = Config::Models::OCCLUSION_CULLING && occlusionCuller.getTriangleCount() > 0 ? &occlusionCuller : nullptr;
+	spdlog::debug("Occlusion culling with {:d} occluder triangles", occlusionCuller.getTriangleCount());
 
 	display.hideCursor();
 	//DisplayManager::showCursor();
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
+	RenderQueue renderQueue = RenderQueue(bsdfShader, reflectionShader);
+
 	FrameBufferObject fbo = FrameBufferObject();
 	FrameBufferObject fbo2 = FrameBufferObject();
 
-	source1.play();
-
 	/* Physics
 	Model physicsCubeGround = Model("Resources/CollisionTest/100x10x100_box.obj");
 	
@@ -142,21 +282,38 @@ int main()
 	{
 		glfwMakeContextCurrent(display.getWindow());
 
+		// textures decoded by the streaming threads are uploaded here, within the per frame budget
+		TextureStreamer::update();
+
 		if (glfwGetKey(display.getWindow(), GLFW_KEY_0))
 			source2.play();
 		source2.setPosition(Camera::position);
 
 		Camera::move(display);
+		if (sceneOcclusion)
+		{
+			sceneOcclusion->begin(display.getProjectionMatrix() * Camera::viewMatrix);
+		}
+		UniformBuffers::updateFrame(display.getProjectionMatrix(), scene.lights, (float)glfwGetTime());
 
 		listener.updatePosition();
 
-		// physicsManager.stepSimulation(1.0f / 60.0f);
+		if (scene.physicsManager)
+		{
+			scene.physicsManager->stepSimulation(display.getFrameDelta());
+		}
+
+		glm::mat4 spinMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(yRot), glm::vec3(0.0f, 1.0f, 0.0f));
+		for (std::uint32_t index : spinningObjects)
+		{
+			scene.updateBounds(index, scene.objects[index].transform * spinMatrix);
+		}
 
 		// Buffered Shader Cycle (Mirror)
 		fbo.bind();
-		bsdfShader.start();
-		model.draw(bsdfShader, glm::mat4(1.0f), display.getProjectionMatrix());
-		bsdfShader.stop();
+		renderQueue.begin(display.getProjectionMatrix());
+		submitScene(scene, renderQueue, display.getProjectionMatrix(), spinMatrix, false, sceneOcclusion);
+		renderQueue.flush();
 
 		skyboxShader.start();
 		skyboxModel.draw(skyboxShader, display.getProjectionMatrix());
@@ -171,11 +328,11 @@ int main()
 		model.meshes[mirrorMeshID].textures[0].ID = fbo.textureColorID;
 
 		// ------------------------------
-		// BSDF Shader
+		// BSDF and Reflection Shaders
 		// ------------------------------
-		bsdfShader.start();
-		model.draw(bsdfShader, glm::mat4(1.0f), display.getProjectionMatrix());
-		bsdfShader.stop();
+		renderQueue.begin(display.getProjectionMatrix());
+		submitScene(scene, renderQueue, display.getProjectionMatrix(), spinMatrix, true, sceneOcclusion);
+		renderQueue.flush();
 
 		// physicsCubeGround.draw(bsdfShader, glm::mat4(1.0f));
 		// glm::vec3 position((float)dynamicBox.getPosition().getX(), (float)dynamicBox.getPosition().getY(), (float)dynamicBox.getPosition().getZ());
@@ -183,19 +340,6 @@ int main()
 		// Maths::createTransformationMatrix(transform, position, 0, 0, 0, 1);
 		// physicsCubeDynamic.draw(bsdfShader, transform);
 
-		bsdfShader.stop();
-
-		// ------------------------------
-		// Reflection Shader
-		// ------------------------------
-		reflectionShader.start();
-		glm::mat4 barrelTransformationMatrix;
-		Maths::createTransformationMatrix(barrelTransformationMatrix, glm::vec3(-4.25f, 0.85f, 4.5f), 0.0f, yRot, 0.0f, 1.0f);
-		barrel.draw(reflectionShader, barrelTransformationMatrix, display.getProjectionMatrix(), lights);
-		Maths::createTransformationMatrix(barrelTransformationMatrix, glm::vec3(-4.25f, 1.9f, 4.5f), 0.0f, yRot, 0.0f, 1.0f);
-		barrel2.draw(reflectionShader, barrelTransformationMatrix, display.getProjectionMatrix(), lights);
-		reflectionShader.stop();
-
 		model.meshes[mirrorMeshID].textures[0].ID = tempTexture;
 
 		// Skybox Shader Cycle
@@ -203,16 +347,27 @@ int main()
 		skyboxModel.draw(skyboxShader, display.getProjectionMatrix());
 		skyboxShader.stop();
 
-		textRenderer.drawText(display, textShader, "Controls\n--------------------------------------------------------\nW - Move Forward\nS - Move Backward\nA - Move Left\nD - Move Right\nSpace - Move Up\nLShift - Move Down\nESC - Close Window", glm::vec3(-0.0f, 2.9f, -4.82f), glm::vec3(0.0f), glm::vec2(0.2f), glm::vec3(0.0f, 1.0f, 0.0f), Align::center, Origin::top);
+		textRenderer.drawText(display, textShader, controlsText, "Controls\n--------------------------------------------------------\nW - Move Forward\nS - Move Backward\nA - Move Left\nD - Move Right\nSpace - Move Up\nLShift - Move Down\nESC - Close Window", glm::vec3(-0.0f, 2.9f, -4.82f), glm::vec3(0.0f), glm::vec2(0.2f), glm::vec3(0.0f, 1.0f, 0.0f), Align::center, Origin::top);
 
 		// FPS Shader Cycle
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		OpenGLState::enable(GL_BLEND);
+		OpenGLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		//fpsModel.update(display);
 		//fpsModel.render(display, textShader, textRenderer);
 		statsTracker.update(display.getFrameDelta());
-		textRenderer.drawTextOnHUD(display, textShader, std::format("FPS:{:d}", statsTracker.getFps()),
+		textRenderer.drawTextOnHUD(display, textShader, statsText, std::format("FPS:{:d}\nDraw calls:{:d} Commands:{:d} Instances:{:d}\nTriangles:{:d}\nObjects culled:{:d}/{:d} Meshes culled:{:d}/{:d}\nObjects occluded:{:d} Occlusion raster:{:.2f} pyramid:{:.2f} wait:{:.2f} test:{:.2f} ms\nClusters culled:{:d}/{:d}\nState changes:{:d}\nGL calls elided:{:d}/{:d}\nUniform loads:{:d} Buffer uploads:{:d}\nRing buffer:{:d} KiB waits:{:d}\nText layouts:{:d} Glyphs uploaded:{:d}\nGlyphs rasterized:{:d} Atlas uploads:{:d} evictions:{:d}", statsTracker.getFps(),
+			RenderStats::last.drawCalls, RenderStats::last.indirectCommands, RenderStats::last.instances, RenderStats::last.triangles, RenderStats::last.objectsCulled, RenderStats::last.objectsTested, RenderStats::last.meshesCulled, RenderStats::last.meshesTested,
+			RenderStats::last.objectsOccluded, RenderStats::last.occlusionRasterize, RenderStats::last.occlusionPyramid, RenderStats::last.occlusionWait, RenderStats::last.occlusionTest, RenderStats::last.clustersCulled, RenderStats::last.clustersTested, RenderStats::last.shaderChanges +
+			RenderStats::last.materialChanges + RenderStats::last.textureChanges + RenderStats::last.vertexArrayChanges,
+			RenderStats::last.glCallsElided, RenderStats::last.glCallsElided + RenderStats::last.glCallsIssued, RenderStats::last.uniformLoads,
+			RenderStats::last.bufferUploads, RenderStats::last.ringBytes / 1024, RenderStats::last.ringWaits,
+			RenderStats::last.textLayouts, RenderStats::last.glyphUploads, RenderStats::last.glyphsRasterized, RenderStats::last.atlasUploads,
+			RenderStats::last.atlasEvictions),
 			display.getResolution(), glm::vec2(30.0f), glm::vec3(0.0f, 1.0f, 0.0f), Align::right, Origin::topRight);
+		OpenGLState::endFrame();
+		textRenderer.endFrame();
+		RingBuffer::endFrame();
+		RenderStats::endFrame();
 
 		// Show Display Buffer
 		display.update();
@@ -231,5 +386,10 @@ int main()
 	fbo.destroy();
 	bsdfShader.cleanUp();
 	textShader.cleanUp();
+	TextureStreamer::shutdown();
+	AudioStreamer::shutdown();
+	AssetCache::logStats();
+	RingBuffer::destroy();
+	GeometryArena::destroy();
 	Loader::destroy();
 }
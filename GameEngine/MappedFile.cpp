@@ -0,0 +1,154 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+MappedFile::MappedFile(const std::string& filename)
+{
+	this->open(filename);
+}
+
+MappedFile::~MappedFile()
+{
+	this->close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& filename)
+{
+	this->close();
+
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		spdlog::error("Could not open '{}' for mapping", filename);
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		spdlog::error("Could not map '{}' because it is empty", filename);
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		spdlog::error("Could not create file mapping for '{}'", filename);
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		spdlog::error("Could not map view of '{}'", filename);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	this->fileHandle = file;
+	this->mappingHandle = mapping;
+	this->data = static_cast<const unsigned char*>(view);
+	this->size = (std::size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (this->data != nullptr)
+	{
+		UnmapViewOfFile(this->data);
+	}
+	if (this->mappingHandle != nullptr)
+	{
+		CloseHandle(this->mappingHandle);
+	}
+	if (this->fileHandle != nullptr)
+	{
+		CloseHandle(this->fileHandle);
+	}
+
+	this->data = nullptr;
+	this->size = 0;
+	this->mappingHandle = nullptr;
+	this->fileHandle = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& filename)
+{
+	this->close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd == -1)
+	{
+		spdlog::error("Could not open '{}' for mapping", filename);
+		return false;
+	}
+
+	struct stat fileStats;
+	if (fstat(fd, &fileStats) != 0 || fileStats.st_size == 0)
+	{
+		spdlog::error("Could not map '{}' because it is empty", filename);
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (std::size_t)fileStats.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		spdlog::error("Could not map view of '{}'", filename);
+		::close(fd);
+		return false;
+	}
+
+	this->fileDescriptor = fd;
+	this->data = static_cast<const unsigned char*>(view);
+	this->size = (std::size_t)fileStats.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (this->data != nullptr)
+	{
+		munmap(const_cast<unsigned char*>(this->data), this->size);
+	}
+	if (this->fileDescriptor != -1)
+	{
+		::close(this->fileDescriptor);
+	}
+
+	this->data = nullptr;
+	this->size = 0;
+	this->fileDescriptor = -1;
+}
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return this->data != nullptr;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+	return this->data;
+}
+
+std::size_t MappedFile::getSize() const
+{
+	return this->size;
+}
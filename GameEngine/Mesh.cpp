@@ -1,148 +1,340 @@
 
 #include "Mesh.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "OpenGLFunctions.h"
 #include "DisplayManager.h"
+#include "MeshletBuilder.h"
+#include "UniformBuffers.h"
+#include "GeometryArena.h"
+#include "VertexPacker.h"
+#include "RenderStats.h"
+#include "OpenGLState.h"
 #include "Config.h"
+#include "Camera.h"
 #include "Loader.h"
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures, const Material& mat, const unsigned int numFaces) :
-	vertices(vertices), indices(indices), textures(textures), mat(mat), numFaces(numFaces)
+namespace
 {
-	this->setupMesh();
+	// the order of the bound flags in a binding table
+	const std::array<std::string, 5> TEXTURE_TYPES = { "texture_diffuse", "texture_specular", "texture_normal", "texture_displacement", "texture_cubeMap" };
+	const std::size_t CUBE_MAP_TYPE = 4;
 }
 
-void Mesh::setupMesh()
+Mesh::Mesh(const MeshStreams& streams, const std::vector<Texture>& textures, const Material& mat, const unsigned int numFaces,
+	std::span<const MeshLod> lods, std::span<const Meshlet> meshlets) :
+	lods(lods.begin(), lods.end()), meshlets(meshlets.begin(), meshlets.end()), textures(textures), mat(mat), quantization(streams.quantization), numFaces(numFaces)
 {
-	glCall(glGenVertexArrays, 1, &this->vao);
-	glCall(glGenBuffers, 1, &this->vbo);
-	glCall(glGenBuffers, 1, &this->ebo);
-	glCall(glGenBuffers, 1, &this->uniformBlockIndex);
+	this->setupMesh(streams);
+}
 
-	glCall(glBindVertexArray, this->vao);
+void Mesh::setupMesh(const MeshStreams& streams)
+{
+	if (this->lods.empty())
+	{
+		this->lods.push_back({ 0, (std::uint32_t)streams.indexCount, 0.0f });
+	}
 
-	glCall(glBindBuffer, GL_ARRAY_BUFFER, this->vbo);
+	// the explicit copy for cpu side readers, decoded from the streams so it matches what the gpu draws
+	this->positions.resize(streams.vertexCount);
+	for (std::size_t i = 0; i < streams.vertexCount; i++)
+	{
+		this->positions[i] = this->quantization.packed ? VertexPacker::unpackPosition(static_cast<const PackedVertex*>(streams.vertices)[i], this->quantization) :
+			static_cast<const Vertex*>(streams.vertices)[i].Position;
+	}
+	if (streams.indexSize == sizeof(std::uint16_t))
+	{
+		const std::uint16_t* shortIndices = static_cast<const std::uint16_t*>(streams.indices);
+		this->indices.assign(shortIndices, shortIndices + streams.indexCount);
+	}
+	else
+	{
+		const unsigned int* longIndices = static_cast<const unsigned int*>(streams.indices);
+		this->indices.assign(longIndices, longIndices + streams.indexCount);
+	}
 
-	glCall(glBufferData, GL_ARRAY_BUFFER, this->vertices.size() * sizeof(Vertex) + sizeof(this->mat), &this->vertices[0], GL_STATIC_DRAW);
-	glCall(glBindBuffer, GL_UNIFORM_BUFFER, this->uniformBlockIndex);
-	glCall(glBufferData, GL_UNIFORM_BUFFER, sizeof(this->mat), (void*)(&this->mat), GL_STATIC_DRAW);
+	this->boundsMin = glm::vec3(this->positions.empty() ? 0.0f : std::numeric_limits<float>::max());
+	this->boundsMax = glm::vec3(this->positions.empty() ? 0.0f : std::numeric_limits<float>::lowest());
+	for (const glm::vec3& position : this->positions)
+	{
+		this->boundsMin = glm::min(this->boundsMin, position);
+		this->boundsMax = glm::max(this->boundsMax, position);
+	}
 
-	glCall(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, this->ebo);
-	glCall(glBufferData, GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(unsigned int), &this->indices[0], GL_STATIC_DRAW);
+	// centered on the box, the radius reaches the furthest vertex rather than the box corner
+	this->sphereCenter = (this->boundsMin + this->boundsMax) * 0.5f;
+	this->sphereRadius = 0.0f;
+	for (const glm::vec3& position : this->positions)
+	{
+		this->sphereRadius = std::max(this->sphereRadius, glm::length(position - this->sphereCenter));
+	}
 
-	Loader::createAttibutePointer(0, 3, sizeof(Vertex), (void*)0);
-	Loader::createAttibutePointer(1, 2, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-	Loader::createAttibutePointer(2, 3, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-	Loader::createAttibutePointer(3, 3, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-	Loader::createAttibutePointer(4, 3, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+	glCall(glGenBuffers, 1, &this->uniformBlockIndex);
+	OpenGLState::bindBuffer(GL_UNIFORM_BUFFER, this->uniformBlockIndex);
+	glCall(glBufferData, GL_UNIFORM_BUFFER, sizeof(this->mat), (void*)(&this->mat), GL_STATIC_DRAW);
+
+	this->geometry = GeometryArena::allocate(this->quantization.packed, streams.indexSize == sizeof(std::uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+		streams.vertices, streams.vertexCount, streams.indices, streams.indexCount);
+	this->vao = GeometryArena::getVertexArray(this->geometry.pool);
 }
 
-void Mesh::bindTextures(GLuint programID)
+const MaterialBindingTable& Mesh::getBindingTable(GLuint programID)
 {
-	std::unordered_map<std::string, unsigned int> textureCount({
-		{"texture_diffuse", 0},
-		{"texture_specular", 0},
-		{"texture_normal", 0},
-		{"texture_displacement", 0},
-		{"texture_cubeMap", 0}
-	});
+	for (const MaterialBindingTable& table : this->bindingTables)
+	{
+		if (table.programID == programID && table.textureCount == this->textures.size())
+		{
+			return table;
+		}
+	}
+	std::erase_if(this->bindingTables, [programID](const MaterialBindingTable& table) { return table.programID == programID; });
+
+	std::array<unsigned int, 5> typeCount = {};
+
+	MaterialBindingTable table;
+	table.programID = programID;
+	table.textureCount = this->textures.size();
+	for (const Texture& texture : this->textures)
+	{
+		std::size_t type = std::find(TEXTURE_TYPES.begin(), TEXTURE_TYPES.end(), texture.Type) - TEXTURE_TYPES.begin();
+		unsigned int number = type < TEXTURE_TYPES.size() ? typeCount[type]++ : 0;
+		table.textures.push_back({ type == CUBE_MAP_TYPE ? (GLenum)GL_TEXTURE_CUBE_MAP : (GLenum)GL_TEXTURE_2D,
+			glGetUniformLocation(programID, (texture.Type + std::to_string(number)).c_str()) });
+	}
 
-	bool cubeMapBound = false;
-	for (unsigned int i = 0; i < this->textures.size(); i++)
+	if (typeCount[CUBE_MAP_TYPE] == 0)
 	{
-		glCall(glActiveTexture, GL_TEXTURE0 + i);
+		table.emptyCubeMapID = Loader::createEmptyCubeMap().ID;
+		table.emptyCubeMapLocation = glGetUniformLocation(programID, "texture_cubeMap0");
+	}
 
-		std::string name = this->textures[i].Type;
-		std::string number = std::to_string(textureCount[name]++);
+	for (std::size_t i = 0; i < TEXTURE_TYPES.size(); i++)
+	{
+		table.boundLocations[i] = glGetUniformLocation(programID, (TEXTURE_TYPES[i].substr(8) + "Bound").c_str());
+		table.boundValues[i] = typeCount[i] > 0;
+	}
 
-		glCall(glUniform1i, glGetUniformLocation(programID, (name + number).c_str()), i);
-		if (name == "texture_cubeMap")
+	this->bindingTables.push_back(table);
+	return this->bindingTables.back();
+}
+
+void Mesh::bindTextures(GLuint programID, GLuint cubeMap)
+{
+	const MaterialBindingTable& table = this->getBindingTable(programID);
+	for (unsigned int i = 0; i < table.textures.size(); i++)
+	{
+		OpenGLState::activeTexture(GL_TEXTURE0 + i);
+		if (table.textures[i].samplerLocation != -1)
 		{
-			glCall(glBindTexture, GL_TEXTURE_CUBE_MAP, textures[i].ID);
-			cubeMapBound = true;
+			glCall(glUniform1i, table.textures[i].samplerLocation, i);
 		}
-		else
+		OpenGLState::bindTexture(table.textures[i].target, cubeMap != 0 && table.textures[i].target == GL_TEXTURE_CUBE_MAP ? cubeMap : this->textures[i].ID);
+	}
+
+	if (table.emptyCubeMapID != 0)
+	{
+		GLint unit = (GLint)table.textures.size();
+		OpenGLState::activeTexture(GL_TEXTURE0 + unit);
+		if (table.emptyCubeMapLocation != -1)
 		{
-			glCall(glBindTexture, GL_TEXTURE_2D, textures[i].ID);
+			glCall(glUniform1i, table.emptyCubeMapLocation, unit);
 		}
+		OpenGLState::bindTexture(GL_TEXTURE_CUBE_MAP, cubeMap != 0 ? cubeMap : table.emptyCubeMapID);
+	}
 
-		// bind empty cubemap if none exists
-		if (!cubeMapBound && i == this->textures.size() - 1)
+	for (std::size_t i = 0; i < table.boundLocations.size(); i++)
+	{
+		if (table.boundLocations[i] != -1)
 		{
-			Texture empty = Loader::createEmptyCubeMap();
-			glCall(glActiveTexture, GL_TEXTURE0 + i + 1);
-			glCall(glUniform1i, glGetUniformLocation(programID, "texture_cubeMap0"), i + 1);
-			glCall(glBindTexture, GL_TEXTURE_CUBE_MAP, empty.ID);
+			// a placement's cube map counts as bound even when the mesh has none
+			glCall(glUniform1i, table.boundLocations[i], table.boundValues[i] || (cubeMap != 0 && i == CUBE_MAP_TYPE));
 		}
 	}
+}
+
+void Mesh::bindObject(const glm::mat4& transformationMatrix)
+{
+	ObjectUniforms object = UniformBuffers::createObject(transformationMatrix, this->quantization);
+	UniformBuffers::bindObjects(UniformBuffers::pushObjects({ &object, 1 }), 1);
+}
 
-	for (const auto& [name, amount] : textureCount)
+void Mesh::bindObjects(std::span<const glm::mat4> transformationMatrices)
+{
+	this->instanceObjects.clear();
+	for (const glm::mat4& transformationMatrix : transformationMatrices)
 	{
-		bool isBound = (amount > 0);
-		std::string boundName = name.substr(8) + "Bound";
-		glCall(glUniform1i, glGetUniformLocation(programID, boundName.c_str()), isBound);
+		this->instanceObjects.push_back(UniformBuffers::createObject(transformationMatrix, this->quantization));
 	}
+	UniformBuffers::bindObjects(UniformBuffers::pushObjects(this->instanceObjects), this->instanceObjects.size());
 }
 
-void Mesh::draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix)
+void Mesh::bindVertexArray()
 {
-	this->bindTextures(shader.getProgramID());
+	OpenGLState::bindVertexArray(this->vao);
+	OpenGLState::bindBufferRange(GL_UNIFORM_BUFFER, 0, this->uniformBlockIndex, 0, sizeof(Material));
+}
 
-	shader.loadTransformationMatrix(transformationMatrix);
-	shader.loadProjectionMatrix(projectionMatrix);
-	shader.loadViewMatrix();
+bool Mesh::cullMeshlets(const unsigned int lod, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix)
+{
+	const MeshLod& level = this->lods[std::min((std::size_t)lod, this->lods.size() - 1)];
+	if (level.indexOffset != 0 || this->meshlets.empty() || !Config::Models::CLUSTER_CULLING)
+	{
+		return false;
+	}
 
-	glCall(glBindVertexArray, this->vao);
-	glCall(glBindBufferRange, GL_UNIFORM_BUFFER, 0, this->uniformBlockIndex, 0, sizeof(Material));
-	glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-	glCall(glBindVertexArray, 0);
-	glCall(glActiveTexture, GL_TEXTURE0);
+	// culling happens in model space, so the planes come from the full matrix and the camera is brought into the model
+	std::array<glm::vec4, 6> frustumPlanes = MeshletBuilder::getFrustumPlanes(projectionMatrix * Camera::viewMatrix * transformationMatrix);
+	glm::vec3 cameraPosition = glm::vec3(glm::inverse(transformationMatrix) * glm::vec4(Camera::position, 1.0f));
+
+	// meshlets are consecutive in the index buffer, neighbouring visible ones are merged into one range
+	this->visibleCounts.clear();
+	this->visibleFirsts.clear();
+	std::uint32_t rangeEnd = std::numeric_limits<std::uint32_t>::max();
+	std::size_t visibleMeshlets = 0;
+	for (const Meshlet& meshlet : this->meshlets)
+	{
+		if (!MeshletBuilder::isVisible(meshlet, cameraPosition, frustumPlanes))
+		{
+			continue;
+		}
+
+		if (meshlet.indexOffset == rangeEnd)
+		{
+			this->visibleCounts.back() += meshlet.indexCount;
+		}
+		else
+		{
+			this->visibleCounts.push_back(meshlet.indexCount);
+			this->visibleFirsts.push_back(this->geometry.firstIndex + meshlet.indexOffset);
+		}
+		rangeEnd = meshlet.indexOffset + meshlet.indexCount;
+		visibleMeshlets++;
+	}
+
+	RenderStats::current.clustersTested += this->meshlets.size();
+	RenderStats::current.clustersCulled += this->meshlets.size() - visibleMeshlets;
+	return true;
 }
 
-void Mesh::draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix)
+void Mesh::drawLod(const unsigned int lod, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix)
+{
+	const MeshLod& level = this->lods[std::min((std::size_t)lod, this->lods.size() - 1)];
+	GLenum indexType = GeometryArena::getIndexType(this->geometry.pool);
+	std::size_t indexSize = GeometryArena::getIndexSize(this->geometry.pool);
+	if (!this->cullMeshlets(lod, transformationMatrix, projectionMatrix))
+	{
+		glDrawElementsBaseVertex(GL_TRIANGLES, level.indexCount, indexType, (void*)((this->geometry.firstIndex + level.indexOffset) * indexSize), this->geometry.baseVertex);
+		RenderStats::current.drawCalls++;
+		RenderStats::current.instances++;
+		RenderStats::current.triangles += level.indexCount / 3;
+		return;
+	}
+
+	std::size_t triangles = 0;
+	this->visibleOffsets.clear();
+	this->visibleBaseVertices.assign(this->visibleCounts.size(), this->geometry.baseVertex);
+	for (std::size_t i = 0; i < this->visibleCounts.size(); i++)
+	{
+		this->visibleOffsets.push_back((const void*)(this->visibleFirsts[i] * indexSize));
+		triangles += this->visibleCounts[i] / 3;
+	}
+
+	if (!this->visibleCounts.empty())
+	{
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, this->visibleCounts.data(), indexType, this->visibleOffsets.data(), (GLsizei)this->visibleCounts.size(),
+			this->visibleBaseVertices.data());
+		RenderStats::current.drawCalls++;
+		RenderStats::current.instances++;
+		RenderStats::current.triangles += triangles;
+	}
+}
+
+void Mesh::drawLodInstanced(const unsigned int lod, const std::size_t instanceCount)
+{
+	const MeshLod& level = this->lods[std::min((std::size_t)lod, this->lods.size() - 1)];
+	std::size_t indexSize = GeometryArena::getIndexSize(this->geometry.pool);
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, level.indexCount, GeometryArena::getIndexType(this->geometry.pool),
+		(void*)((this->geometry.firstIndex + level.indexOffset) * indexSize), (GLsizei)instanceCount, this->geometry.baseVertex);
+	RenderStats::current.drawCalls++;
+	RenderStats::current.instances += instanceCount;
+	RenderStats::current.triangles += level.indexCount / 3 * instanceCount;
+}
+
+std::size_t Mesh::appendCommands(const unsigned int lod, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const GLuint instanceCount,
+	const GLuint baseInstance, std::vector<DrawElementsIndirectCommand>& commands)
+{
+	const MeshLod& level = this->lods[std::min((std::size_t)lod, this->lods.size() - 1)];
+	if (instanceCount > 1 || !this->cullMeshlets(lod, transformationMatrix, projectionMatrix))
+	{
+		commands.push_back({ level.indexCount, instanceCount, this->geometry.firstIndex + level.indexOffset, (GLint)this->geometry.baseVertex, baseInstance });
+		return (std::size_t)level.indexCount / 3 * instanceCount;
+	}
+
+	std::size_t triangles = 0;
+	for (std::size_t i = 0; i < this->visibleCounts.size(); i++)
+	{
+		commands.push_back({ (GLuint)this->visibleCounts[i], 1, this->visibleFirsts[i], (GLint)this->geometry.baseVertex, baseInstance });
+		triangles += this->visibleCounts[i] / 3;
+	}
+	return triangles;
+}
+
+unsigned int Mesh::getGeometryPool() const
+{
+	return this->geometry.pool;
+}
+
+void Mesh::draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const unsigned int lod)
 {
 	this->bindTextures(shader.getProgramID());
+	this->bindObject(transformationMatrix);
+
+	this->bindVertexArray();
+	this->drawLod(lod, transformationMatrix, projectionMatrix);
+}
+
+void Mesh::draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const unsigned int lod, const GLuint cubeMap)
+{
+	this->bindTextures(shader.getProgramID(), cubeMap);
 	
 	shader.loadMaterialInfo(this->mat);
-	shader.loadTransformationMatrix(transformationMatrix);
-	shader.loadProjectionMatrix(projectionMatrix);
-	shader.loadViewMatrix();
+	this->bindObject(transformationMatrix);
 
-	glCall(glBindVertexArray, this->vao);
-	glCall(glBindBufferRange, GL_UNIFORM_BUFFER, 0, this->uniformBlockIndex, 0, sizeof(Material));
-	glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-	glCall(glBindVertexArray, 0);
-	glCall(glActiveTexture, GL_TEXTURE0);
+	this->bindVertexArray();
+	this->drawLod(lod, transformationMatrix, projectionMatrix);
 }
 
-void Mesh::draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const std::vector<Light>& lights)
+void Mesh::draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const unsigned int lod, const GLuint cubeMap)
 {
-	this->bindTextures(shader.getProgramID());
+	this->bindTextures(shader.getProgramID(), cubeMap);
 
 	shader.loadMaterialInfo(this->mat);
-	shader.loadTransformationMatrix(transformationMatrix);
-	shader.loadProjectionMatrix(projectionMatrix);
-	shader.loadViewMatrix();
+	this->bindObject(transformationMatrix);
+
+	this->bindVertexArray();
+	this->drawLod(lod, transformationMatrix, projectionMatrix);
+}
 
-	shader.loadLights(lights);
-	shader.loadCameraPosition();
+void Mesh::drawInstanced(BSDFShader shader, std::span<const glm::mat4> transformationMatrices, const unsigned int lod)
+{
+	this->bindTextures(shader.getProgramID());
 
-	glCall(glBindVertexArray, this->vao);
-	glCall(glBindBufferRange, GL_UNIFORM_BUFFER, 0, this->uniformBlockIndex, 0, sizeof(Material));
-	glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-	glCall(glBindVertexArray, 0);
-	glCall(glActiveTexture, GL_TEXTURE0);
+	shader.loadMaterialInfo(this->mat);
+	this->bindObjects(transformationMatrices);
+
+	this->bindVertexArray();
+	this->drawLodInstanced(lod, transformationMatrices.size());
 }
 
-void Mesh::setCubeMap(Texture cubeMapTexture)
+void Mesh::drawInstanced(ReflectionShader shader, std::span<const glm::mat4> transformationMatrices, const unsigned int lod)
 {
-	for (Texture& texture : this->textures)
-	{
-		if (texture.Type == "texture_cubeMap")
-		{
-			texture.ID = cubeMapTexture.ID;
-			return;
-		}
-	}
-	this->textures.push_back(cubeMapTexture);
+	this->bindTextures(shader.getProgramID());
+
+	shader.loadMaterialInfo(this->mat);
+	this->bindObjects(transformationMatrices);
+
+	this->bindVertexArray();
+	this->drawLodInstanced(lod, transformationMatrices.size());
 }
\ No newline at end of file
@@ -5,43 +5,124 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <array>
+#include <span>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "ReflectionShader.h"
+#include "UniformBuffers.h"
+#include "GeometryArena.h"
 #include "BSDFShader.h"
 #include "Material.h"
 #include "Texture.h"
 #include "Shader.h"
+#include "MeshData.h"
 #include "Vertex.h"
 
+// texture unit i of a binding table samples the mesh's i-th texture, the id is read at bind time so swapped textures still apply
+struct TextureBinding
+{
+	GLenum target;
+	GLint samplerLocation;
+};
+
+// everything bindTextures needs for one shader program, resolved on the first draw with that program
+struct MaterialBindingTable
+{
+	GLuint programID = 0;
+	std::size_t textureCount = 0;
+	std::vector<TextureBinding> textures;
+
+	// shaders always sample a cube map, meshes without one get the placement's or an empty one
+	GLuint emptyCubeMapID = 0;
+	GLint emptyCubeMapLocation = -1;
+
+	// diffuse, specular, normal, displacement and cube map flags
+	std::array<GLint, 5> boundLocations;
+	std::array<GLint, 5> boundValues;
+};
+
 class Mesh
 {
 private:
-	unsigned int vbo = NULL;
-	unsigned int ebo = NULL;
+	GeometryAllocation geometry;
+
+	// ranges of the visible meshlets in arena indices, kept between draws to avoid reallocating
+	std::vector<GLsizei> visibleCounts;
+	std::vector<GLuint> visibleFirsts;
+	std::vector<const void*> visibleOffsets;
+	std::vector<GLint> visibleBaseVertices;
+
+	// staging for instanced draws outside the render queue
+	std::vector<ObjectUniforms> instanceObjects;
+
+	void setupMesh(const MeshStreams& streams);
 
-	void setupMesh();
+	std::vector<MaterialBindingTable> bindingTables;
 
-	void bindTextures(GLuint programID);
+	const MaterialBindingTable& getBindingTable(GLuint programID);
+
+	// fills the visible ranges of level 0, false when the level is drawn whole
+	bool cullMeshlets(const unsigned int lod, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix);
 
 public:
-	std::vector<Vertex> vertices;
+	// cpu side copy kept for occluders and physics shapes, the only readers after the upload, so only positions are kept
+	// of the vertices while the indices cover every level
+	std::vector<glm::vec3> positions;
 	std::vector<unsigned int> indices;
+	std::vector<MeshLod> lods;
+	std::vector<Meshlet> meshlets;
 	std::vector<Texture> textures;
 	Material mat;
+	VertexQuantization quantization;
+	// shared by every mesh in the same arena pool
 	unsigned int vao = NULL;
 	unsigned int uniformBlockIndex;
 	unsigned int numFaces;
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	glm::vec3 sphereCenter;
+	float sphereRadius;
+
+	// uploads the streams as given (e.g. straight from a mapped cooked mesh), without lods the whole index list is the only level
+	Mesh(const MeshStreams& streams, const std::vector<Texture>& textures, const Material& mat, const unsigned int numFaces,
+		std::span<const MeshLod> lods = {}, std::span<const Meshlet> meshlets = {});
+
+	void draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const unsigned int lod = 0);
+
+	void draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const unsigned int lod = 0, const GLuint cubeMap = 0);
+
+	void draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const unsigned int lod = 0, const GLuint cubeMap = 0);
+
+	// one draw call for every transform, all copies use the same level
+	void drawInstanced(BSDFShader shader, std::span<const glm::mat4> transformationMatrices, const unsigned int lod = 0);
+
+	void drawInstanced(ReflectionShader shader, std::span<const glm::mat4> transformationMatrices, const unsigned int lod = 0);
+
+	// a non zero cube map is sampled instead of the mesh's own or the empty one
+	void bindTextures(GLuint programID, GLuint cubeMap = 0);
+
+	// single entry object block for draws outside the render queue
+	void bindObject(const glm::mat4& transformationMatrix);
+
+	// one object block entry per transform, read through gl_InstanceID
+	void bindObjects(std::span<const glm::mat4> transformationMatrices);
 
-	Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures, const Material& mat, const unsigned int numFaces);
+	// vertex array and material block, enough for drawLod once the shader's uniforms are loaded
+	void bindVertexArray();
 
-	void draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix);
+	// level 0 is drawn meshlet by meshlet when cluster culling is enabled
+	void drawLod(const unsigned int lod, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix);
 
-	void draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix);
+	// whole level for every instance, meshlets are culled per transform so they are not used here
+	void drawLodInstanced(const unsigned int lod, const std::size_t instanceCount);
 
-	void draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const std::vector<Light>& lights);
+	// the same draws as drawLod or drawLodInstanced as indirect commands, returns the triangles they cover
+	std::size_t appendCommands(const unsigned int lod, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const GLuint instanceCount,
+		const GLuint baseInstance, std::vector<DrawElementsIndirectCommand>& commands);
 
-	void setCubeMap(Texture cubeMapTexture);
+	// meshes in the same pool share a vertex array and can be drawn by one indirect call
+	unsigned int getGeometryPool() const;
 };
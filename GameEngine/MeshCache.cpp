@@ -0,0 +1,324 @@
+#include "MeshCache.h"
+
+#include <spdlog/spdlog.h>
+
+#include <type_traits>
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <format>
+
+#include "MeshOptimizer.h"
+#include "VertexPacker.h"
+#include "AssetCache.h"
+#include "Config.h"
+#include "Model.h"
+
+namespace
+{
+	struct FileHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t meshCount;
+		std::uint32_t vertexSize;
+	};
+
+	struct MeshHeader
+	{
+		std::uint32_t vertexCount;
+		std::uint32_t indexCount;
+		std::uint32_t numFaces;
+		std::uint32_t textureCount;
+		std::uint32_t lodCount;
+		std::uint32_t meshletCount;
+		std::uint64_t vertexOffset;
+		std::uint64_t indexOffset;
+		std::uint64_t lodOffset;
+		std::uint64_t meshletOffset;
+		std::uint64_t textureOffset;
+		std::uint32_t indexSize;
+		VertexQuantization quantization;
+		Material mat;
+	};
+
+	static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex must be trivially copyable to be cooked");
+	static_assert(std::is_trivially_copyable_v<PackedVertex>, "PackedVertex must be trivially copyable to be cooked");
+	static_assert(std::is_trivially_copyable_v<VertexQuantization>, "VertexQuantization must be trivially copyable to be cooked");
+	static_assert(std::is_trivially_copyable_v<Material>, "Material must be trivially copyable to be cooked");
+	static_assert(std::is_trivially_copyable_v<MeshLod>, "MeshLod must be trivially copyable to be cooked");
+	static_assert(std::is_trivially_copyable_v<Meshlet>, "Meshlet must be trivially copyable to be cooked");
+
+	// offset of blobs inside the file, keeps vertex and index data aligned for direct use from the mapping
+	const std::size_t BLOB_ALIGNMENT = 16;
+
+	void append(std::vector<unsigned char>& blob, const void* data, const std::size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		blob.insert(blob.end(), bytes, bytes + size);
+	}
+
+	void appendString(std::vector<unsigned char>& blob, const std::string& value)
+	{
+		std::uint32_t length = (std::uint32_t)value.size();
+		append(blob, &length, sizeof(length));
+		append(blob, value.data(), value.size());
+	}
+
+	void alignBlob(std::vector<unsigned char>& blob)
+	{
+		blob.resize((blob.size() + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1), 0);
+	}
+
+	// cooked vertices are stored in the layout the current settings upload
+	std::uint32_t getVertexSize()
+	{
+		return Config::Models::PACKED_VERTICES ? sizeof(PackedVertex) : sizeof(Vertex);
+	}
+
+	bool readString(const unsigned char* data, const std::size_t size, std::size_t& offset, std::string& value)
+	{
+		std::uint32_t length;
+		if (offset + sizeof(length) > size)
+		{
+			return false;
+		}
+		std::memcpy(&length, data + offset, sizeof(length));
+		offset += sizeof(length);
+
+		if (offset + length > size)
+		{
+			return false;
+		}
+		value.assign(reinterpret_cast<const char*>(data + offset), length);
+		offset += length;
+		return true;
+	}
+}
+
+const std::uint32_t MeshCache::MAGIC = 0x534D4547; // "GEMS"
+const std::uint32_t MeshCache::VERSION = 6;
+
+std::string MeshCache::getCookedPath(const std::string& path)
+{
+	std::string key = AssetCache::getKey(MeshCache::getSources(path), std::format("assimp={:x};optimize={};lods={:d};packed={};shortIndices={:d}",
+		Model::IMPORT_FLAGS, Config::Models::OPTIMIZE_MESHES, Config::Models::LOD_COUNT, Config::Models::PACKED_VERTICES, MeshOptimizer::SHORT_INDEX_VERTICES),
+		MeshCache::VERSION);
+	return key.empty() ? "" : AssetCache::getEntryPath(key, ".mesh");
+}
+
+std::vector<std::string> MeshCache::getSources(const std::string& path)
+{
+	// material libraries share the stem of the model and are part of the cache key as well
+	std::vector<std::string> sources = { path };
+	std::filesystem::path materialPath = std::filesystem::path(path).replace_extension(".mtl");
+	if (materialPath.string() != path && std::filesystem::exists(materialPath))
+	{
+		sources.push_back(materialPath.string());
+	}
+	return sources;
+}
+
+bool MeshCache::isCookedFileValid(const std::string& path)
+{
+	// the entry name already covers source contents and import settings, the header only guards against foreign files
+	FileHeader header;
+	std::ifstream in(MeshCache::getCookedPath(path), std::ios::binary);
+	bool valid = in.is_open() && in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+		header.magic == MeshCache::MAGIC && header.version == MeshCache::VERSION && header.vertexSize == getVertexSize();
+
+	if (valid)
+	{
+		AssetCache::recordHit();
+	}
+	else
+	{
+		AssetCache::recordMiss();
+	}
+	return valid;
+}
+
+MeshStreams MeshCache::encode(const MeshData& mesh, std::vector<PackedVertex>& packedVertices, std::vector<std::uint16_t>& shortIndices)
+{
+	MeshStreams streams;
+	streams.vertices = mesh.vertices.data();
+	streams.vertexCount = mesh.vertices.size();
+	if (Config::Models::PACKED_VERTICES)
+	{
+		streams.quantization = VertexPacker::pack(mesh.vertices, packedVertices);
+		streams.vertices = packedVertices.data();
+	}
+
+	// half the index bandwidth whenever every vertex is addressable with 16 bits
+	streams.indices = mesh.indices.data();
+	streams.indexCount = mesh.indices.size();
+	if (MeshOptimizer::fitsShortIndices(mesh.vertices.size()))
+	{
+		shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+		streams.indexSize = sizeof(std::uint16_t);
+		streams.indices = shortIndices.data();
+	}
+	return streams;
+}
+
+bool MeshCache::save(const std::string& path, const std::vector<MeshData>& meshes)
+{
+	std::vector<unsigned char> blob;
+
+	FileHeader header;
+	header.magic = MeshCache::MAGIC;
+	header.version = MeshCache::VERSION;
+	header.meshCount = (std::uint32_t)meshes.size();
+	header.vertexSize = getVertexSize();
+	append(blob, &header, sizeof(header));
+
+	// reserve mesh table, patched once blob offsets are known
+	std::size_t tableOffset = blob.size();
+	std::vector<MeshHeader> meshHeaders(meshes.size());
+	blob.resize(blob.size() + meshHeaders.size() * sizeof(MeshHeader), 0);
+
+	std::vector<PackedVertex> packedVertices;
+	std::vector<std::uint16_t> shortIndices;
+	for (std::size_t i = 0; i < meshes.size(); i++)
+	{
+		const MeshData& mesh = meshes[i];
+		MeshStreams streams = MeshCache::encode(mesh, packedVertices, shortIndices);
+
+		MeshHeader meshHeader{};
+		meshHeader.vertexCount = (std::uint32_t)streams.vertexCount;
+		meshHeader.indexCount = (std::uint32_t)streams.indexCount;
+		meshHeader.indexSize = streams.indexSize;
+		meshHeader.numFaces = mesh.numFaces;
+		meshHeader.textureCount = (std::uint32_t)mesh.textures.size();
+		meshHeader.lodCount = (std::uint32_t)mesh.lods.size();
+		meshHeader.meshletCount = (std::uint32_t)mesh.meshlets.size();
+		meshHeader.mat = mesh.mat;
+		meshHeader.quantization = streams.quantization;
+
+		alignBlob(blob);
+		meshHeader.vertexOffset = blob.size();
+		append(blob, streams.vertices, streams.vertexCount * header.vertexSize);
+
+		alignBlob(blob);
+		meshHeader.indexOffset = blob.size();
+		append(blob, streams.indices, streams.indexCount * streams.indexSize);
+
+		alignBlob(blob);
+		meshHeader.lodOffset = blob.size();
+		append(blob, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+
+		alignBlob(blob);
+		meshHeader.meshletOffset = blob.size();
+		append(blob, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+
+		meshHeader.textureOffset = blob.size();
+		for (const TextureReference& texture : mesh.textures)
+		{
+			appendString(blob, texture.Type);
+			appendString(blob, texture.Path);
+		}
+		meshHeaders[i] = meshHeader;
+	}
+	std::memcpy(blob.data() + tableOffset, meshHeaders.data(), meshHeaders.size() * sizeof(MeshHeader));
+
+	// write to a temporary file first so a partially written file is never picked up as valid
+	std::string cookedPath = MeshCache::getCookedPath(path);
+	if (cookedPath.empty() || !AssetCache::prepareEntry(cookedPath))
+	{
+		spdlog::error("Could not write cooked mesh for '{}'", path);
+		return false;
+	}
+	std::string temporaryPath = AssetCache::getTemporaryPath(cookedPath);
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open() || !out.write(reinterpret_cast<const char*>(blob.data()), blob.size()))
+		{
+			spdlog::error("Could not write cooked mesh '{}'", cookedPath);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	if (error)
+	{
+		spdlog::error("Could not write cooked mesh '{}', {}", cookedPath, error.message());
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	AssetCache::recordWrite();
+	spdlog::debug("Cooked mesh '{}' to '{}' ({:d} bytes)", path, cookedPath, blob.size());
+	return true;
+}
+
+bool MeshCache::load(const MappedFile& file, std::vector<CookedMesh>& meshes)
+{
+	const unsigned char* data = file.getData();
+	const std::size_t size = file.getSize();
+
+	FileHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != MeshCache::MAGIC || header.version != MeshCache::VERSION || header.vertexSize != getVertexSize())
+	{
+		return false;
+	}
+
+	std::size_t tableOffset = sizeof(header);
+	if (tableOffset + (std::size_t)header.meshCount * sizeof(MeshHeader) > size)
+	{
+		return false;
+	}
+
+	meshes.clear();
+	meshes.reserve(header.meshCount);
+	for (std::uint32_t i = 0; i < header.meshCount; i++)
+	{
+		MeshHeader meshHeader;
+		std::memcpy(&meshHeader, data + tableOffset + i * sizeof(MeshHeader), sizeof(MeshHeader));
+
+		if ((meshHeader.indexSize != sizeof(std::uint16_t) && meshHeader.indexSize != sizeof(std::uint32_t)) ||
+			meshHeader.quantization.packed != Config::Models::PACKED_VERTICES ||
+			meshHeader.vertexOffset + (std::uint64_t)meshHeader.vertexCount * header.vertexSize > size ||
+			meshHeader.indexOffset + (std::uint64_t)meshHeader.indexCount * meshHeader.indexSize > size ||
+			meshHeader.lodOffset + (std::uint64_t)meshHeader.lodCount * sizeof(MeshLod) > size ||
+			meshHeader.meshletOffset + (std::uint64_t)meshHeader.meshletCount * sizeof(Meshlet) > size ||
+			meshHeader.vertexOffset % alignof(Vertex) != 0 || meshHeader.indexOffset % meshHeader.indexSize != 0 || meshHeader.lodOffset % alignof(MeshLod) != 0 ||
+			meshHeader.meshletOffset % alignof(Meshlet) != 0)
+		{
+			return false;
+		}
+
+		CookedMesh mesh;
+		mesh.streams.quantization = meshHeader.quantization;
+		mesh.streams.vertices = data + meshHeader.vertexOffset;
+		mesh.streams.vertexCount = meshHeader.vertexCount;
+		mesh.streams.indexSize = meshHeader.indexSize;
+		mesh.streams.indices = data + meshHeader.indexOffset;
+		mesh.streams.indexCount = meshHeader.indexCount;
+		mesh.lods = std::span<const MeshLod>(reinterpret_cast<const MeshLod*>(data + meshHeader.lodOffset), meshHeader.lodCount);
+		mesh.meshlets = std::span<const Meshlet>(reinterpret_cast<const Meshlet*>(data + meshHeader.meshletOffset), meshHeader.meshletCount);
+		mesh.mat = meshHeader.mat;
+		mesh.numFaces = meshHeader.numFaces;
+
+		std::size_t textureOffset = meshHeader.textureOffset;
+		for (std::uint32_t j = 0; j < meshHeader.textureCount; j++)
+		{
+			TextureReference texture;
+			if (!readString(data, size, textureOffset, texture.Type) || !readString(data, size, textureOffset, texture.Path))
+			{
+				return false;
+			}
+			mesh.textures.push_back(texture);
+		}
+
+		meshes.push_back(mesh);
+	}
+
+	return true;
+}
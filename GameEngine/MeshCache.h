@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <span>
+
+#include "MappedFile.h"
+#include "MeshData.h"
+
+// view of a mesh inside a mapped cooked file, the streams are already in gpu layout and point directly into the mapping
+struct CookedMesh
+{
+	MeshStreams streams;
+	std::span<const MeshLod> lods;
+	std::span<const Meshlet> meshlets;
+	std::vector<TextureReference> textures;
+	Material mat;
+	unsigned int numFaces;
+};
+
+struct MeshCache
+{
+	static const std::uint32_t MAGIC;
+	static const std::uint32_t VERSION;
+
+	// cache entry for a model, empty if the model cannot be read
+	static std::string getCookedPath(const std::string& path);
+
+	static std::vector<std::string> getSources(const std::string& path);
+
+	static bool isCookedFileValid(const std::string& path);
+
+	// gpu layout of an imported mesh for the current settings, the streams point into the mesh or the given storage
+	static MeshStreams encode(const MeshData& mesh, std::vector<PackedVertex>& packedVertices, std::vector<std::uint16_t>& shortIndices);
+
+	static bool save(const std::string& path, const std::vector<MeshData>& meshes);
+
+	static bool load(const MappedFile& file, std::vector<CookedMesh>& meshes);
+};
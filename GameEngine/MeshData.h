@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "Material.h"
+#include "Vertex.h"
+
+struct TextureReference
+{
+	std::string Type;
+	std::string Path;
+};
+
+// vertex and index streams in the layout the gpu reads them, PackedVertex when the quantization is packed and Vertex
+// otherwise, indices are indexSize bytes wide
+struct MeshStreams
+{
+	VertexQuantization quantization;
+	const void* vertices = nullptr;
+	std::size_t vertexCount = 0;
+	std::uint32_t indexSize = sizeof(std::uint32_t);
+	const void* indices = nullptr;
+	std::size_t indexCount = 0;
+};
+
+// range of a mesh's index list drawn at one level of detail, level 0 covers the full detail triangles
+struct MeshLod
+{
+	std::uint32_t indexOffset;
+	std::uint32_t indexCount;
+	float error;
+};
+
+// cluster of consecutive full detail triangles with bounds for culling, the cone holds every triangle normal and is
+// disabled when its cutoff is 1
+struct Meshlet
+{
+	std::uint32_t indexOffset;
+	std::uint32_t indexCount;
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	float coneCutoff;
+};
+
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<MeshLod> lods;
+	std::vector<Meshlet> meshlets;
+	std::vector<TextureReference> textures;
+	Material mat;
+	unsigned int numFaces;
+};
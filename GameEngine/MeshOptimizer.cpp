@@ -0,0 +1,321 @@
+#include "MeshOptimizer.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdint>
+
+#include "AssetCache.h"
+
+const unsigned int MeshOptimizer::CACHE_SIZE = 16;
+const float MeshOptimizer::OVERDRAW_THRESHOLD = 1.05f;
+const std::size_t MeshOptimizer::SHORT_INDEX_VERTICES = 65536;
+
+namespace
+{
+	struct VertexHash
+	{
+		std::size_t operator()(const Vertex& vertex) const
+		{
+			return (std::size_t)AssetCache::hash(&vertex, sizeof(Vertex));
+		}
+	};
+
+	// bitwise so welding never merges vertices that differ in any attribute
+	struct VertexEqual
+	{
+		bool operator()(const Vertex& a, const Vertex& b) const
+		{
+			return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+
+	// misses for each triangle of a fifo cache run over the index list
+	std::vector<unsigned char> simulateCache(const std::vector<unsigned int>& indices, const std::size_t vertexCount)
+	{
+		std::vector<std::size_t> cachedAt(vertexCount, 0);
+		std::vector<unsigned char> misses(indices.size() / 3, 0);
+		std::size_t time = MeshOptimizer::CACHE_SIZE + 1;
+		for (std::size_t i = 0; i < indices.size(); i++)
+		{
+			unsigned int vertex = indices[i];
+			if (time - cachedAt[vertex] > MeshOptimizer::CACHE_SIZE)
+			{
+				cachedAt[vertex] = time++;
+				misses[i / 3]++;
+			}
+		}
+		return misses;
+	}
+}
+
+MeshOptimizerStats MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	MeshOptimizerStats stats;
+	stats.verticesBefore = vertices.size();
+	stats.acmrBefore = MeshOptimizer::getACMR(indices, vertices.size());
+
+	MeshOptimizer::weldVertices(vertices, indices);
+	MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+	MeshOptimizer::optimizeOverdraw(indices, vertices);
+	MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+	stats.verticesAfter = vertices.size();
+	stats.acmrAfter = MeshOptimizer::getACMR(indices, vertices.size());
+	return stats;
+}
+
+void MeshOptimizer::weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+	unique.reserve(vertices.size());
+
+	std::vector<unsigned int> remap(vertices.size());
+	std::vector<Vertex> welded;
+	welded.reserve(vertices.size());
+	for (std::size_t i = 0; i < vertices.size(); i++)
+	{
+		auto [it, inserted] = unique.try_emplace(vertices[i], (unsigned int)welded.size());
+		if (inserted)
+		{
+			welded.push_back(vertices[i]);
+		}
+		remap[i] = it->second;
+	}
+
+	for (unsigned int& index : indices)
+	{
+		index = remap[index];
+	}
+	vertices = std::move(welded);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, const std::size_t vertexCount)
+{
+	std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// triangles around each vertex as offsets into one flat list
+	std::vector<unsigned int> liveTriangles(vertexCount, 0);
+	for (unsigned int index : indices)
+	{
+		liveTriangles[index]++;
+	}
+	std::vector<std::size_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (std::size_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+	}
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<std::size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (std::size_t i = 0; i < indices.size(); i++)
+	{
+		adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	std::vector<std::size_t> cachedAt(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+
+	std::size_t time = MeshOptimizer::CACHE_SIZE + 1;
+	std::size_t cursor = 0;
+	long long fanning = 0;
+	while (fanning >= 0)
+	{
+		// emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (std::size_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+		{
+			unsigned int triangle = adjacency[a];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			emitted[triangle] = true;
+
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned int vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if (time - cachedAt[vertex] > MeshOptimizer::CACHE_SIZE)
+				{
+					cachedAt[vertex] = time++;
+				}
+			}
+		}
+
+		// next fan is the candidate that stays in cache longest while it is processed
+		fanning = -1;
+		long long bestPriority = -1;
+		for (unsigned int vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+			{
+				continue;
+			}
+			long long priority = 0;
+			if (time - cachedAt[vertex] + 2 * liveTriangles[vertex] <= MeshOptimizer::CACHE_SIZE)
+			{
+				priority = (long long)(time - cachedAt[vertex]);
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanning = vertex;
+			}
+		}
+
+		// dead end, fall back to recently used vertices and then to a linear scan
+		while (fanning < 0 && !deadEnds.empty())
+		{
+			unsigned int vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0)
+			{
+				fanning = vertex;
+			}
+		}
+		while (fanning < 0 && cursor < vertexCount)
+		{
+			if (liveTriangles[cursor] > 0)
+			{
+				fanning = (long long)cursor;
+			}
+			cursor++;
+		}
+	}
+
+	indices = std::move(output);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+{
+	std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	std::vector<unsigned char> misses = simulateCache(indices, vertices.size());
+	float meshACMR = (float)std::accumulate(misses.begin(), misses.end(), 0u) / triangleCount;
+
+	// a triangle missing all three vertices restarts the cache and always starts a cluster, otherwise a cluster ends once
+	// it would stay within the threshold of the mesh's efficiency when drawn on its own from a cold cache
+	std::vector<std::size_t> cachedAt(vertices.size(), 0);
+	std::size_t time = MeshOptimizer::CACHE_SIZE + 1;
+	std::vector<std::size_t> clusters;
+	std::size_t clusterMisses = 0, clusterTriangles = 0;
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		bool restart = misses[t] == 3;
+		bool efficient = clusterTriangles > 0 && (float)clusterMisses / clusterTriangles <= meshACMR * MeshOptimizer::OVERDRAW_THRESHOLD;
+		if (t == 0 || restart || efficient)
+		{
+			clusters.push_back(t);
+			clusterMisses = 0;
+			clusterTriangles = 0;
+			time += MeshOptimizer::CACHE_SIZE + 1;
+		}
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int vertex = indices[t * 3 + corner];
+			if (time - cachedAt[vertex] > MeshOptimizer::CACHE_SIZE)
+			{
+				cachedAt[vertex] = time++;
+				clusterMisses++;
+			}
+		}
+		clusterTriangles++;
+	}
+	clusters.push_back(triangleCount);
+
+	std::vector<glm::vec3> centroids(clusters.size() - 1, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusters.size() - 1, glm::vec3(0.0f));
+	std::vector<float> areas(clusters.size() - 1, 0.0f);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (std::size_t c = 0; c + 1 < clusters.size(); c++)
+	{
+		for (std::size_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const glm::vec3& a = vertices[indices[t * 3]].Position;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+			const glm::vec3& c3 = vertices[indices[t * 3 + 2]].Position;
+			glm::vec3 normal = glm::cross(b - a, c3 - a);
+			float area = glm::length(normal);
+			centroids[c] += (a + b + c3) / 3.0f * area;
+			normals[c] += normal;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+		centroids[c] = areas[c] > 0.0f ? centroids[c] / areas[c] : vertices[indices[clusters[c] * 3]].Position;
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+	// clusters facing away from the centre tend to occlude the rest, so they are drawn first
+	std::vector<float> sortKeys(clusters.size() - 1);
+	for (std::size_t c = 0; c < sortKeys.size(); c++)
+	{
+		float length = glm::length(normals[c]);
+		sortKeys[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+	}
+	std::vector<std::size_t> order(sortKeys.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](const std::size_t a, const std::size_t b)
+	{
+		return sortKeys[a] > sortKeys[b];
+	});
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	for (std::size_t c : order)
+	{
+		output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+	indices = std::move(output);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const unsigned int UNUSED = ~0u;
+	std::vector<unsigned int> remap(vertices.size(), UNUSED);
+	std::vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+	for (unsigned int& index : indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = (unsigned int)ordered.size();
+			ordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices = std::move(ordered);
+}
+
+float MeshOptimizer::getACMR(const std::vector<unsigned int>& indices, const std::size_t vertexCount)
+{
+	if (indices.size() < 3)
+	{
+		return 0.0f;
+	}
+	std::vector<unsigned char> misses = simulateCache(indices, vertexCount);
+	return (float)std::accumulate(misses.begin(), misses.end(), 0u) / misses.size();
+}
+
+bool MeshOptimizer::fitsShortIndices(const std::size_t vertexCount)
+{
+	return vertexCount <= MeshOptimizer::SHORT_INDEX_VERTICES;
+}
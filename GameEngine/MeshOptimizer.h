@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Vertex.h"
+
+struct MeshOptimizerStats
+{
+	std::size_t verticesBefore;
+	std::size_t verticesAfter;
+	float acmrBefore;
+	float acmrAfter;
+};
+
+// import time reordering of indexed triangle lists for the gpu's post transform cache, overdraw and vertex fetch
+struct MeshOptimizer
+{
+	// fifo size used for reordering and for the reported average cache miss ratio
+	static const unsigned int CACHE_SIZE;
+
+	// clusters are only split while they stay within this factor of the mesh's cache efficiency
+	static const float OVERDRAW_THRESHOLD;
+
+	// meshes with at most this many vertices are drawn with 16 bit indices
+	static const std::size_t SHORT_INDEX_VERTICES;
+
+	// runs every step below in order
+	static MeshOptimizerStats optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+	static void weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+	// tipsify, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander, Nehab, Barczak 2007)
+	static void optimizeVertexCache(std::vector<unsigned int>& indices, const std::size_t vertexCount);
+
+	// expects cache optimized indices, keeps clusters intact and draws the outward facing ones first
+	static void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+	// renumbers vertices in order of first use and drops unreferenced ones
+	static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+	// average cache misses per triangle, 3 is no reuse and 0.5 is the limit for large regular meshes
+	static float getACMR(const std::vector<unsigned int>& indices, const std::size_t vertexCount);
+
+	static bool fitsShortIndices(const std::size_t vertexCount);
+};
@@ -0,0 +1,341 @@
+#include "MeshSimplifier.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <queue>
+#include <cmath>
+
+#include "MeshOptimizer.h"
+
+const float MeshSimplifier::MIN_NORMAL_DOT = 0.2f;
+const float MeshSimplifier::MIN_LEVEL_REDUCTION = 0.1f;
+
+namespace
+{
+	// symmetric 4x4 matrix of summed plane equations, evaluates to the sum of squared distances to those planes
+	struct Quadric
+	{
+		double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+		double b2 = 0.0, bc = 0.0, bd = 0.0;
+		double c2 = 0.0, cd = 0.0;
+		double d2 = 0.0;
+
+		void addPlane(const glm::dvec3& normal, const double distance)
+		{
+			a2 += normal.x * normal.x; ab += normal.x * normal.y; ac += normal.x * normal.z; ad += normal.x * distance;
+			b2 += normal.y * normal.y; bc += normal.y * normal.z; bd += normal.y * distance;
+			c2 += normal.z * normal.z; cd += normal.z * distance;
+			d2 += distance * distance;
+		}
+
+		void add(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+		}
+
+		double evaluate(const glm::vec3& point) const
+		{
+			double x = point.x, y = point.y, z = point.z;
+			double error = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+				+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+				+ c2 * z * z + 2.0 * cd * z
+				+ d2;
+			return std::max(error, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		unsigned int from;
+		unsigned int to;
+		unsigned int version;
+
+		bool operator>(const Collapse& other) const
+		{
+			return cost > other.cost;
+		}
+	};
+
+	struct PositionHash
+	{
+		std::size_t operator()(const glm::vec3& position) const
+		{
+			std::uint32_t bits[3];
+			std::memcpy(bits, &position, sizeof(bits));
+			return (std::size_t)bits[0] * 73856093u ^ (std::size_t)bits[1] * 19349663u ^ (std::size_t)bits[2] * 83492791u;
+		}
+	};
+}
+
+void MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<std::size_t>& targetTriangleCounts,
+	std::vector<std::vector<unsigned int>>& levels, std::vector<float>& errors)
+{
+	levels.clear();
+	errors.clear();
+	std::size_t vertexCount = vertices.size();
+	std::size_t triangleCount = indices.size() / 3;
+
+	// vertices split at uv or normal seams share a position, quadrics and topology are tracked per position
+	std::unordered_map<glm::vec3, unsigned int, PositionHash> positionIds;
+	std::vector<unsigned int> positionOf(vertexCount);
+	std::vector<unsigned int> verticesAtPosition;
+	for (std::size_t v = 0; v < vertexCount; v++)
+	{
+		auto [it, inserted] = positionIds.try_emplace(vertices[v].Position, (unsigned int)verticesAtPosition.size());
+		if (inserted)
+		{
+			verticesAtPosition.push_back(0);
+		}
+		positionOf[v] = it->second;
+		verticesAtPosition[it->second]++;
+	}
+
+	// an edge not shared by exactly two triangles is an open border or non manifold
+	std::unordered_map<std::uint64_t, unsigned int> edgeUses;
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			std::uint64_t a = positionOf[indices[t * 3 + corner]], b = positionOf[indices[t * 3 + (corner + 1) % 3]];
+			edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+		}
+	}
+	std::vector<bool> lockedPosition(verticesAtPosition.size(), false);
+	for (const auto& [edge, uses] : edgeUses)
+	{
+		if (uses != 2)
+		{
+			lockedPosition[edge >> 32] = true;
+			lockedPosition[edge & 0xFFFFFFFFu] = true;
+		}
+	}
+
+	std::vector<bool> locked(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; v++)
+	{
+		locked[v] = lockedPosition[positionOf[v]] || verticesAtPosition[positionOf[v]] > 1;
+	}
+
+	std::vector<unsigned int> triangles = indices;
+	std::vector<bool> alive(triangleCount, true);
+	std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+	std::vector<Quadric> quadrics(verticesAtPosition.size());
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		glm::dvec3 a = vertices[triangles[t * 3]].Position, b = vertices[triangles[t * 3 + 1]].Position, c = vertices[triangles[t * 3 + 2]].Position;
+		glm::dvec3 normal = glm::cross(b - a, c - a);
+		double length = glm::length(normal);
+		if (length > 0.0)
+		{
+			normal /= length;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				quadrics[positionOf[triangles[t * 3 + corner]]].addPlane(normal, -glm::dot(normal, a));
+			}
+		}
+		for (int corner = 0; corner < 3; corner++)
+		{
+			vertexTriangles[triangles[t * 3 + corner]].push_back((unsigned int)t);
+		}
+	}
+
+	std::vector<unsigned int> versions(vertexCount, 0);
+	std::vector<bool> removed(vertexCount, false);
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+	// a free vertex is merged into whichever neighbour costs least, locked neighbours are valid targets since they stay in place
+	auto pushCandidate = [&](const unsigned int from)
+	{
+		if (locked[from] || removed[from])
+		{
+			return;
+		}
+		versions[from]++;
+
+		Collapse best = { -1.0, from, 0, versions[from] };
+		for (unsigned int t : vertexTriangles[from])
+		{
+			if (!alive[t])
+			{
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned int to = triangles[t * 3 + corner];
+				if (to == from)
+				{
+					continue;
+				}
+				Quadric quadric = quadrics[positionOf[from]];
+				quadric.add(quadrics[positionOf[to]]);
+				double cost = quadric.evaluate(vertices[to].Position);
+				if (best.cost < 0.0 || cost < best.cost)
+				{
+					best.cost = cost;
+					best.to = to;
+				}
+			}
+		}
+		if (best.cost >= 0.0)
+		{
+			queue.push(best);
+		}
+	};
+
+	// moving a vertex must not flip or collapse any triangle that survives the collapse
+	auto isCollapseValid = [&](const unsigned int from, const unsigned int to)
+	{
+		for (unsigned int t : vertexTriangles[from])
+		{
+			if (!alive[t])
+			{
+				continue;
+			}
+			const unsigned int* triangle = &triangles[t * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+			{
+				continue;
+			}
+
+			glm::vec3 before[3], after[3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				before[corner] = vertices[triangle[corner]].Position;
+				after[corner] = triangle[corner] == from ? vertices[to].Position : before[corner];
+			}
+			glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+			float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+			if (lengths <= 0.0f || glm::dot(normalBefore, normalAfter) < MeshSimplifier::MIN_NORMAL_DOT * lengths)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		pushCandidate(v);
+	}
+
+	auto snapshot = [&](const double maxCost)
+	{
+		std::vector<unsigned int> level;
+		for (std::size_t t = 0; t < triangleCount; t++)
+		{
+			if (alive[t])
+			{
+				level.insert(level.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+			}
+		}
+		levels.push_back(std::move(level));
+		errors.push_back((float)std::sqrt(maxCost));
+	};
+
+	std::size_t liveTriangles = triangleCount;
+	std::size_t target = 0;
+	double maxCost = 0.0;
+	while (target < targetTriangleCounts.size() && !queue.empty())
+	{
+		if (liveTriangles <= targetTriangleCounts[target])
+		{
+			snapshot(maxCost);
+			target++;
+			continue;
+		}
+
+		Collapse collapse = queue.top();
+		queue.pop();
+		if (removed[collapse.from] || removed[collapse.to] || collapse.version != versions[collapse.from] || !isCollapseValid(collapse.from, collapse.to))
+		{
+			continue;
+		}
+
+		for (unsigned int t : vertexTriangles[collapse.from])
+		{
+			if (!alive[t])
+			{
+				continue;
+			}
+			unsigned int* triangle = &triangles[t * 3];
+			if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+			{
+				alive[t] = false;
+				liveTriangles--;
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++)
+			{
+				if (triangle[corner] == collapse.from)
+				{
+					triangle[corner] = collapse.to;
+				}
+			}
+			vertexTriangles[collapse.to].push_back(t);
+		}
+		removed[collapse.from] = true;
+		quadrics[positionOf[collapse.to]].add(quadrics[positionOf[collapse.from]]);
+		maxCost = std::max(maxCost, collapse.cost);
+
+		// costs around the merged vertex changed
+		pushCandidate(collapse.to);
+		for (unsigned int t : vertexTriangles[collapse.to])
+		{
+			if (alive[t])
+			{
+				for (int corner = 0; corner < 3; corner++)
+				{
+					pushCandidate(triangles[t * 3 + corner]);
+				}
+			}
+		}
+	}
+
+	// targets that could not be reached share the coarsest result
+	while (target < targetTriangleCounts.size())
+	{
+		snapshot(maxCost);
+		target++;
+	}
+}
+
+void MeshSimplifier::buildLods(MeshData& mesh, const unsigned int levelCount)
+{
+	// unwelded triangles share no vertices, every position would look like a seam and nothing could collapse.
+	// a no op when the optimizer already welded the mesh
+	MeshOptimizer::weldVertices(mesh.vertices, mesh.indices);
+
+	mesh.lods = { { 0, (std::uint32_t)mesh.indices.size(), 0.0f } };
+
+	std::size_t triangleCount = mesh.indices.size() / 3;
+	std::vector<std::size_t> targets;
+	for (unsigned int level = 1; level < levelCount; level++)
+	{
+		targets.push_back(triangleCount >> level);
+	}
+
+	std::vector<std::vector<unsigned int>> levels;
+	std::vector<float> errors;
+	MeshSimplifier::simplify(mesh.vertices, mesh.indices, targets, levels, errors);
+
+	std::size_t previousCount = mesh.indices.size();
+	for (std::size_t i = 0; i < levels.size(); i++)
+	{
+		if (levels[i].empty() || levels[i].size() > previousCount * (1.0f - MeshSimplifier::MIN_LEVEL_REDUCTION))
+		{
+			break;
+		}
+		MeshOptimizer::optimizeVertexCache(levels[i], mesh.vertices.size());
+
+		mesh.lods.push_back({ (std::uint32_t)mesh.indices.size(), (std::uint32_t)levels[i].size(), errors[i] });
+		mesh.indices.insert(mesh.indices.end(), levels[i].begin(), levels[i].end());
+		previousCount = levels[i].size();
+	}
+}
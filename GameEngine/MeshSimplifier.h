@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "MeshData.h"
+
+// quadric error edge collapse, "Surface Simplification Using Quadric Error Metrics" (Garland, Heckbert 1997)
+struct MeshSimplifier
+{
+	// collapses that would fold a triangle over by more than this (cosine between old and new normal) are rejected
+	static const float MIN_NORMAL_DOT;
+
+	// levels with fewer than this fraction of triangles removed against the previous level are dropped
+	static const float MIN_LEVEL_REDUCTION;
+
+	// vertices on uv or normal seams and on open borders never move, so levels keep the mesh's attribute boundaries intact.
+	// expects welded vertices, any two vertices at one position are taken as a seam.
+	// indices are snapshotted each time the live triangle count reaches a target, errors are the largest collapse distance so far in mesh units
+	static void simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<std::size_t>& targetTriangleCounts,
+		std::vector<std::vector<unsigned int>>& levels, std::vector<float>& errors);
+
+	// welds the mesh, then appends up to levelCount - 1 coarser index lists behind the full detail indices, each halving the triangle count,
+	// and records them in mesh.lods
+	static void buildLods(MeshData& mesh, const unsigned int levelCount);
+};
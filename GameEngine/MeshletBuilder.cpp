@@ -0,0 +1,140 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+const unsigned int MeshletBuilder::MAX_VERTICES = 64;
+const unsigned int MeshletBuilder::MAX_TRIANGLES = 124;
+
+namespace
+{
+	Meshlet createMeshlet(const MeshData& mesh, const std::uint32_t indexOffset, const std::uint32_t indexCount)
+	{
+		Meshlet meshlet;
+		meshlet.indexOffset = indexOffset;
+		meshlet.indexCount = indexCount;
+
+		glm::vec3 boundsMin(std::numeric_limits<float>::max()), boundsMax(std::numeric_limits<float>::lowest());
+		for (std::uint32_t i = indexOffset; i < indexOffset + indexCount; i++)
+		{
+			boundsMin = glm::min(boundsMin, mesh.vertices[mesh.indices[i]].Position);
+			boundsMax = glm::max(boundsMax, mesh.vertices[mesh.indices[i]].Position);
+		}
+		meshlet.center = (boundsMin + boundsMax) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (std::uint32_t i = indexOffset; i < indexOffset + indexCount; i++)
+		{
+			meshlet.radius = std::max(meshlet.radius, glm::length(mesh.vertices[mesh.indices[i]].Position - meshlet.center));
+		}
+
+		// the cone holds every triangle normal, its cutoff is the sine of its half angle
+		std::vector<glm::vec3> normals;
+		glm::vec3 axis(0.0f);
+		for (std::uint32_t i = indexOffset; i < indexOffset + indexCount; i += 3)
+		{
+			const glm::vec3& a = mesh.vertices[mesh.indices[i]].Position;
+			const glm::vec3& b = mesh.vertices[mesh.indices[i + 1]].Position;
+			const glm::vec3& c = mesh.vertices[mesh.indices[i + 2]].Position;
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float length = glm::length(normal);
+			if (length > 0.0f)
+			{
+				normals.push_back(normal / length);
+				axis += normals.back();
+			}
+		}
+
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = 1.0f;
+		float axisLength = glm::length(axis);
+		if (axisLength > 0.0f)
+		{
+			meshlet.coneAxis = axis / axisLength;
+			float minimumDot = 1.0f;
+			for (const glm::vec3& normal : normals)
+			{
+				minimumDot = std::min(minimumDot, glm::dot(normal, meshlet.coneAxis));
+			}
+
+			// wider than a hemisphere can never be entirely back facing
+			if (minimumDot > 0.0f)
+			{
+				meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+			}
+		}
+		return meshlet;
+	}
+}
+
+void MeshletBuilder::build(MeshData& mesh)
+{
+	mesh.meshlets.clear();
+	std::uint32_t begin = mesh.lods.empty() ? 0 : mesh.lods[0].indexOffset;
+	std::uint32_t end = mesh.lods.empty() ? (std::uint32_t)mesh.indices.size() : mesh.lods[0].indexOffset + mesh.lods[0].indexCount;
+
+	// vertices are stamped with the cluster that last used them, so counting unique vertices needs no clearing
+	std::vector<std::uint32_t> usedBy(mesh.vertices.size(), std::numeric_limits<std::uint32_t>::max());
+	std::uint32_t meshletStart = begin, vertexCount = 0;
+	for (std::uint32_t i = begin; i < end; i += 3)
+	{
+		std::uint32_t id = (std::uint32_t)mesh.meshlets.size();
+		unsigned int newVertices = 0;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			newVertices += usedBy[mesh.indices[i + corner]] != id ? 1 : 0;
+		}
+
+		if (vertexCount + newVertices > MeshletBuilder::MAX_VERTICES || (i - meshletStart) / 3 >= MeshletBuilder::MAX_TRIANGLES)
+		{
+			mesh.meshlets.push_back(createMeshlet(mesh, meshletStart, i - meshletStart));
+			id++;
+			meshletStart = i;
+			vertexCount = 0;
+		}
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			if (usedBy[mesh.indices[i + corner]] != id)
+			{
+				usedBy[mesh.indices[i + corner]] = id;
+				vertexCount++;
+			}
+		}
+	}
+	if (meshletStart < end)
+	{
+		mesh.meshlets.push_back(createMeshlet(mesh, meshletStart, end - meshletStart));
+	}
+}
+
+bool MeshletBuilder::isVisible(const Meshlet& meshlet, const glm::vec3& cameraPosition, const std::array<glm::vec4, 6>& frustumPlanes)
+{
+	for (const glm::vec4& plane : frustumPlanes)
+	{
+		if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius)
+		{
+			return false;
+		}
+	}
+
+	// back facing from every point of the bounding sphere
+	glm::vec3 toCenter = meshlet.center - cameraPosition;
+	return meshlet.coneCutoff >= 1.0f || glm::dot(toCenter, meshlet.coneAxis) < meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+}
+
+std::array<glm::vec4, 6> MeshletBuilder::getFrustumPlanes(const glm::mat4& modelViewProjection)
+{
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(modelViewProjection[0][i], modelViewProjection[1][i], modelViewProjection[2][i], modelViewProjection[3][i]);
+	}
+
+	std::array<glm::vec4, 6> planes = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+	for (glm::vec4& plane : planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return planes;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include "MeshData.h"
+
+struct MeshletBuilder
+{
+	static const unsigned int MAX_VERTICES;
+	static const unsigned int MAX_TRIANGLES;
+
+	// splits the full detail level into runs of consecutive triangles, so each cluster is a plain index range and
+	// the triangle order chosen by the optimizer is kept
+	static void build(MeshData& mesh);
+
+	// planes in model space with normalized normals pointing inside, as from getFrustumPlanes
+	static bool isVisible(const Meshlet& meshlet, const glm::vec3& cameraPosition, const std::array<glm::vec4, 6>& frustumPlanes);
+
+	// planes of the clip volume of a model view projection matrix, in the model's space
+	static std::array<glm::vec4, 6> getFrustumPlanes(const glm::mat4& modelViewProjection);
+};
@@ -4,72 +4,344 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <format>
+#include <limits>
+
 #include "OpenGLFunctions.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "Config.h"
+#include "Camera.h"
+
+const unsigned int Model::IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_FlipUVs;
 
 Model::Model(const std::string& path, const bool gamma) : gammaCorrection(gamma)
 {
 	this->loadModel(path);
+	this->computeLodInfo();
+}
+
+unsigned int Model::selectLod(const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState& state) const
+{
+	unsigned int count = (unsigned int)this->lodErrors.size();
+	if (count < 2)
+	{
+		state.level = 0;
+		return 0;
+	}
+
+	float scale = std::max({ glm::length(glm::vec3(transformationMatrix[0])), glm::length(glm::vec3(transformationMatrix[1])), glm::length(glm::vec3(transformationMatrix[2])) });
+	glm::vec3 viewCenter = glm::vec3(Camera::viewMatrix * transformationMatrix * glm::vec4(this->boundsCenter, 1.0f));
+
+	// distance to the nearest point of the bounding sphere, full detail when the camera is inside it
+	float distance = glm::length(viewCenter) - this->boundsRadius * scale;
+	if (distance <= Config::Display::NEAR_PLANE)
+	{
+		state.level = 0;
+		return 0;
+	}
+
+	// an error of one model unit covers this fraction of the screen height
+	float projection = scale * projectionMatrix[1][1] * 0.5f / distance;
+	float threshold = Config::Models::LOD_ERROR_THRESHOLD;
+	float hysteresis = 1.0f + Config::Models::LOD_HYSTERESIS;
+
+	// levels only change once the error is clearly past the threshold in either direction, so a placement near it does not pop back and forth
+	unsigned int level = std::min(state.level, count - 1);
+	while (level > 0 && this->lodErrors[level] * projection > threshold * hysteresis)
+	{
+		level--;
+	}
+	while (level + 1 < count && this->lodErrors[level + 1] * projection < threshold / hysteresis)
+	{
+		level++;
+	}
+
+	state.level = level;
+	return level;
 }
 
-void Model::draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix)
+void Model::draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState* lodState)
 {
+	unsigned int lod = this->selectLod(transformationMatrix, projectionMatrix, lodState ? *lodState : this->lodState);
 	for (unsigned int i = 0; i < this->meshes.size(); i++)
 	{
-		this->meshes[i].draw(shader, transformationMatrix, projectionMatrix);
+		this->meshes[i].draw(shader, transformationMatrix, projectionMatrix, lod);
 	}
 }
 
-void Model::draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix)
+void Model::draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState* lodState, const GLuint cubeMap)
 {
+	unsigned int lod = this->selectLod(transformationMatrix, projectionMatrix, lodState ? *lodState : this->lodState);
 	for (unsigned int i = 0; i < this->meshes.size(); i++)
 	{
-		this->meshes[i].draw(shader, transformationMatrix, projectionMatrix);
+		this->meshes[i].draw(shader, transformationMatrix, projectionMatrix, lod, cubeMap);
 	}
 }
 
-void Model::draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const std::vector<Light>& lights)
+void Model::draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState* lodState, const GLuint cubeMap)
 {
+	unsigned int lod = this->selectLod(transformationMatrix, projectionMatrix, lodState ? *lodState : this->lodState);
 	for (unsigned int i = 0; i < this->meshes.size(); i++)
 	{
-		this->meshes[i].draw(shader, transformationMatrix, projectionMatrix, lights);
+		this->meshes[i].draw(shader, transformationMatrix, projectionMatrix, lod, cubeMap);
 	}
 }
 
+unsigned int Model::selectInstancedLod(std::span<const glm::mat4> transformationMatrices, const glm::mat4& projectionMatrix)
+{
+	if (transformationMatrices.empty())
+	{
+		return 0;
+	}
+
+	// the nearest copy needs the most detail, the rest are drawn at its level
+	const glm::mat4* nearest = &transformationMatrices[0];
+	float nearestDistance = std::numeric_limits<float>::max();
+	for (const glm::mat4& transformationMatrix : transformationMatrices)
+	{
+		float distance = glm::length(glm::vec3(transformationMatrix * glm::vec4(this->boundsCenter, 1.0f)) - Camera::position);
+		if (distance < nearestDistance)
+		{
+			nearest = &transformationMatrix;
+			nearestDistance = distance;
+		}
+	}
+	return this->selectLod(*nearest, projectionMatrix, this->lodState);
+}
+
+void Model::drawInstanced(BSDFShader shader, std::span<const glm::mat4> transformationMatrices, const glm::mat4& projectionMatrix)
+{
+	unsigned int lod = this->selectInstancedLod(transformationMatrices, projectionMatrix);
+	for (unsigned int i = 0; i < this->meshes.size(); i++)
+	{
+		this->meshes[i].drawInstanced(shader, transformationMatrices, lod);
+	}
+}
+
+void Model::drawInstanced(ReflectionShader shader, std::span<const glm::mat4> transformationMatrices, const glm::mat4& projectionMatrix)
+{
+	unsigned int lod = this->selectInstancedLod(transformationMatrices, projectionMatrix);
+	for (unsigned int i = 0; i < this->meshes.size(); i++)
+	{
+		this->meshes[i].drawInstanced(shader, transformationMatrices, lod);
+	}
+}
+
+bool Model::updateBounds(const glm::mat4& transformationMatrix, PlacementBounds& bounds) const
+{
+	if (bounds.transform == transformationMatrix && bounds.meshes.size() == this->meshes.size())
+	{
+		return false;
+	}
+
+	bounds.transform = transformationMatrix;
+	bounds.meshes.clear();
+	bounds.min = glm::vec3(this->meshes.empty() ? 0.0f : std::numeric_limits<float>::max());
+	bounds.max = glm::vec3(this->meshes.empty() ? 0.0f : std::numeric_limits<float>::lowest());
+	for (const Mesh& mesh : this->meshes)
+	{
+		bounds.meshes.push_back(FrustumCuller::transformBounds(mesh.boundsMin, mesh.boundsMax, mesh.sphereCenter, mesh.sphereRadius, transformationMatrix));
+		bounds.min = glm::min(bounds.min, bounds.meshes.back().min);
+		bounds.max = glm::max(bounds.max, bounds.meshes.back().max);
+	}
+	return true;
+}
+
 void Model::loadModel(const std::string& path)
+{
+	this->directory = path.substr(0, path.find_last_of('/'));
+
+	if (MeshCache::isCookedFileValid(path) && this->loadCookedModel(path))
+	{
+		spdlog::debug("Loaded cooked model '{}'", path);
+		return;
+	}
+
+	std::vector<MeshData> meshes;
+	if (!Model::importModel(path, meshes))
+	{
+		return;
+	}
+	MeshCache::save(path, meshes);
+
+	// encoded the same way the cooked file stores it, so both paths upload identical streams
+	std::vector<PackedVertex> packedVertices;
+	std::vector<std::uint16_t> shortIndices;
+	for (const MeshData& mesh : meshes)
+	{
+		MeshStreams streams = MeshCache::encode(mesh, packedVertices, shortIndices);
+		this->meshes.push_back(Mesh(streams, this->resolveTextures(mesh.textures), mesh.mat, mesh.numFaces, mesh.lods, mesh.meshlets));
+	}
+}
+
+bool Model::loadCookedModel(const std::string& path)
+{
+	MappedFile file;
+	if (!file.open(MeshCache::getCookedPath(path)))
+	{
+		return false;
+	}
+
+	std::vector<CookedMesh> meshes;
+	if (!MeshCache::load(file, meshes))
+	{
+		spdlog::error("Cooked model '{}' is corrupt, reimporting", MeshCache::getCookedPath(path));
+		return false;
+	}
+
+	for (const CookedMesh& mesh : meshes)
+	{
+		this->meshes.push_back(Mesh(mesh.streams, this->resolveTextures(mesh.textures), mesh.mat, mesh.numFaces, mesh.lods, mesh.meshlets));
+	}
+	return true;
+}
+
+void Model::computeLodInfo()
+{
+	this->lodErrors.clear();
+	this->boundsCenter = glm::vec3(0.0f);
+	this->boundsRadius = 0.0f;
+	if (this->meshes.empty())
+	{
+		return;
+	}
+
+	glm::vec3 boundsMin = this->meshes[0].boundsMin, boundsMax = this->meshes[0].boundsMax;
+	std::size_t levelCount = 0;
+	for (const Mesh& mesh : this->meshes)
+	{
+		boundsMin = glm::min(boundsMin, mesh.boundsMin);
+		boundsMax = glm::max(boundsMax, mesh.boundsMax);
+		levelCount = std::max(levelCount, mesh.lods.size());
+	}
+	this->boundsCenter = (boundsMin + boundsMax) * 0.5f;
+	this->boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+	// meshes with a shorter chain keep drawing their coarsest level
+	this->lodErrors.resize(levelCount, 0.0f);
+	for (const Mesh& mesh : this->meshes)
+	{
+		for (std::size_t level = 0; level < levelCount; level++)
+		{
+			this->lodErrors[level] = std::max(this->lodErrors[level], mesh.lods[std::min(level, mesh.lods.size() - 1)].error);
+		}
+	}
+}
+
+bool Model::cook(const std::string& path)
+{
+	std::vector<TextureReference> textures;
+	if (MeshCache::isCookedFileValid(path))
+	{
+		spdlog::debug("Cooked model '{}' is up to date", path);
+
+		MappedFile file;
+		std::vector<CookedMesh> meshes;
+		if (file.open(MeshCache::getCookedPath(path)) && MeshCache::load(file, meshes))
+		{
+			for (const CookedMesh& mesh : meshes)
+			{
+				textures.insert(textures.end(), mesh.textures.begin(), mesh.textures.end());
+			}
+		}
+	}
+	else
+	{
+		std::vector<MeshData> meshes;
+		if (!Model::importModel(path, meshes) || !MeshCache::save(path, meshes))
+		{
+			return false;
+		}
+
+		for (const MeshData& mesh : meshes)
+		{
+			textures.insert(textures.end(), mesh.textures.begin(), mesh.textures.end());
+		}
+	}
+
+	// textures are cooked with the same settings loadTextureFromPath uses
+	bool success = true;
+	std::string directory = path.substr(0, path.find_last_of('/'));
+	for (const TextureReference& texture : textures)
+	{
+		std::string filename = directory + '/' + texture.Path;
+		if (!TextureCache::isCookedFileValid({ filename }, texture.Type, false))
+		{
+			success = TextureCache::cook({ filename }, texture.Type, false) && success;
+		}
+	}
+	return success;
+}
+
+bool Model::importModel(const std::string& path, std::vector<MeshData>& meshes)
 {
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_FlipUVs);
+	const aiScene* scene = importer.ReadFile(path, Model::IMPORT_FLAGS);
 
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
 		spdlog::error("Assimp error, {}", importer.GetErrorString());
-		return;
+		return false;
 	}
 
-	this->directory = path.substr(0, path.find_last_of('/'));
+	Model::processNode(scene->mRootNode, scene, meshes);
+
+	for (std::size_t i = 0; i < meshes.size(); i++)
+	{
+		if (Config::Models::OPTIMIZE_MESHES)
+		{
+			MeshOptimizerStats stats = MeshOptimizer::optimize(meshes[i].vertices, meshes[i].indices);
+			spdlog::info("Optimized mesh {:d} of '{}', {:d} -> {:d} vertices, ACMR {:.3f} -> {:.3f}, {}-bit indices", i, path,
+				stats.verticesBefore, stats.verticesAfter, stats.acmrBefore, stats.acmrAfter, MeshOptimizer::fitsShortIndices(stats.verticesAfter) ? 16 : 32);
+		}
+
+		if (Config::Models::LOD_COUNT > 1)
+		{
+			MeshSimplifier::buildLods(meshes[i], Config::Models::LOD_COUNT);
+
+			std::string levels;
+			for (const MeshLod& lod : meshes[i].lods)
+			{
+				levels += std::format("{}{:d} ({:.4f})", levels.empty() ? "" : ", ", lod.indexCount / 3, lod.error);
+			}
+			spdlog::info("Levels of detail for mesh {:d} of '{}', triangles {}", i, path, levels);
+		}
 
-	processNode(scene->mRootNode, scene);
+		MeshletBuilder::build(meshes[i]);
+		spdlog::info("Split mesh {:d} of '{}' into {:d} meshlets", i, path, meshes[i].meshlets.size());
+	}
+	return true;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::processNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshes)
 {
 	for (unsigned int i = 0; i < node->mNumMeshes; i++)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		this->meshes.push_back(processMesh(mesh, scene));
+		meshes.push_back(Model::processMesh(mesh, scene));
 	}
 
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
 	{
-		processNode(node->mChildren[i], scene);
+		Model::processNode(node->mChildren[i], scene, meshes);
 	}
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+MeshData Model::processMesh(aiMesh* mesh, const aiScene* scene)
 {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-	std::vector<Texture> textures;
+	MeshData data = {};
+	std::vector<Vertex>& vertices = data.vertices;
+	std::vector<unsigned int>& indices = data.indices;
+	std::vector<TextureReference>& textures = data.textures;
+
+	vertices.reserve(mesh->mNumVertices);
+	indices.reserve(mesh->mNumFaces * 3);
 
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
@@ -121,7 +393,7 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 	}
 
 	aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-	Material mat;
+	Material& mat = data.mat;
 	aiColor3D color;
 
 	material->Get(AI_MATKEY_COLOR_AMBIENT, color);
@@ -136,33 +408,44 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 	material->Get(AI_MATKEY_OPACITY, mat.d);
 	material->Get(AI_MATKEY_SHADING_MODEL, mat.illum);
 
-	std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+	std::vector<TextureReference> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
 	textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
 
-	std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+	std::vector<TextureReference> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
 	textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 
-	std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_NORMALS, "texture_normal");
+	std::vector<TextureReference> normalMaps = loadMaterialTextures(material, aiTextureType_NORMALS, "texture_normal");
 	textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
 
-	std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_height");
+	std::vector<TextureReference> heightMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_height");
 	textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-	return Mesh(vertices, indices, textures, mat, mesh->mNumFaces);
+	data.numFaces = mesh->mNumFaces;
+	return data;
 }
 
-std::vector<Texture> Model::loadMaterialTextures(const aiMaterial* mat, const aiTextureType type, const std::string& typeName)
+std::vector<TextureReference> Model::loadMaterialTextures(const aiMaterial* mat, const aiTextureType type, const std::string& typeName)
 {
-	std::vector<Texture> textures;
+	std::vector<TextureReference> textures;
 	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
 	{
 		aiString str;
 		mat->GetTexture(type, i, &str);
+		textures.push_back(TextureReference{ typeName, str.C_Str() });
+	}
+
+	return textures;
+}
 
+std::vector<Texture> Model::resolveTextures(const std::vector<TextureReference>& references)
+{
+	std::vector<Texture> textures;
+	for (const TextureReference& reference : references)
+	{
 		bool skip = false;
 		for (unsigned int j = 0; j < this->texturesLoaded.size(); j++)
 		{
-			if (std::strcmp(this->texturesLoaded[j].Path.data(), str.C_Str()) == 0)
+			if (this->texturesLoaded[j].Path == reference.Path)
 			{
 				textures.push_back(texturesLoaded[j]);
 				skip = true;
@@ -172,19 +455,11 @@ std::vector<Texture> Model::loadMaterialTextures(const aiMaterial* mat, const ai
 
 		if (!skip)
 		{
-			Texture texture = Loader::loadTextureFromPath(str.C_Str(), this->directory, typeName);
+			Texture texture = Loader::loadTextureFromPath(reference.Path, this->directory, reference.Type);
 			textures.push_back(texture);
 			texturesLoaded.push_back(texture);
 		}
 	}
 
 	return textures;
-}
-
-void Model::setCubeMap(const Texture& cubeMapTexture)
-{
-	for (Mesh& mesh : this->meshes)
-	{
-		mesh.setCubeMap(cubeMapTexture);
-	}
 }
\ No newline at end of file
@@ -3,41 +3,82 @@
 #include <glad/glad.h>
 
 #include <string>
+#include <span>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "ReflectionShader.h"
+#include "FrustumCuller.h"
 #include "BSDFShader.h"
 #include "Shader.h"
+#include "MeshData.h"
 #include "Loader.h"
 #include "Mesh.h"
 
+// level a placement was last drawn at, kept per placement so switching levels can use hysteresis
+struct LodState
+{
+	unsigned int level = 0;
+};
+
 class Model
 {
 private:
 	void loadModel(const std::string& path);
 
-	void processNode(aiNode* node, const aiScene* scene);
+	bool loadCookedModel(const std::string& path);
+
+	static void processNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshes);
+
+	static MeshData processMesh(aiMesh* mesh, const aiScene* scene);
+
+	static std::vector<TextureReference> loadMaterialTextures(const aiMaterial* mat, const aiTextureType type, const std::string& typeName);
+
+	std::vector<Texture> resolveTextures(const std::vector<TextureReference>& references);
 
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+	void computeLodInfo();
 
-	std::vector<Texture> loadMaterialTextures(const aiMaterial* mat, const aiTextureType type, const std::string& typeName);
+	unsigned int selectInstancedLod(std::span<const glm::mat4> transformationMatrices, const glm::mat4& projectionMatrix);
 
 public:
+	// assimp post process flags, part of the cooked mesh cache key
+	static const unsigned int IMPORT_FLAGS;
+
 	std::vector<Texture> texturesLoaded;
 	std::vector<Mesh> meshes;
 	std::string directory;
 	bool gammaCorrection;
 
+	// largest simplification error of each level over all meshes, in model units
+	std::vector<float> lodErrors;
+	glm::vec3 boundsCenter;
+	float boundsRadius;
+	LodState lodState;
+
 	Model(const std::string& path, const bool gamma = false);
 
-	void draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix);
+	static bool cook(const std::string& path);
+
+	// the full float vertices of every mesh straight from assimp, meshes only keep what the gpu and the cpu side readers need
+	static bool importModel(const std::string& path, std::vector<MeshData>& meshes);
+
+	// coarsest level whose error projects below the configured fraction of the screen height, the model's own state is used when none is given
+	unsigned int selectLod(const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState& state) const;
+
+	void draw(Shader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState* lodState = nullptr);
+
+	// a non zero cube map replaces the meshes' own for this draw
+	void draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState* lodState = nullptr, const GLuint cubeMap = 0);
+
+	void draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, LodState* lodState = nullptr, const GLuint cubeMap = 0);
 
-	void draw(BSDFShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix);
+	// every copy in one draw call per mesh, the level is chosen for the nearest copy
+	void drawInstanced(BSDFShader shader, std::span<const glm::mat4> transformationMatrices, const glm::mat4& projectionMatrix);
 
-	void draw(ReflectionShader shader, const glm::mat4& transformationMatrix, const glm::mat4& projectionMatrix, const std::vector<Light>& lights);
+	void drawInstanced(ReflectionShader shader, std::span<const glm::mat4> transformationMatrices, const glm::mat4& projectionMatrix);
 
-	void setCubeMap(const Texture& cubeMapTexture);
+	// world bounds of a placement at the transform, returns false when they were already up to date
+	bool updateBounds(const glm::mat4& transformationMatrix, PlacementBounds& bounds) const;
 };
@@ -0,0 +1,375 @@
+#include "OcclusionCuller.h"
+
+#include <xmmintrin.h>
+
+#include <algorithm>
+#include <chrono>
+#include <array>
+#include <cmath>
+
+namespace
+{
+	double getMilliseconds(const std::chrono::high_resolution_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+const int OcclusionCuller::WIDTH = 256;
+const int OcclusionCuller::HEIGHT = 128;
+
+OcclusionCuller::OcclusionCuller()
+{
+	int width = OcclusionCuller::WIDTH;
+	int height = OcclusionCuller::HEIGHT;
+	while (true)
+	{
+		this->levels.push_back(std::vector<float>((std::size_t)width * height, 1.0f));
+		this->levelSizes.push_back(glm::ivec2(width, height));
+		if (width == 1 && height == 1)
+		{
+			break;
+		}
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->running = false;
+	}
+	this->condition.notify_all();
+
+	if (this->worker.joinable())
+	{
+		this->worker.join();
+	}
+}
+
+void OcclusionCuller::clearOccluders()
+{
+	this->triangles.clear();
+}
+
+void OcclusionCuller::addOccluder(std::span<const glm::vec3> positions, std::span<const unsigned int> indices, const glm::mat4& transformationMatrix)
+{
+	for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (std::size_t k = 0; k < 3; k++)
+		{
+			this->triangles.push_back(transformationMatrix * glm::vec4(positions[indices[i + k]], 1.0f));
+		}
+	}
+}
+
+std::size_t OcclusionCuller::getTriangleCount() const
+{
+	return this->triangles.size() / 3;
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjectionMatrix)
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	if (!this->worker.joinable())
+	{
+		this->running = true;
+		this->worker = std::thread(&OcclusionCuller::workerLoop, this);
+	}
+
+	this->viewProjectionMatrix = viewProjectionMatrix;
+	this->pending = true;
+	lock.unlock();
+	this->condition.notify_all();
+}
+
+double OcclusionCuller::wait()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->condition.wait(lock, [this] { return !this->pending; });
+	return getMilliseconds(start);
+}
+
+void OcclusionCuller::render(const glm::mat4& viewProjectionMatrix)
+{
+	this->viewProjectionMatrix = viewProjectionMatrix;
+	this->rasterize();
+	this->buildPyramid();
+}
+
+void OcclusionCuller::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (true)
+	{
+		this->condition.wait(lock, [this] { return this->pending || !this->running; });
+		if (!this->running)
+		{
+			return;
+		}
+
+		lock.unlock();
+		this->rasterize();
+		this->buildPyramid();
+		lock.lock();
+
+		this->pending = false;
+		this->condition.notify_all();
+	}
+}
+
+void OcclusionCuller::rasterize()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::fill(this->levels[0].begin(), this->levels[0].end(), 1.0f);
+
+	for (std::size_t i = 0; i < this->triangles.size(); i += 3)
+	{
+		std::array<glm::vec4, 3> clip = { this->viewProjectionMatrix * this->triangles[i], this->viewProjectionMatrix * this->triangles[i + 1],
+			this->viewProjectionMatrix * this->triangles[i + 2] };
+
+		// whole triangles outside one clip plane are skipped, the sides are left to the clamped bounding box
+		bool outside = false;
+		for (int axis = 0; axis < 3 && !outside; axis++)
+		{
+			outside = (clip[0][axis] > clip[0].w && clip[1][axis] > clip[1].w && clip[2][axis] > clip[2].w) ||
+				(clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w);
+		}
+		if (outside)
+		{
+			continue;
+		}
+
+		if (clip[0].z >= -clip[0].w && clip[1].z >= -clip[1].w && clip[2].z >= -clip[2].w)
+		{
+			this->rasterizeTriangle(clip[0], clip[1], clip[2]);
+			continue;
+		}
+
+		// cut at the near plane, leaving a triangle or a quad drawn as a fan
+		std::array<glm::vec4, 4> polygon;
+		std::size_t count = 0;
+		for (std::size_t k = 0; k < 3; k++)
+		{
+			const glm::vec4& current = clip[k];
+			const glm::vec4& next = clip[(k + 1) % 3];
+			float currentDistance = current.z + current.w;
+			float nextDistance = next.z + next.w;
+			if (currentDistance >= 0.0f)
+			{
+				polygon[count++] = current;
+			}
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				polygon[count++] = glm::mix(current, next, currentDistance / (currentDistance - nextDistance));
+			}
+		}
+		for (std::size_t k = 2; k < count; k++)
+		{
+			this->rasterizeTriangle(polygon[0], polygon[k - 1], polygon[k]);
+		}
+	}
+	this->timings.rasterize = getMilliseconds(start);
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	const float width = (float)OcclusionCuller::WIDTH;
+	const float height = (float)OcclusionCuller::HEIGHT;
+
+	std::array<glm::vec3, 3> screen;
+	const std::array<const glm::vec4*, 3> clip = { &a, &b, &c };
+	for (std::size_t k = 0; k < 3; k++)
+	{
+		float inverseW = 1.0f / clip[k]->w;
+		screen[k] = glm::vec3((clip[k]->x * inverseW * 0.5f + 0.5f) * width, (clip[k]->y * inverseW * 0.5f + 0.5f) * height,
+			clip[k]->z * inverseW * 0.5f + 0.5f);
+	}
+
+	// occluders are drawn from both sides, so clockwise triangles are turned around
+	float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+	if (std::abs(area) < 1e-6f)
+	{
+		return;
+	}
+	if (area < 0.0f)
+	{
+		std::swap(screen[1], screen[2]);
+		area = -area;
+	}
+
+	int minX = std::max((int)std::floor(std::min({ screen[0].x, screen[1].x, screen[2].x })), 0);
+	int maxX = std::min((int)std::ceil(std::max({ screen[0].x, screen[1].x, screen[2].x })), OcclusionCuller::WIDTH - 1);
+	int minY = std::max((int)std::floor(std::min({ screen[0].y, screen[1].y, screen[2].y })), 0);
+	int maxY = std::min((int)std::ceil(std::max({ screen[0].y, screen[1].y, screen[2].y })), OcclusionCuller::HEIGHT - 1);
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+	minX &= ~3;
+
+	// edge k is opposite vertex k and is positive inside, so divided by the area it is that vertex's barycentric weight
+	std::array<glm::vec3, 3> edges;
+	for (std::size_t k = 0; k < 3; k++)
+	{
+		const glm::vec3& from = screen[(k + 1) % 3];
+		const glm::vec3& to = screen[(k + 2) % 3];
+		float stepX = from.y - to.y;
+		float stepY = to.x - from.x;
+		edges[k] = glm::vec3(stepX, stepY, -(stepX * from.x + stepY * from.y));
+	}
+	glm::vec3 depthPlane = (edges[0] * screen[0].z + edges[1] * screen[1].z + edges[2] * screen[2].z) / area;
+
+	std::array<__m128, 3> edgeStepX;
+	std::array<__m128, 3> edgeStepY;
+	std::array<__m128, 3> edgeOffset;
+	for (std::size_t k = 0; k < 3; k++)
+	{
+		edgeStepX[k] = _mm_set1_ps(edges[k].x);
+		edgeStepY[k] = _mm_set1_ps(edges[k].y);
+		edgeOffset[k] = _mm_set1_ps(edges[k].z);
+	}
+	const __m128 depthStepX = _mm_set1_ps(depthPlane.x);
+	const __m128 depthStepY = _mm_set1_ps(depthPlane.y);
+	const __m128 depthOffset = _mm_set1_ps(depthPlane.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+	float* depthBuffer = this->levels[0].data();
+	for (int y = minY; y <= maxY; y++)
+	{
+		__m128 pixelY = _mm_set1_ps((float)y + 0.5f);
+		std::array<__m128, 3> edgeRows;
+		for (std::size_t k = 0; k < 3; k++)
+		{
+			edgeRows[k] = _mm_add_ps(_mm_mul_ps(edgeStepY[k], pixelY), edgeOffset[k]);
+		}
+		__m128 depthRow = _mm_add_ps(_mm_mul_ps(depthStepY, pixelY), depthOffset);
+
+		float* row = depthBuffer + (std::size_t)y * OcclusionCuller::WIDTH;
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), pixelOffsets);
+			__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStepX[0], pixelX), edgeRows[0]), zero);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStepX[1], pixelX), edgeRows[1]), zero));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStepX[2], pixelX), edgeRows[2]), zero));
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(depthStepX, pixelX), depthRow);
+			__m128 previous = _mm_loadu_ps(row + x);
+			__m128 nearest = _mm_min_ps(previous, depth);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+		}
+	}
+}
+
+void OcclusionCuller::buildPyramid()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (std::size_t level = 1; level < this->levels.size(); level++)
+	{
+		const std::vector<float>& source = this->levels[level - 1];
+		std::vector<float>& destination = this->levels[level];
+		glm::ivec2 sourceSize = this->levelSizes[level - 1];
+		glm::ivec2 size = this->levelSizes[level];
+
+		for (int y = 0; y < size.y; y++)
+		{
+			const float* top = source.data() + (std::size_t)std::min(y * 2, sourceSize.y - 1) * sourceSize.x;
+			const float* bottom = source.data() + (std::size_t)std::min(y * 2 + 1, sourceSize.y - 1) * sourceSize.x;
+			float* row = destination.data() + (std::size_t)y * size.x;
+
+			// four texels from eight source columns of two rows while whole groups fit
+			int x = 0;
+			if (sourceSize.x == size.x * 2)
+			{
+				for (; x + 4 <= size.x; x += 4)
+				{
+					__m128 left = _mm_max_ps(_mm_loadu_ps(top + x * 2), _mm_loadu_ps(bottom + x * 2));
+					__m128 right = _mm_max_ps(_mm_loadu_ps(top + x * 2 + 4), _mm_loadu_ps(bottom + x * 2 + 4));
+					__m128 even = _mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0));
+					__m128 odd = _mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1));
+					_mm_storeu_ps(row + x, _mm_max_ps(even, odd));
+				}
+			}
+			for (; x < size.x; x++)
+			{
+				int left = std::min(x * 2, sourceSize.x - 1);
+				int right = std::min(x * 2 + 1, sourceSize.x - 1);
+				row[x] = std::max({ top[left], top[right], bottom[left], bottom[right] });
+			}
+		}
+	}
+	this->timings.pyramid = getMilliseconds(start);
+}
+
+bool OcclusionCuller::isOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const
+{
+	glm::vec2 screenMin = glm::vec2(1.0f);
+	glm::vec2 screenMax = glm::vec2(-1.0f);
+	float nearestDepth = 1.0f;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 position = glm::vec3(corner & 1 ? boundsMax.x : boundsMin.x, corner & 2 ? boundsMax.y : boundsMin.y, corner & 4 ? boundsMax.z : boundsMin.z);
+		glm::vec4 clip = this->viewProjectionMatrix * glm::vec4(position, 1.0f);
+		if (clip.w <= 0.0f || clip.z < -clip.w)
+		{
+			return false;
+		}
+
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		screenMin = glm::min(screenMin, glm::vec2(ndc));
+		screenMax = glm::max(screenMax, glm::vec2(ndc));
+		nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+	}
+	if (screenMax.x < -1.0f || screenMax.y < -1.0f || screenMin.x > 1.0f || screenMin.y > 1.0f)
+	{
+		return false;
+	}
+
+	int minX = std::clamp((int)std::floor((screenMin.x * 0.5f + 0.5f) * OcclusionCuller::WIDTH), 0, OcclusionCuller::WIDTH - 1);
+	int maxX = std::clamp((int)std::floor((screenMax.x * 0.5f + 0.5f) * OcclusionCuller::WIDTH), 0, OcclusionCuller::WIDTH - 1);
+	int minY = std::clamp((int)std::floor((screenMin.y * 0.5f + 0.5f) * OcclusionCuller::HEIGHT), 0, OcclusionCuller::HEIGHT - 1);
+	int maxY = std::clamp((int)std::floor((screenMax.y * 0.5f + 0.5f) * OcclusionCuller::HEIGHT), 0, OcclusionCuller::HEIGHT - 1);
+
+	// the finest level where the rectangle covers at most four texels on each side
+	std::size_t level = 0;
+	while (level + 1 < this->levels.size() && (maxX - minX >= 4 || maxY - minY >= 4))
+	{
+		level++;
+		minX >>= 1;
+		maxX >>= 1;
+		minY >>= 1;
+		maxY >>= 1;
+	}
+
+	const std::vector<float>& depths = this->levels[level];
+	glm::ivec2 size = this->levelSizes[level];
+	for (int y = std::min(minY, size.y - 1); y <= std::min(maxY, size.y - 1); y++)
+	{
+		for (int x = std::min(minX, size.x - 1); x <= std::min(maxX, size.x - 1); x++)
+		{
+			if (depths[(std::size_t)y * size.x + x] >= nearestDepth)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+const OcclusionTimings& OcclusionCuller::getTimings() const
+{
+	return this->timings;
+}
+
+const std::vector<float>& OcclusionCuller::getDepthBuffer() const
+{
+	return this->levels[0];
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <span>
+
+#include <glm/glm.hpp>
+
+// milliseconds spent on each step of the last rendered pyramid, test and wait are added up by the caller's frame
+struct OcclusionTimings
+{
+	double rasterize = 0.0;
+	double pyramid = 0.0;
+};
+
+// software rasterized depth of a few large occluders and the max depth pyramid built from it, run entirely on the cpu
+//
+// occluders are drawn into a small depth buffer four pixels at a time with sse edge functions, each pyramid level holds
+// the furthest depth of the 2x2 texels below it so an object is hidden when its nearest depth is behind every texel
+// its screen rectangle covers on a level where that rectangle spans only a few texels
+class OcclusionCuller
+{
+private:
+	// occluder triangles in world space, three positions per triangle
+	std::vector<glm::vec4> triangles;
+
+	// level 0 is WIDTH x HEIGHT, depth in [0, 1] with 1 at the far plane
+	std::vector<std::vector<float>> levels;
+	std::vector<glm::ivec2> levelSizes;
+
+	glm::mat4 viewProjectionMatrix = glm::mat4(1.0f);
+	OcclusionTimings timings;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool running = false;
+	bool pending = false;
+
+	void workerLoop();
+
+	void rasterize();
+
+	void rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+	void buildPyramid();
+
+public:
+	static const int WIDTH;
+	static const int HEIGHT;
+
+	OcclusionCuller();
+
+	~OcclusionCuller();
+
+	OcclusionCuller(const OcclusionCuller&) = delete;
+
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	void clearOccluders();
+
+	// triangles of an occluder mesh, the positions are moved to world space once here so occluders are expected to stay put
+	void addOccluder(std::span<const glm::vec3> positions, std::span<const unsigned int> indices, const glm::mat4& transformationMatrix);
+
+	std::size_t getTriangleCount() const;
+
+	// starts rendering the occluders for the view on the worker thread, wait must be called before testing
+	void begin(const glm::mat4& viewProjectionMatrix);
+
+	// blocks until the pyramid of the last begin is built, returns the milliseconds spent blocked
+	double wait();
+
+	// renders the occluders and builds the pyramid on the calling thread
+	void render(const glm::mat4& viewProjectionMatrix);
+
+	// world space box against the pyramid, boxes crossing the near plane or leaving the screen are never occluded
+	bool isOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+	const OcclusionTimings& getTimings() const;
+
+	// depth of level 0, row by row from the bottom of the screen
+	const std::vector<float>& getDepthBuffer() const;
+};
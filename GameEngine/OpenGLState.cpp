@@ -0,0 +1,323 @@
+#include "OpenGLState.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "OpenGLFunctions.h"
+#include "RenderStats.h"
+
+const GLuint OpenGLState::UNKNOWN = std::numeric_limits<GLuint>::max();
+
+GLuint OpenGLState::program = OpenGLState::UNKNOWN;
+GLuint OpenGLState::vertexArray = OpenGLState::UNKNOWN;
+GLuint OpenGLState::drawFramebuffer = OpenGLState::UNKNOWN;
+GLuint OpenGLState::readFramebuffer = OpenGLState::UNKNOWN;
+GLenum OpenGLState::activeUnit = OpenGLState::UNKNOWN;
+std::unordered_map<GLenum, GLuint> OpenGLState::buffers;
+std::array<OpenGLState::BufferRange, OpenGLState::INDEXED_BUFFER_BINDINGS> OpenGLState::uniformBuffers;
+std::array<OpenGLState::BufferRange, OpenGLState::INDEXED_BUFFER_BINDINGS> OpenGLState::storageBuffers;
+std::array<std::array<GLuint, 2>, OpenGLState::TEXTURE_UNITS> OpenGLState::textures;
+std::unordered_map<GLenum, bool> OpenGLState::capabilities;
+std::array<GLint, 4> OpenGLState::viewportRect = { -1, -1, -1, -1 };
+GLboolean OpenGLState::depthWrite = 2;
+std::array<GLenum, 2> OpenGLState::blendFactors = { OpenGLState::UNKNOWN, OpenGLState::UNKNOWN };
+
+std::size_t OpenGLState::elided = 0;
+std::size_t OpenGLState::issued = 0;
+
+bool OpenGLState::update(GLuint& shadow, const GLuint value)
+{
+	if (shadow == value)
+	{
+		OpenGLState::elided++;
+		return false;
+	}
+	shadow = value;
+	OpenGLState::issued++;
+	return true;
+}
+
+GLuint* OpenGLState::getTextureSlot(const GLenum target)
+{
+	unsigned int unit = OpenGLState::activeUnit - GL_TEXTURE0;
+	if (OpenGLState::activeUnit == OpenGLState::UNKNOWN || unit >= OpenGLState::TEXTURE_UNITS)
+	{
+		return nullptr;
+	}
+
+	switch (target)
+	{
+	case GL_TEXTURE_2D:
+		return &OpenGLState::textures[unit][0];
+	case GL_TEXTURE_CUBE_MAP:
+		return &OpenGLState::textures[unit][1];
+	default:
+		return nullptr;
+	}
+}
+
+OpenGLState::BufferRange* OpenGLState::getRangeSlot(const GLenum target, const GLuint index)
+{
+	if (index >= OpenGLState::INDEXED_BUFFER_BINDINGS)
+	{
+		return nullptr;
+	}
+
+	switch (target)
+	{
+	case GL_UNIFORM_BUFFER:
+		return &OpenGLState::uniformBuffers[index];
+	case GL_SHADER_STORAGE_BUFFER:
+		return &OpenGLState::storageBuffers[index];
+	default:
+		return nullptr;
+	}
+}
+
+void OpenGLState::invalidate()
+{
+	OpenGLState::program = OpenGLState::UNKNOWN;
+	OpenGLState::vertexArray = OpenGLState::UNKNOWN;
+	OpenGLState::drawFramebuffer = OpenGLState::UNKNOWN;
+	OpenGLState::readFramebuffer = OpenGLState::UNKNOWN;
+	OpenGLState::activeUnit = OpenGLState::UNKNOWN;
+	OpenGLState::buffers.clear();
+	OpenGLState::uniformBuffers.fill({ OpenGLState::UNKNOWN, 0, 0 });
+	OpenGLState::storageBuffers.fill({ OpenGLState::UNKNOWN, 0, 0 });
+	for (std::array<GLuint, 2>& unit : OpenGLState::textures)
+	{
+		unit.fill(OpenGLState::UNKNOWN);
+	}
+	OpenGLState::capabilities.clear();
+	OpenGLState::viewportRect = { -1, -1, -1, -1 };
+	OpenGLState::depthWrite = 2;
+	OpenGLState::blendFactors = { OpenGLState::UNKNOWN, OpenGLState::UNKNOWN };
+}
+
+void OpenGLState::useProgram(const GLuint program)
+{
+	if (OpenGLState::update(OpenGLState::program, program))
+	{
+		glCall(glUseProgram, program);
+	}
+}
+
+void OpenGLState::bindVertexArray(const GLuint vertexArray)
+{
+	if (OpenGLState::update(OpenGLState::vertexArray, vertexArray))
+	{
+		glCall(glBindVertexArray, vertexArray);
+		OpenGLState::buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	}
+}
+
+void OpenGLState::bindBuffer(const GLenum target, const GLuint buffer)
+{
+	auto it = OpenGLState::buffers.try_emplace(target, OpenGLState::UNKNOWN).first;
+	if (OpenGLState::update(it->second, buffer))
+	{
+		glCall(glBindBuffer, target, buffer);
+	}
+}
+
+void OpenGLState::bindBufferRange(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size)
+{
+	// binding a range also sets the generic binding point
+	BufferRange* range = OpenGLState::getRangeSlot(target, index);
+	if (range)
+	{
+		if (range->buffer == buffer && range->offset == offset && range->size == size && OpenGLState::buffers[target] == buffer)
+		{
+			OpenGLState::elided++;
+			return;
+		}
+		*range = { buffer, offset, size };
+	}
+	OpenGLState::issued++;
+	OpenGLState::buffers[target] = buffer;
+	glCall(glBindBufferRange, target, index, buffer, offset, size);
+}
+
+void OpenGLState::activeTexture(const GLenum unit)
+{
+	if (OpenGLState::update(OpenGLState::activeUnit, unit))
+	{
+		glCall(glActiveTexture, unit);
+	}
+}
+
+void OpenGLState::bindTexture(const GLenum target, const GLuint texture)
+{
+	GLuint* slot = OpenGLState::getTextureSlot(target);
+	if (!slot)
+	{
+		OpenGLState::issued++;
+		glCall(glBindTexture, target, texture);
+		return;
+	}
+
+	if (OpenGLState::update(*slot, texture))
+	{
+		glCall(glBindTexture, target, texture);
+	}
+}
+
+void OpenGLState::bindFramebuffer(const GLenum target, const GLuint framebuffer)
+{
+	bool changed = false;
+	if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER)
+	{
+		changed = OpenGLState::drawFramebuffer != framebuffer;
+		OpenGLState::drawFramebuffer = framebuffer;
+	}
+	if (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER)
+	{
+		changed = changed || OpenGLState::readFramebuffer != framebuffer;
+		OpenGLState::readFramebuffer = framebuffer;
+	}
+
+	if (!changed)
+	{
+		OpenGLState::elided++;
+		return;
+	}
+	OpenGLState::issued++;
+	glCall(glBindFramebuffer, target, framebuffer);
+}
+
+void OpenGLState::viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height)
+{
+	std::array<GLint, 4> rect = { x, y, width, height };
+	if (OpenGLState::viewportRect == rect)
+	{
+		OpenGLState::elided++;
+		return;
+	}
+	OpenGLState::viewportRect = rect;
+	OpenGLState::issued++;
+	glCall(glViewport, x, y, width, height);
+}
+
+void OpenGLState::enable(const GLenum capability)
+{
+	auto it = OpenGLState::capabilities.find(capability);
+	if (it != OpenGLState::capabilities.end() && it->second)
+	{
+		OpenGLState::elided++;
+		return;
+	}
+	OpenGLState::capabilities[capability] = true;
+	OpenGLState::issued++;
+	glCall(glEnable, capability);
+}
+
+void OpenGLState::disable(const GLenum capability)
+{
+	auto it = OpenGLState::capabilities.find(capability);
+	if (it != OpenGLState::capabilities.end() && !it->second)
+	{
+		OpenGLState::elided++;
+		return;
+	}
+	OpenGLState::capabilities[capability] = false;
+	OpenGLState::issued++;
+	glCall(glDisable, capability);
+}
+
+void OpenGLState::depthMask(const GLboolean write)
+{
+	if (OpenGLState::depthWrite == write)
+	{
+		OpenGLState::elided++;
+		return;
+	}
+	OpenGLState::depthWrite = write;
+	OpenGLState::issued++;
+	glCall(glDepthMask, write);
+}
+
+void OpenGLState::blendFunc(const GLenum source, const GLenum destination)
+{
+	std::array<GLenum, 2> factors = { source, destination };
+	if (OpenGLState::blendFactors == factors)
+	{
+		OpenGLState::elided++;
+		return;
+	}
+	OpenGLState::blendFactors = factors;
+	OpenGLState::issued++;
+	glCall(glBlendFunc, source, destination);
+}
+
+void OpenGLState::deleteProgram(const GLuint program)
+{
+	// a program in use stays current until another is bound, so only the name is forgotten
+	if (OpenGLState::program == program)
+	{
+		OpenGLState::program = OpenGLState::UNKNOWN;
+	}
+	glCall(glDeleteProgram, program);
+}
+
+void OpenGLState::deleteVertexArrays(const GLsizei count, const GLuint* vertexArrays)
+{
+	if (std::find(vertexArrays, vertexArrays + count, OpenGLState::vertexArray) != vertexArrays + count)
+	{
+		OpenGLState::vertexArray = 0;
+		OpenGLState::buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	}
+	glCall(glDeleteVertexArrays, count, vertexArrays);
+}
+
+void OpenGLState::deleteBuffers(const GLsizei count, const GLuint* buffers)
+{
+	for (GLsizei i = 0; i < count; i++)
+	{
+		for (auto& [target, buffer] : OpenGLState::buffers)
+		{
+			buffer = buffer == buffers[i] ? 0 : buffer;
+		}
+		for (BufferRange& range : OpenGLState::uniformBuffers)
+		{
+			range = range.buffer == buffers[i] ? BufferRange{ 0, 0, 0 } : range;
+		}
+		for (BufferRange& range : OpenGLState::storageBuffers)
+		{
+			range = range.buffer == buffers[i] ? BufferRange{ 0, 0, 0 } : range;
+		}
+	}
+	glCall(glDeleteBuffers, count, buffers);
+}
+
+void OpenGLState::deleteTextures(const GLsizei count, const GLuint* textures)
+{
+	for (GLsizei i = 0; i < count; i++)
+	{
+		for (std::array<GLuint, 2>& unit : OpenGLState::textures)
+		{
+			for (GLuint& texture : unit)
+			{
+				texture = texture == textures[i] ? 0 : texture;
+			}
+		}
+	}
+	glCall(glDeleteTextures, count, textures);
+}
+
+void OpenGLState::deleteFramebuffers(const GLsizei count, const GLuint* framebuffers)
+{
+	for (GLsizei i = 0; i < count; i++)
+	{
+		OpenGLState::drawFramebuffer = OpenGLState::drawFramebuffer == framebuffers[i] ? 0 : OpenGLState::drawFramebuffer;
+		OpenGLState::readFramebuffer = OpenGLState::readFramebuffer == framebuffers[i] ? 0 : OpenGLState::readFramebuffer;
+	}
+	glCall(glDeleteFramebuffers, count, framebuffers);
+}
+
+void OpenGLState::endFrame()
+{
+	RenderStats::current.glCallsIssued += OpenGLState::issued;
+	RenderStats::current.glCallsElided += OpenGLState::elided;
+	OpenGLState::issued = 0;
+	OpenGLState::elided = 0;
+}
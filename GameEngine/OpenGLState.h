@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <unordered_map>
+#include <cstddef>
+#include <array>
+
+// shadow of the bound gl state for the current context, calls that would not change it are skipped
+//
+// invalidate has to be called once a context is current, and again after any plain gl call that changes this state
+struct OpenGLState
+{
+private:
+	static const GLuint UNKNOWN;
+	static const unsigned int TEXTURE_UNITS = 32;
+	static const unsigned int INDEXED_BUFFER_BINDINGS = 16;
+
+	struct BufferRange
+	{
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	static GLuint program;
+	static GLuint vertexArray;
+	static GLuint drawFramebuffer;
+	static GLuint readFramebuffer;
+	static GLenum activeUnit;
+	static std::unordered_map<GLenum, GLuint> buffers;
+	static std::array<BufferRange, INDEXED_BUFFER_BINDINGS> uniformBuffers;
+	static std::array<BufferRange, INDEXED_BUFFER_BINDINGS> storageBuffers;
+	static std::array<std::array<GLuint, 2>, TEXTURE_UNITS> textures;
+	static std::unordered_map<GLenum, bool> capabilities;
+	static std::array<GLint, 4> viewportRect;
+	static GLboolean depthWrite;
+	static std::array<GLenum, 2> blendFactors;
+
+	static std::size_t elided;
+	static std::size_t issued;
+
+	static bool update(GLuint& shadow, const GLuint value);
+
+	static GLuint* getTextureSlot(const GLenum target);
+
+	// uniform and shader storage bindings are shadowed, other indexed targets return null
+	static BufferRange* getRangeSlot(const GLenum target, const GLuint index);
+
+public:
+	// forgets everything, the next call of each kind always reaches the driver
+	static void invalidate();
+
+	static void useProgram(const GLuint program);
+
+	// the element array binding belongs to the vertex array, so it is forgotten here
+	static void bindVertexArray(const GLuint vertexArray);
+
+	static void bindBuffer(const GLenum target, const GLuint buffer);
+
+	static void bindBufferRange(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size);
+
+	static void activeTexture(const GLenum unit);
+
+	// binds to the active unit, only 2d and cube map bindings are shadowed
+	static void bindTexture(const GLenum target, const GLuint texture);
+
+	static void bindFramebuffer(const GLenum target, const GLuint framebuffer);
+
+	static void viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height);
+
+	static void enable(const GLenum capability);
+
+	static void disable(const GLenum capability);
+
+	static void depthMask(const GLboolean write);
+
+	static void blendFunc(const GLenum source, const GLenum destination);
+
+	// deleted objects are unbound by gl, the shadow has to follow or a reused name would be skipped
+	static void deleteProgram(const GLuint program);
+
+	static void deleteVertexArrays(const GLsizei count, const GLuint* vertexArrays);
+
+	static void deleteBuffers(const GLsizei count, const GLuint* buffers);
+
+	static void deleteTextures(const GLsizei count, const GLuint* textures);
+
+	static void deleteFramebuffers(const GLsizei count, const GLuint* framebuffers);
+
+	// moves the call counters into RenderStats
+	static void endFrame();
+};
@@ -9,15 +9,16 @@ PhysicsMesh::PhysicsMesh(const std::string& filename, const btVector3& position)
 	Mesh mesh = model.meshes[0];
 
 	btTriangleMesh* triMesh = new btTriangleMesh();
-	for (int i = 0; i < mesh.indices.size(); i += 3)
+	// full detail only, lower levels of detail follow it in the index list
+	for (unsigned int i = 0; i < mesh.lods[0].indexCount; i += 3)
 	{
-		Vertex v1 = mesh.vertices[mesh.indices[i]];
-		Vertex v2 = mesh.vertices[mesh.indices[i+1]];
-		Vertex v3 = mesh.vertices[mesh.indices[i+2]];
+		glm::vec3 v1 = mesh.positions[mesh.indices[i]];
+		glm::vec3 v2 = mesh.positions[mesh.indices[i+1]];
+		glm::vec3 v3 = mesh.positions[mesh.indices[i+2]];
 
-		btVector3 a(v1.Position.x, v1.Position.y, v1.Position.z);
-		btVector3 b(v2.Position.x, v2.Position.y, v2.Position.z);
-		btVector3 c(v3.Position.x, v3.Position.y, v3.Position.z);
+		btVector3 a(v1.x, v1.y, v1.z);
+		btVector3 b(v2.x, v2.y, v2.z);
+		btVector3 c(v3.x, v3.y, v3.z);
 
 		triMesh->addTriangle(a, b, c);
 	}
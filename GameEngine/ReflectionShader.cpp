@@ -2,8 +2,6 @@
 #include "ReflectionShader.h"
 
 #include "OpenGLFunctions.h"
-#include "Camera.h"
-#include "Maths.h"
 
 #include <vector>
 
@@ -24,9 +22,6 @@ void ReflectionShader::bindAttributes()
 
 void ReflectionShader::getAllUniformLocations() 
 {
-	this->location_transformationMatrix = this->getUniformLocation("transformationMatrix");
-	this->location_projectionMatrix = this->getUniformLocation("projectionMatrix");
-	this->location_viewMatrix = this->getUniformLocation("viewMatrix");
 	this->location_materialKa = this->getUniformLocation("materialKa");
 	this->location_materialKd = this->getUniformLocation("materialKd");
 	this->location_materialKs = this->getUniformLocation("materialKs");
@@ -34,28 +29,6 @@ void ReflectionShader::getAllUniformLocations()
 	this->location_materialNi = this->getUniformLocation("materialNi");
 	this->location_materialD = this->getUniformLocation("materialD");
 	this->location_materialIllum = this->getUniformLocation("materialIllum");
-	this->location_cameraPosition = this->getUniformLocation("cameraPosition");
-
-	for (int i = 0; i < this->MAX_LIGHTS; i++)
-	{
-		this->location_lightPositions[i] = this->getUniformLocation("lightPositions[" + std::to_string(i) + "]");
-		this->location_lightColors[i] = this->getUniformLocation("lightColors[" + std::to_string(i) + "]");
-	}
-}
-
-void ReflectionShader::loadTransformationMatrix(const glm::mat4& matrix)
-{
-	this->loadMat4(this->location_transformationMatrix, matrix);
-}
-
-void ReflectionShader::loadProjectionMatrix(const glm::mat4& matrix)
-{
-	this->loadMat4(this->location_projectionMatrix, matrix);
-}
-
-void ReflectionShader::loadViewMatrix()
-{
-	this->loadMat4(this->location_viewMatrix, Camera::viewMatrix);
 }
 
 void ReflectionShader::loadMaterialInfo(const Material& mat)
@@ -67,18 +40,4 @@ void ReflectionShader::loadMaterialInfo(const Material& mat)
 	this->loadFloat(this->location_materialNi, mat.Ni);
 	this->loadFloat(this->location_materialD, mat.d);
 	this->loadInt(this->location_materialIllum, mat.illum);
-}
-
-void ReflectionShader::loadLights(const std::vector<Light>& lights)
-{
-	for (int i = 0; i < lights.size() && i < 4; i++)
-	{
-		this->loadVec3(this->location_lightPositions[i], lights[i].position);
-		this->loadVec3(this->location_lightColors[i], lights[i].color);
-	}
-}
-
-void ReflectionShader::loadCameraPosition()
-{
-	this->loadVec3(this->location_cameraPosition, Camera::position);
 }
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "RenderQueue.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <array>
+#include <bit>
+
+#include "OpenGLFunctions.h"
+#include "MeshletBuilder.h"
+#include "GeometryArena.h"
+#include "RenderStats.h"
+#include "UniformBuffers.h"
+#include "OpenGLState.h"
+#include "AssetCache.h"
+#include "RingBuffer.h"
+#include "Camera.h"
+#include "Config.h"
+
+namespace
+{
+	const std::uint64_t PASS_OPAQUE = 0;
+	const std::uint64_t PASS_TRANSPARENT = 1;
+
+	// positive floats order the same as their bit patterns, the top 24 bits keep the exponent and most of the mantissa
+	std::uint64_t quantizeDepth(const float depth)
+	{
+		return std::bit_cast<std::uint32_t>(std::max(depth, 0.0f)) >> 8;
+	}
+
+	// ids only order the keys, binds are skipped on the state itself
+	bool sameMaterial(const DrawItem& item, const DrawItem& previous)
+	{
+		return item.mesh == previous.mesh || std::memcmp(&item.mesh->mat, &previous.mesh->mat, sizeof(Material)) == 0;
+	}
+
+	bool sameTextures(const DrawItem& item, const DrawItem& previous)
+	{
+		if (item.cubeMap != previous.cubeMap)
+		{
+			return false;
+		}
+		if (item.mesh == previous.mesh)
+		{
+			return true;
+		}
+
+		const std::vector<Texture>& textures = item.mesh->textures;
+		const std::vector<Texture>& previousTextures = previous.mesh->textures;
+		return std::equal(textures.begin(), textures.end(), previousTextures.begin(), previousTextures.end(), [](const Texture& a, const Texture& b)
+		{
+			return a.ID == b.ID && a.Type == b.Type;
+		});
+	}
+}
+
+RenderQueue::RenderQueue(BSDFShader& bsdfShader, ReflectionShader& reflectionShader) :
+	bsdfShader(bsdfShader), reflectionShader(reflectionShader)
+{
+
+}
+
+std::uint16_t RenderQueue::getId(std::unordered_map<std::uint64_t, std::uint16_t>& ids, const std::uint64_t hash)
+{
+	auto it = ids.find(hash);
+	if (it != ids.end())
+	{
+		return it->second;
+	}
+
+	// ids are handed out again from zero once they run out, which only costs the sort some adjacency
+	if (ids.size() > std::numeric_limits<std::uint16_t>::max())
+	{
+		ids.clear();
+	}
+
+	std::uint16_t id = (std::uint16_t)ids.size();
+	ids.emplace(hash, id);
+	return id;
+}
+
+std::uint64_t RenderQueue::createKey(const DrawItem& item)
+{
+	glm::vec3 center = glm::vec3(item.transform * glm::vec4((item.mesh->boundsMin + item.mesh->boundsMax) * 0.5f, 1.0f));
+	std::uint64_t depth = quantizeDepth(glm::length(center - Camera::position));
+	std::uint64_t state = ((std::uint64_t)item.shader << 32) | ((std::uint64_t)item.material << 16) | item.textureSet;
+
+	if (item.transparent)
+	{
+		return (PASS_TRANSPARENT << 62) | ((~depth & 0xFFFFFF) << 38) | state;
+	}
+
+	// copies of a mesh sort next to each other so they can be instanced, depth only orders them coarsely
+	return (PASS_OPAQUE << 62) | (state << 24) | ((std::uint64_t)(item.geometry & 0xFFF) << 12) | (depth >> 12);
+}
+
+void RenderQueue::begin(const glm::mat4& projectionMatrix)
+{
+	this->projectionMatrix = projectionMatrix;
+	this->frustumPlanes = MeshletBuilder::getFrustumPlanes(projectionMatrix * Camera::viewMatrix);
+	this->items.clear();
+	this->keys.clear();
+	this->culler.clear();
+}
+
+void RenderQueue::submit(Model& model, const RenderShader shader, const glm::mat4& transformationMatrix, LodState* lodState, PlacementBounds* bounds,
+	const GLuint cubeMap)
+{
+	// the scratch bounds may hold another model's meshes at the same transform, so they are always recomputed
+	PlacementBounds& placement = bounds ? *bounds : this->scratchBounds;
+	if (!bounds)
+	{
+		placement.meshes.clear();
+	}
+	model.updateBounds(transformationMatrix, placement);
+
+	unsigned int lod = model.selectLod(transformationMatrix, this->projectionMatrix, lodState ? *lodState : model.lodState);
+	for (std::size_t i = 0; i < model.meshes.size(); i++)
+	{
+		Mesh& mesh = model.meshes[i];
+		this->culler.add(placement.meshes[i]);
+
+		std::uint64_t textureHash = AssetCache::hash(&cubeMap, sizeof(cubeMap));
+		for (const Texture& texture : mesh.textures)
+		{
+			textureHash = AssetCache::hash(&texture.ID, sizeof(texture.ID), textureHash);
+		}
+
+		DrawItem item;
+		item.mesh = &mesh;
+		item.lod = lod;
+		item.shader = shader;
+		item.material = RenderQueue::getId(this->materialIds, AssetCache::hash(&mesh.mat, sizeof(Material)));
+		item.textureSet = RenderQueue::getId(this->textureSetIds, textureHash);
+		item.geometry = RenderQueue::getId(this->geometryIds, AssetCache::hash(&lod, sizeof(lod), (std::uint64_t)&mesh));
+		item.transparent = mesh.mat.d < 1.0f;
+		item.cubeMap = cubeMap;
+		item.transform = transformationMatrix;
+
+		this->keys.push_back(RenderQueue::createKey(item));
+		this->items.push_back(item);
+	}
+}
+
+void RenderQueue::cull()
+{
+	if (!Config::Models::FRUSTUM_CULLING)
+	{
+		return;
+	}
+
+	this->culler.cull(this->frustumPlanes, this->visible);
+
+	// items and keys were added in the same order as the bounds, so both are compacted in place
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < this->items.size(); i++)
+	{
+		if (this->visible[i])
+		{
+			this->items[kept] = this->items[i];
+			this->keys[kept] = this->keys[i];
+			kept++;
+		}
+	}
+
+	RenderStats::current.meshesTested += this->items.size();
+	RenderStats::current.meshesCulled += this->items.size() - kept;
+	this->items.resize(kept);
+	this->keys.resize(kept);
+}
+
+void RenderQueue::sort()
+{
+	std::size_t count = this->keys.size();
+	this->order.resize(count);
+	for (std::uint32_t i = 0; i < count; i++)
+	{
+		this->order[i] = i;
+	}
+	this->sortedKeys.resize(count);
+	this->sortedOrder.resize(count);
+
+	// least significant byte first, stable passes so earlier bytes stay ordered, bytes shared by every key are skipped
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		std::array<std::size_t, 256> histogram = {};
+		for (std::uint64_t key : this->keys)
+		{
+			histogram[(key >> shift) & 0xFF]++;
+		}
+		if (count == 0 || histogram[(this->keys[0] >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		std::size_t offset = 0;
+		for (std::size_t& bucket : histogram)
+		{
+			std::size_t size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			std::size_t destination = histogram[(this->keys[i] >> shift) & 0xFF]++;
+			this->sortedKeys[destination] = this->keys[i];
+			this->sortedOrder[destination] = this->order[i];
+		}
+		this->keys.swap(this->sortedKeys);
+		this->order.swap(this->sortedOrder);
+	}
+}
+
+void RenderQueue::batch()
+{
+	this->batchStarts.clear();
+	for (std::size_t i = 0; i < this->order.size(); i++)
+	{
+		const DrawItem& item = this->items[this->order[i]];
+		const DrawItem* previous = i > 0 ? &this->items[this->order[i - 1]] : nullptr;
+
+		// one mesh carries one material and texture set, so only the placement's cube map can still differ
+		bool sameDraw = previous && item.mesh == previous->mesh && item.lod == previous->lod && item.shader == previous->shader &&
+			item.transparent == previous->transparent && item.cubeMap == previous->cubeMap;
+		if (!Config::Models::INSTANCING || !sameDraw)
+		{
+			this->batchStarts.push_back(i);
+		}
+	}
+	this->batchStarts.push_back(this->order.size());
+}
+
+void RenderQueue::group()
+{
+	this->groupStarts.clear();
+	for (std::size_t b = 0; b + 1 < this->batchStarts.size(); b++)
+	{
+		const DrawItem& item = this->items[this->order[this->batchStarts[b]]];
+		const DrawItem* previous = b > 0 ? &this->items[this->order[this->batchStarts[b - 1]]] : nullptr;
+
+		// transparent draws keep their order, so only runs the sort already made adjacent are merged
+		bool sameState = previous && item.shader == previous->shader && sameMaterial(item, *previous) && sameTextures(item, *previous) &&
+			item.transparent == previous->transparent && item.mesh->getGeometryPool() == previous->mesh->getGeometryPool();
+		if (!Config::Models::MULTI_DRAW_INDIRECT || !sameState)
+		{
+			this->groupStarts.push_back(b);
+		}
+	}
+	this->groupStarts.push_back(this->batchStarts.size() - 1);
+}
+
+void RenderQueue::uploadCommands()
+{
+	std::size_t size = this->commands.size() * sizeof(DrawElementsIndirectCommand);
+	RingAllocation allocation = RingBuffer::write(this->commands.data(), size, sizeof(DrawElementsIndirectCommand));
+	this->indirectBuffer = allocation.buffer;
+	this->indirectOffset = allocation.offset;
+	RenderStats::current.bufferUploads++;
+}
+
+ShaderProgram& RenderQueue::startShader(const RenderShader shader)
+{
+	// camera and lights come from the frame uniform block, starting the program is all that is needed
+	ShaderProgram& program = shader == RenderShader::reflection ? (ShaderProgram&)this->reflectionShader : (ShaderProgram&)this->bsdfShader;
+	program.start();
+	return program;
+}
+
+void RenderQueue::flush()
+{
+	this->cull();
+	this->sort();
+	this->batch();
+	this->group();
+
+	// every transform of the pass goes up in one upload, each group gets its own range and instance i of a batch reads its base instance plus i
+	this->groupOffsets.clear();
+	for (std::size_t g = 0; g + 1 < this->groupStarts.size(); g++)
+	{
+		this->objects.clear();
+		for (std::size_t i = this->batchStarts[this->groupStarts[g]]; i < this->batchStarts[this->groupStarts[g + 1]]; i++)
+		{
+			const DrawItem& item = this->items[this->order[i]];
+			this->objects.push_back(UniformBuffers::createObject(item.transform, item.mesh->quantization));
+		}
+		this->groupOffsets.push_back(UniformBuffers::stageObjects(this->objects));
+	}
+	std::size_t firstObject = UniformBuffers::uploadObjects();
+
+	// commands are written for every group before any is drawn so they also go up in one upload
+	std::size_t triangles = 0;
+	this->commands.clear();
+	this->groupCommands.clear();
+	if (Config::Models::MULTI_DRAW_INDIRECT)
+	{
+		for (std::size_t g = 0; g + 1 < this->groupStarts.size(); g++)
+		{
+			this->groupCommands.push_back(this->commands.size());
+			std::size_t groupStart = this->batchStarts[this->groupStarts[g]];
+			for (std::size_t b = this->groupStarts[g]; b < this->groupStarts[g + 1]; b++)
+			{
+				const DrawItem& item = this->items[this->order[this->batchStarts[b]]];
+				GLuint instanceCount = (GLuint)(this->batchStarts[b + 1] - this->batchStarts[b]);
+				triangles += item.mesh->appendCommands(item.lod, item.transform, this->projectionMatrix, instanceCount, (GLuint)(this->batchStarts[b] - groupStart),
+					this->commands);
+			}
+		}
+		this->groupCommands.push_back(this->commands.size());
+		this->uploadCommands();
+	}
+
+	ShaderProgram* program = nullptr;
+	const DrawItem* previous = nullptr;
+	bool blending = false;
+	for (std::size_t g = 0; g + 1 < this->groupStarts.size(); g++)
+	{
+		const DrawItem& item = this->items[this->order[this->batchStarts[this->groupStarts[g]]]];
+		std::size_t instanceCount = this->batchStarts[this->groupStarts[g + 1]] - this->batchStarts[this->groupStarts[g]];
+
+		if (item.transparent != blending)
+		{
+			blending = item.transparent;
+			if (blending)
+			{
+				OpenGLState::enable(GL_BLEND);
+				OpenGLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				OpenGLState::depthMask(GL_FALSE);
+			}
+			else
+			{
+				OpenGLState::depthMask(GL_TRUE);
+			}
+		}
+
+		// a new program invalidates every uniform, so everything after it is reloaded
+		if (!previous || item.shader != previous->shader)
+		{
+			program = &this->startShader(item.shader);
+			RenderStats::current.shaderChanges++;
+			previous = nullptr;
+		}
+
+		if (!previous || !sameMaterial(item, *previous))
+		{
+			if (item.shader == RenderShader::reflection)
+			{
+				this->reflectionShader.loadMaterialInfo(item.mesh->mat);
+			}
+			else
+			{
+				this->bsdfShader.loadMaterialInfo(item.mesh->mat);
+			}
+			RenderStats::current.materialChanges++;
+		}
+
+		if (!previous || !sameTextures(item, *previous))
+		{
+			item.mesh->bindTextures(program->getProgramID(), item.cubeMap);
+			RenderStats::current.textureChanges++;
+		}
+
+		// meshes of one pool share the vertex array, only the material block changes between them
+		if (!previous || item.mesh != previous->mesh)
+		{
+			if (!previous || item.mesh->vao != previous->mesh->vao)
+			{
+				RenderStats::current.vertexArrayChanges++;
+			}
+			item.mesh->bindVertexArray();
+		}
+
+		UniformBuffers::bindObjects(firstObject + this->groupOffsets[g], instanceCount);
+		if (Config::Models::MULTI_DRAW_INDIRECT)
+		{
+			std::size_t commandCount = this->groupCommands[g + 1] - this->groupCommands[g];
+			if (commandCount > 0)
+			{
+				OpenGLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, this->indirectBuffer);
+				glMultiDrawElementsIndirect(GL_TRIANGLES, GeometryArena::getIndexType(item.mesh->getGeometryPool()),
+					(const void*)(this->indirectOffset + this->groupCommands[g] * sizeof(DrawElementsIndirectCommand)), (GLsizei)commandCount, 0);
+				RenderStats::current.drawCalls++;
+				RenderStats::current.indirectCommands += commandCount;
+			}
+			RenderStats::current.instances += instanceCount;
+		}
+		else if (instanceCount == 1)
+		{
+			// single items keep meshlet culling, runs draw whole levels
+			item.mesh->drawLod(item.lod, item.transform, this->projectionMatrix);
+		}
+		else
+		{
+			item.mesh->drawLodInstanced(item.lod, instanceCount);
+		}
+		previous = &item;
+	}
+	RenderStats::current.triangles += triangles;
+
+	if (blending)
+	{
+		OpenGLState::depthMask(GL_TRUE);
+	}
+	if (program)
+	{
+		program->stop();
+	}
+}
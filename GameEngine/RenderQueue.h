@@ -0,0 +1,117 @@
+#pragma once
+
+#include <unordered_map>
+#include <cstdint>
+#include <vector>
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include "ReflectionShader.h"
+#include "UniformBuffers.h"
+#include "FrustumCuller.h"
+#include "BSDFShader.h"
+#include "Model.h"
+#include "Mesh.h"
+
+enum class RenderShader : std::uint8_t
+{
+	bsdf,
+	reflection
+};
+
+struct DrawItem
+{
+	Mesh* mesh;
+	unsigned int lod;
+	RenderShader shader;
+	std::uint16_t material;
+	std::uint16_t textureSet;
+	std::uint16_t geometry;
+	bool transparent;
+	GLuint cubeMap;
+	glm::mat4 transform;
+};
+
+// draws collected for a pass, ordered by a 64 bit key so the dispatch only changes state between items that differ
+// and consecutive copies of the same mesh and level become one instanced draw
+//
+// with multi draw indirect every run of draws sharing the shader, material, textures and arena pool is one
+// glMultiDrawElementsIndirect call, so the cpu cost per draw is writing a command
+//
+// opaque:      pass 2 | shader 6 | material 16 | textures 16 | geometry 12 | depth 12 (front to back)
+// transparent: pass 2 | depth 24 (back to front) | shader 6 | material 16 | textures 16
+class RenderQueue
+{
+private:
+	BSDFShader& bsdfShader;
+	ReflectionShader& reflectionShader;
+
+	glm::mat4 projectionMatrix = glm::mat4(1.0f);
+	std::array<glm::vec4, 6> frustumPlanes;
+
+	// bounds of every submitted item, culled together at flush
+	FrustumCuller culler;
+	std::vector<std::uint8_t> visible;
+	PlacementBounds scratchBounds;
+
+	std::vector<DrawItem> items;
+	std::vector<std::uint64_t> keys;
+	std::vector<std::uint32_t> order;
+	std::vector<ObjectUniforms> objects;
+
+	// runs of sorted items drawn together as instances, first item of each
+	std::vector<std::size_t> batchStarts;
+
+	// runs of batches sharing all state, first batch, object block offset and first indirect command of each
+	std::vector<std::size_t> groupStarts;
+	std::vector<std::size_t> groupOffsets;
+	std::vector<std::size_t> groupCommands;
+
+	std::vector<DrawElementsIndirectCommand> commands;
+	// ring buffer allocation the commands of the flush were written to
+	GLuint indirectBuffer = 0;
+	std::size_t indirectOffset = 0;
+
+	// scratch for the radix sort
+	std::vector<std::uint64_t> sortedKeys;
+	std::vector<std::uint32_t> sortedOrder;
+
+	// small ids for materials, texture sets and geometry that group the sort keys
+	std::unordered_map<std::uint64_t, std::uint16_t> materialIds;
+	std::unordered_map<std::uint64_t, std::uint16_t> textureSetIds;
+	std::unordered_map<std::uint64_t, std::uint16_t> geometryIds;
+
+	static std::uint16_t getId(std::unordered_map<std::uint64_t, std::uint16_t>& ids, const std::uint64_t hash);
+
+	static std::uint64_t createKey(const DrawItem& item);
+
+	void sort();
+
+	// drops items whose bounds are outside the frustum, before anything is sorted
+	void cull();
+
+	// splits the sorted items into runs that can share one draw call
+	void batch();
+
+	// splits the batches into runs that can share one indirect call, every batch is its own group without multi draw indirect
+	void group();
+
+	void uploadCommands();
+
+	ShaderProgram& startShader(const RenderShader shader);
+
+public:
+	RenderQueue(BSDFShader& bsdfShader, ReflectionShader& reflectionShader);
+
+	// clears the queue, the matrix selects levels of detail and culls meshes and meshlets, the shaders read theirs from the frame block
+	void begin(const glm::mat4& projectionMatrix);
+
+	// placements that keep their bounds between frames only transform them again when their transform changes,
+	// a cube map replaces the meshes' own for this placement
+	void submit(Model& model, const RenderShader shader, const glm::mat4& transformationMatrix, LodState* lodState = nullptr, PlacementBounds* bounds = nullptr,
+		const GLuint cubeMap = 0);
+
+	// sorts and draws everything submitted since begin, state changes are counted in RenderStats
+	void flush();
+};
@@ -0,0 +1,10 @@
+#include "RenderStats.h"
+
+FrameStats RenderStats::current;
+FrameStats RenderStats::last;
+
+void RenderStats::endFrame()
+{
+	RenderStats::last = RenderStats::current;
+	RenderStats::current = FrameStats();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+
+struct FrameStats
+{
+	std::size_t drawCalls = 0;
+	std::size_t instances = 0;
+	std::size_t indirectCommands = 0;
+	std::size_t triangles = 0;
+	std::size_t objectsTested = 0;
+	std::size_t objectsCulled = 0;
+	std::size_t objectsOccluded = 0;
+	std::size_t meshesTested = 0;
+	std::size_t meshesCulled = 0;
+	std::size_t clustersTested = 0;
+	std::size_t clustersCulled = 0;
+
+	// state changes made by the render queue
+	std::size_t shaderChanges = 0;
+	std::size_t materialChanges = 0;
+	std::size_t textureChanges = 0;
+	std::size_t vertexArrayChanges = 0;
+
+	// gl binding and state calls sent to the driver and skipped by OpenGLState
+	std::size_t glCallsIssued = 0;
+	std::size_t glCallsElided = 0;
+
+	// individual uniform loads through ShaderProgram and writes to the frame and object uniform buffers
+	std::size_t uniformLoads = 0;
+	std::size_t bufferUploads = 0;
+
+	// bytes handed out by the ring buffer and frames that had to wait for the gpu to release a slice
+	std::size_t ringBytes = 0;
+	std::size_t ringWaits = 0;
+
+	// strings laid out and glyph instances written, retained text only counts the glyphs that changed
+	std::size_t textLayouts = 0;
+	std::size_t glyphUploads = 0;
+
+	// glyphs rasterized into the font atlas, dirty page rectangles sent to the texture and pages cleared to make room
+	std::size_t glyphsRasterized = 0;
+	std::size_t atlasUploads = 0;
+	std::size_t atlasEvictions = 0;
+
+	// milliseconds of software occlusion, the first two run on its worker thread
+	double occlusionRasterize = 0.0;
+	double occlusionPyramid = 0.0;
+	double occlusionWait = 0.0;
+	double occlusionTest = 0.0;
+};
+
+// counters filled in by the renderer during a frame, shown in the stats overlay
+struct RenderStats
+{
+	// frame being recorded
+	static FrameStats current;
+
+	// last completed frame
+	static FrameStats last;
+
+	static void endFrame();
+};
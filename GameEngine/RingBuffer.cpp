@@ -0,0 +1,152 @@
+#include "RingBuffer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "OpenGLFunctions.h"
+#include "OpenGLState.h"
+#include "RenderStats.h"
+
+GLuint RingBuffer::buffer = 0;
+unsigned char* RingBuffer::mapped = nullptr;
+std::size_t RingBuffer::sliceSize = 0;
+std::size_t RingBuffer::cursor = 0;
+unsigned int RingBuffer::slice = 0;
+std::vector<GLsync> RingBuffer::fences;
+std::size_t RingBuffer::frame = 0;
+std::vector<std::pair<GLuint, std::size_t>> RingBuffer::retired;
+
+const unsigned int RingBuffer::FRAMES_IN_FLIGHT = 3;
+const std::size_t RingBuffer::INITIAL_SLICE_SIZE = 4 * 1024 * 1024;
+
+void RingBuffer::init()
+{
+	RingBuffer::frame = 0;
+	RingBuffer::create(RingBuffer::INITIAL_SLICE_SIZE);
+}
+
+void RingBuffer::create(const std::size_t sliceSize)
+{
+	for (GLsync& fence : RingBuffer::fences)
+	{
+		if (fence != nullptr)
+		{
+			glCall(glDeleteSync, fence);
+		}
+	}
+	RingBuffer::fences.assign(RingBuffer::FRAMES_IN_FLIGHT, nullptr);
+
+	RingBuffer::sliceSize = sliceSize;
+	RingBuffer::slice = 0;
+	RingBuffer::cursor = 0;
+
+	// immutable storage, mapped once for the lifetime of the buffer
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	std::size_t size = sliceSize * RingBuffer::FRAMES_IN_FLIGHT;
+	glCall(glGenBuffers, 1, &RingBuffer::buffer);
+	OpenGLState::bindBuffer(GL_COPY_WRITE_BUFFER, RingBuffer::buffer);
+	glCall(glBufferStorage, GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, nullptr, flags);
+	RingBuffer::mapped = (unsigned char*)glCall(glMapBufferRange, GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)size, flags);
+	OpenGLState::bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// every frame writes its dynamic data through the mapping, there is nothing to draw with without it
+	if (RingBuffer::mapped == nullptr)
+	{
+		spdlog::error("Failed to map ring buffer of {:d} bytes", size);
+		exit(-1);
+	}
+}
+
+RingAllocation RingBuffer::allocate(const std::size_t size, const std::size_t alignment)
+{
+	std::size_t sliceStart = RingBuffer::slice * RingBuffer::sliceSize;
+	std::size_t offset = (RingBuffer::cursor + alignment - 1) / alignment * alignment;
+	if (offset + size > sliceStart + RingBuffer::sliceSize)
+	{
+		// draws of this frame may still have the old buffer bound, so it is kept until they are done
+		std::size_t required = offset - sliceStart + size;
+		std::size_t grownSize = RingBuffer::sliceSize * 2;
+		while (grownSize < required * 2)
+		{
+			grownSize *= 2;
+		}
+		spdlog::warn("Ring buffer slice of {:d} bytes is full, growing it to {:d} bytes", RingBuffer::sliceSize, grownSize);
+
+		RingBuffer::retired.push_back({ RingBuffer::buffer, RingBuffer::frame });
+		RingBuffer::create(grownSize);
+		offset = 0;
+	}
+
+	RingBuffer::cursor = offset + size;
+	RenderStats::current.ringBytes += size;
+	return { RingBuffer::buffer, offset, RingBuffer::mapped + offset };
+}
+
+RingAllocation RingBuffer::write(const void* data, const std::size_t size, const std::size_t alignment)
+{
+	RingAllocation allocation = RingBuffer::allocate(size, alignment);
+	std::memcpy(allocation.data, data, size);
+	return allocation;
+}
+
+void RingBuffer::endFrame()
+{
+	RingBuffer::fences[RingBuffer::slice] = glCall(glFenceSync, GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	RingBuffer::slice = (RingBuffer::slice + 1) % RingBuffer::FRAMES_IN_FLIGHT;
+	RingBuffer::cursor = RingBuffer::slice * RingBuffer::sliceSize;
+	RingBuffer::frame++;
+
+	GLsync& fence = RingBuffer::fences[RingBuffer::slice];
+	if (fence != nullptr)
+	{
+		if (glCall(glClientWaitSync, fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			RenderStats::current.ringWaits++;
+			while (glCall(glClientWaitSync, fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+			{
+			}
+		}
+		glCall(glDeleteSync, fence);
+		fence = nullptr;
+	}
+
+	std::erase_if(RingBuffer::retired, [](const std::pair<GLuint, std::size_t>& retiredBuffer)
+		{
+			if (retiredBuffer.second + RingBuffer::FRAMES_IN_FLIGHT > RingBuffer::frame)
+			{
+				return false;
+			}
+			OpenGLState::deleteBuffers(1, &retiredBuffer.first);
+			return true;
+		});
+}
+
+std::size_t RingBuffer::getSliceSize()
+{
+	return RingBuffer::sliceSize;
+}
+
+void RingBuffer::destroy()
+{
+	for (GLsync& fence : RingBuffer::fences)
+	{
+		if (fence != nullptr)
+		{
+			glCall(glDeleteSync, fence);
+		}
+	}
+	RingBuffer::fences.clear();
+
+	for (const std::pair<GLuint, std::size_t>& retiredBuffer : RingBuffer::retired)
+	{
+		OpenGLState::deleteBuffers(1, &retiredBuffer.first);
+	}
+	RingBuffer::retired.clear();
+
+	OpenGLState::deleteBuffers(1, &RingBuffer::buffer);
+	RingBuffer::buffer = 0;
+	RingBuffer::mapped = nullptr;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// part of the ring handed out for one frame, data is written by the cpu and read by draws issued after the write
+struct RingAllocation
+{
+	GLuint buffer = 0;
+	std::size_t offset = 0;
+	unsigned char* data = nullptr;
+};
+
+// one persistently mapped, coherent buffer split into a slice per frame in flight, dynamic data of a frame is bump
+// allocated from its slice with no gl call
+//
+// each slice is fenced at the end of its frame and only reused once that fence has passed, so the cpu waits only when
+// the gpu falls FRAMES_IN_FLIGHT frames behind
+struct RingBuffer
+{
+private:
+	static GLuint buffer;
+	static unsigned char* mapped;
+	static std::size_t sliceSize;
+	static std::size_t cursor;
+	static unsigned int slice;
+	static std::vector<GLsync> fences;
+	static std::size_t frame;
+
+	// buffers replaced by a larger one and the frame they were replaced in, deleted once no frame in flight can read them
+	static std::vector<std::pair<GLuint, std::size_t>> retired;
+
+	static void create(const std::size_t sliceSize);
+
+public:
+	static const unsigned int FRAMES_IN_FLIGHT;
+	static const std::size_t INITIAL_SLICE_SIZE;
+
+	static void init();
+
+	// alignment is the binding's offset alignment, a frame outgrowing its slice moves the ring to a buffer with twice the slice size
+	static RingAllocation allocate(const std::size_t size, const std::size_t alignment);
+
+	// copies the data into a new allocation
+	static RingAllocation write(const void* data, const std::size_t size, const std::size_t alignment);
+
+	// fences the slice of the frame and moves to the next one, waiting only when the gpu is still reading it
+	static void endFrame();
+
+	static std::size_t getSliceSize();
+
+	static void destroy();
+};
@@ -0,0 +1,65 @@
+#include "Scene.h"
+
+SceneObject* Scene::findObject(const std::string& name)
+{
+	for (SceneObject& object : this->objects)
+	{
+		if (object.name == name)
+		{
+			return &object;
+		}
+	}
+	return nullptr;
+}
+
+void Scene::buildIndex()
+{
+	this->index.clear();
+	for (std::uint32_t i = 0; i < this->objects.size(); i++)
+	{
+		SceneObject& object = this->objects[i];
+		object.model->updateBounds(object.transform, object.bounds);
+		object.proxy = this->index.insert(object.bounds.min, object.bounds.max, i);
+	}
+}
+
+void Scene::updateBounds(const std::uint32_t object, const glm::mat4& transformationMatrix)
+{
+	SceneObject& sceneObject = this->objects[object];
+	if (sceneObject.model->updateBounds(transformationMatrix, sceneObject.bounds))
+	{
+		this->index.move(sceneObject.proxy, sceneObject.bounds.min, sceneObject.bounds.max);
+	}
+}
+
+void Scene::queryFrustum(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<std::uint32_t>& objects)
+{
+	this->index.queryFrustum(frustumPlanes, objects);
+}
+
+void Scene::querySphere(const glm::vec3& center, const float radius, std::vector<std::uint32_t>& objects)
+{
+	this->index.querySphere(center, radius, objects);
+}
+
+void Scene::queryRay(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, std::vector<std::uint32_t>& objects)
+{
+	this->index.queryRay(origin, direction, maxDistance, objects);
+}
+
+void Scene::addOccluders(OcclusionCuller& culler) const
+{
+	for (const SceneObject& object : this->objects)
+	{
+		if (!object.occluder)
+		{
+			continue;
+		}
+
+		for (const Mesh& mesh : object.model->meshes)
+		{
+			const MeshLod& level = mesh.lods[0];
+			culler.addOccluder(mesh.positions, std::span<const unsigned int>(mesh.indices).subspan(level.indexOffset, level.indexCount), object.transform);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+
+#include <glm/common.hpp>
+
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "PhysicsManager.h"
+#include "FrustumCuller.h"
+#include "PhysicsBox.h"
+#include "Source.h"
+#include "Model.h"
+#include "Light.h"
+
+// placement of a shared model, many objects can point at the same model
+struct SceneObject
+{
+	std::string name;
+	std::string shader;
+	Model* model;
+	glm::mat4 transform;
+	LodState lod;
+	PlacementBounds bounds;
+	std::int32_t proxy = BoundingVolumeHierarchy::NULL_NODE;
+	// environment sampled by this placement, 0 keeps the meshes' own cube map or the empty one
+	GLuint cubeMap = 0;
+	// drawn into the occlusion buffer and never tested against it
+	bool occluder = false;
+};
+
+struct SceneLoadTimings
+{
+	double parse = 0.0;
+	double cook = 0.0;
+	double models = 0.0;
+	double audio = 0.0;
+	double physics = 0.0;
+	double total = 0.0;
+};
+
+class Scene
+{
+public:
+	std::vector<std::unique_ptr<Model>> models;
+	std::vector<SceneObject> objects;
+	std::vector<Light> lights;
+	std::vector<std::unique_ptr<Source>> sources;
+	std::vector<PhysicsBox> bodies;
+	std::unique_ptr<PhysicsManager> physicsManager;
+	SceneLoadTimings timings;
+
+	// placements by world bounds, leaves hold the index of the object
+	BoundingVolumeHierarchy index;
+
+	SceneObject* findObject(const std::string& name);
+
+	// adds every object at its own transform, called once the objects are loaded
+	void buildIndex();
+
+	// bounds of an object drawn at a transform other than its own, the index only changes when they leave the leaf's margin
+	void updateBounds(const std::uint32_t object, const glm::mat4& transformationMatrix);
+
+	void queryFrustum(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<std::uint32_t>& objects);
+
+	void querySphere(const glm::vec3& center, const float radius, std::vector<std::uint32_t>& objects);
+
+	void queryRay(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, std::vector<std::uint32_t>& objects);
+
+	// full detail triangles of every occluder at its own transform, simplified levels could cover more than the mesh does
+	void addOccluders(OcclusionCuller& culler) const;
+};
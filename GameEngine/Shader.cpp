@@ -1,9 +1,6 @@
 
 #include "Shader.h"
 
-#include "Camera.h"
-#include "Maths.h"
-
 Shader::Shader(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename) : 
 	ShaderProgram::ShaderProgram(vertexShaderFilename, fragmentShaderFilename)
 {
@@ -21,22 +18,5 @@ void Shader::bindAttributes()
 
 void Shader::getAllUniformLocations() 
 {
-	this->location_transformationMatrix = this->getUniformLocation("transformationMatrix");
-	this->location_projectionMatrix = this->getUniformLocation("projectionMatrix");
-	this->location_viewMatrix = this->getUniformLocation("viewMatrix");
-}
-
-void Shader::loadTransformationMatrix(const glm::mat4& matrix)
-{ 
-	this->loadMat4(this->location_transformationMatrix, matrix); 
-}
-
-void Shader::loadProjectionMatrix(const glm::mat4& matrix)
-{ 
-	this->loadMat4(this->location_projectionMatrix, matrix); 
-}
-
-void Shader::loadViewMatrix() 
-{
-	this->loadMat4(this->location_viewMatrix, Camera::viewMatrix);
+	// camera and object data come from the FrameBlock and ObjectBlock uniform buffers
 }
@@ -1,14 +1,11 @@
 #pragma once
 
 #include "ShaderProgram.h"
+#include "Vertex.h"
 
 class Shader : public ShaderProgram 
 {
 public:
-	int location_transformationMatrix;
-	int location_projectionMatrix;
-	int location_viewMatrix;
-
 	Shader() = default;
 
 	Shader(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename);
@@ -18,10 +15,4 @@ public:
 	void bindAttributes();
 
 	void getAllUniformLocations();
-
-	void loadTransformationMatrix(const glm::mat4& matrix);
-
-	void loadProjectionMatrix(const glm::mat4& matrix);
-
-	void loadViewMatrix();
 };
@@ -6,15 +6,61 @@
 
 #include <spdlog/spdlog.h>
 
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <format>
 
 #include "OpenGLFunctions.h"
+#include "OpenGLState.h"
+#include "RenderStats.h"
+#include "AssetCache.h"
+#include "Config.h"
+
+namespace
+{
+	struct ProgramBinaryHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t format;
+		std::uint32_t size;
+	};
+
+	double getMilliseconds(const std::chrono::high_resolution_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	std::string getDriverString(const GLenum name)
+	{
+		const GLubyte* value = glCall(glGetString, name);
+		return value ? reinterpret_cast<const char*>(value) : "";
+	}
+}
+
+const std::uint32_t ShaderProgram::MAGIC = 0x52504547; // "GEPR"
+const std::uint32_t ShaderProgram::VERSION = 1;
+
+ProgramCacheStats ShaderProgram::cacheStats;
 
 ShaderProgram::ShaderProgram(const std::string& vertexFilename, const std::string& fragmentFilename, const std::string& tessellationControlFilename, 
 	const std::string& tessellationEvaluationFilename, const std::string& geometryFilename)
 {
+	auto start = std::chrono::high_resolution_clock::now();
+	std::string cookedPath = ShaderProgram::getCookedPath({ vertexFilename, fragmentFilename, tessellationControlFilename, tessellationEvaluationFilename, geometryFilename });
+	if (!cookedPath.empty() && this->loadProgramBinary(cookedPath))
+	{
+		ShaderProgram::cacheStats.restored++;
+		ShaderProgram::cacheStats.restoreMilliseconds += getMilliseconds(start);
+		spdlog::debug("Restored program '{}' from '{}'", vertexFilename, cookedPath);
+
+		this->getAllUniformLocations();
+		return;
+	}
+
 	this->vertexShaderID = this->loadShader(vertexFilename, GL_VERTEX_SHADER);
 	this->fragmentShaderID = this->loadShader(fragmentFilename, GL_FRAGMENT_SHADER);
 
@@ -53,6 +99,10 @@ ShaderProgram::ShaderProgram(const std::string& vertexFilename, const std::strin
 
 	glCall(glAttachShader, this->programID, this->fragmentShaderID);
 	this->bindAttributes();
+	if (!cookedPath.empty())
+	{
+		glCall(glProgramParameteri, this->programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glCall(glLinkProgram, this->programID);
 
 	GLint success;
@@ -64,10 +114,140 @@ ShaderProgram::ShaderProgram(const std::string& vertexFilename, const std::strin
 		glGetProgramInfoLog(programID, 1024, NULL, infoLog); // glCall Currently Incompatible, Needs Fixed
 		// spdlog::error("Error loading shader, {}", infoLog);
 	}
+	else if (!cookedPath.empty())
+	{
+		this->saveProgramBinary(cookedPath);
+	}
+
+	ShaderProgram::cacheStats.compiled++;
+	ShaderProgram::cacheStats.compileMilliseconds += getMilliseconds(start);
 
 	this->getAllUniformLocations();
 }
 
+std::string ShaderProgram::getCookedPath(const std::vector<std::string>& filenames)
+{
+	if (!Config::AssetCache::PROGRAM_BINARIES)
+	{
+		return "";
+	}
+
+	GLint formatCount = 0;
+	glCall(glGetIntegerv, GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if (formatCount <= 0)
+	{
+		return "";
+	}
+
+	// stages are given in a fixed order so the key also tells which stage each file is, binaries only load on the driver that wrote them
+	std::vector<std::string> sources;
+	std::string settings = "stages=";
+	for (const std::string& filename : filenames)
+	{
+		settings += filename + ';';
+		if (filename != "null")
+		{
+			sources.push_back(filename);
+		}
+	}
+	settings += std::format("vendor={};renderer={};version={}", getDriverString(GL_VENDOR), getDriverString(GL_RENDERER), getDriverString(GL_VERSION));
+
+	std::string key = AssetCache::getKey(sources, settings, ShaderProgram::VERSION);
+	return key.empty() ? "" : AssetCache::getEntryPath(key, ".program");
+}
+
+bool ShaderProgram::loadProgramBinary(const std::string& cookedPath)
+{
+	ProgramBinaryHeader header;
+	std::ifstream in(cookedPath, std::ios::binary);
+	if (!in.is_open() || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != ShaderProgram::MAGIC ||
+		header.version != ShaderProgram::VERSION)
+	{
+		AssetCache::recordMiss();
+		return false;
+	}
+
+	// the size comes from the file, a binary longer than what follows the header is compiled from source instead
+	std::error_code error;
+	std::uintmax_t fileSize = std::filesystem::file_size(cookedPath, error);
+	if (error || header.size > fileSize - sizeof(header))
+	{
+		spdlog::warn("Program binary '{}' is truncated, compiling from source", cookedPath);
+		AssetCache::recordMiss();
+		return false;
+	}
+
+	std::vector<char> binary(header.size);
+	if (!in.read(binary.data(), binary.size()))
+	{
+		AssetCache::recordMiss();
+		return false;
+	}
+
+	this->programID = glCall(glCreateProgram);
+	glCall(glProgramBinary, this->programID, (GLenum)header.format, binary.data(), (GLsizei)binary.size());
+
+	// a driver update that kept its version string can still reject the binary
+	GLint success;
+	glCall(glGetProgramiv, this->programID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		spdlog::debug("Program binary '{}' was rejected by the driver, compiling from source", cookedPath);
+		OpenGLState::deleteProgram(this->programID);
+		this->programID = 0;
+		AssetCache::recordMiss();
+		return false;
+	}
+
+	AssetCache::recordHit();
+	return true;
+}
+
+void ShaderProgram::saveProgramBinary(const std::string& cookedPath)
+{
+	GLint length = 0;
+	glCall(glGetProgramiv, this->programID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	glCall(glGetProgramBinary, this->programID, length, &written, &format, binary.data());
+	ProgramBinaryHeader header = { ShaderProgram::MAGIC, ShaderProgram::VERSION, (std::uint32_t)format, (std::uint32_t)written };
+
+	// write to a temporary file first so a partially written file is never picked up as valid
+	if (!AssetCache::prepareEntry(cookedPath))
+	{
+		return;
+	}
+	std::string temporaryPath = AssetCache::getTemporaryPath(cookedPath);
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(binary.data(), written);
+		if (!out)
+		{
+			spdlog::error("Could not write program binary '{}'", cookedPath);
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	if (error)
+	{
+		spdlog::error("Could not write program binary '{}', {}", cookedPath, error.message());
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	AssetCache::recordWrite();
+	spdlog::debug("Wrote program binary '{}' ({:d} bytes)", cookedPath, written);
+}
+
 int ShaderProgram::getUniformLocation(const std::string& uniformName)
 { 
 	return glCall(glGetUniformLocation, this->programID, uniformName.c_str()); 
@@ -75,21 +255,25 @@ int ShaderProgram::getUniformLocation(const std::string& uniformName)
 
 void ShaderProgram::loadFloat(const int location, const float value)
 { 
+	RenderStats::current.uniformLoads++;
 	glCall(glUniform1f, location, value); 
 }
 
 void ShaderProgram::loadInt(const int location, const int value)
 { 
+	RenderStats::current.uniformLoads++;
 	glCall(glUniform1i, location, value); 
 }
 
 void ShaderProgram::loadVec3(const int location, const glm::vec3& vector)
 { 
+	RenderStats::current.uniformLoads++;
 	glCall(glUniform3f, location, vector.x, vector.y, vector.z); 
 }
 
 void ShaderProgram::loadBoolean(const int location, const bool value)
 {
+	RenderStats::current.uniformLoads++;
 	if (value)
 	{
 		glCall(glUniform1f, location, 1);
@@ -102,26 +286,31 @@ void ShaderProgram::loadBoolean(const int location, const bool value)
 
 void ShaderProgram::loadMat4(const int location, const glm::mat4& matrix)
 { 
+	RenderStats::current.uniformLoads++;
 	glCall(glUniformMatrix4fv, location, 1, GL_FALSE, &matrix[0][0]); 
 }
 
 void ShaderProgram::cleanUp() 
 {
-	glCall(glDetachShader, this->programID, this->vertexShaderID);
-	glCall(glDetachShader, this->programID, this->fragmentShaderID);
-	glCall(glDeleteShader, this->vertexShaderID);
-	glCall(glDeleteShader, this->fragmentShaderID);
-	glCall(glDeleteProgram, this->programID);
+	// programs restored from a binary have no shader objects
+	if (this->vertexShaderID != 0)
+	{
+		glCall(glDetachShader, this->programID, this->vertexShaderID);
+		glCall(glDetachShader, this->programID, this->fragmentShaderID);
+		glCall(glDeleteShader, this->vertexShaderID);
+		glCall(glDeleteShader, this->fragmentShaderID);
+	}
+	OpenGLState::deleteProgram(this->programID);
 }
 
 void ShaderProgram::start() 
 { 
-	glCall(glUseProgram, this->programID); 
+	OpenGLState::useProgram(this->programID); 
 }
 
 void ShaderProgram::stop() 
 { 
-	glCall(glUseProgram, 0); 
+	OpenGLState::useProgram(0); 
 }
 
 void ShaderProgram::bindAttribute(const int attribute, const std::string& variableName)
@@ -195,3 +384,15 @@ int ShaderProgram::getProgramID()
 { 
 	return this->programID; 
 }
+
+ProgramCacheStats ShaderProgram::getCacheStats()
+{
+	return ShaderProgram::cacheStats;
+}
+
+void ShaderProgram::logCacheStats()
+{
+	ProgramCacheStats stats = ShaderProgram::getCacheStats();
+	spdlog::info("Shader programs, {:d} compiled in {:.2f} ms, {:d} restored from binaries in {:.2f} ms", stats.compiled, stats.compileMilliseconds,
+		stats.restored, stats.restoreMilliseconds);
+}
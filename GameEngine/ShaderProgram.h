@@ -3,17 +3,43 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/common.hpp>
 
+#include <cstdint>
+#include <cstddef>
 #include <string>
+#include <vector>
 
+// programs created so far and the milliseconds spent creating them, split by whether they were compiled from source or
+// restored from a cached program binary
+struct ProgramCacheStats
+{
+	std::size_t compiled = 0;
+	std::size_t restored = 0;
+	double compileMilliseconds = 0.0;
+	double restoreMilliseconds = 0.0;
+};
+
+// linked programs are kept in the asset cache as driver program binaries, the key covers the source of every stage,
+// the stage each file is used as and the driver's vendor, renderer and version strings, a binary the driver rejects is
+// compiled from source again and replaced
 class ShaderProgram 
 {
+private:
+	static ProgramCacheStats cacheStats;
+
+	// empty when program binaries are disabled, unsupported by the driver or a stage cannot be read
+	static std::string getCookedPath(const std::vector<std::string>& filenames);
+
+	bool loadProgramBinary(const std::string& cookedPath);
+
+	void saveProgramBinary(const std::string& cookedPath);
+
 protected:
-	int programID;
-	int vertexShaderID;
-	int fragmentShaderID;
-	int tessellationControlShaderID;
-	int tessellationEvaluationShaderID;
-	int geometryShaderID;
+	int programID = 0;
+	int vertexShaderID = 0;
+	int fragmentShaderID = 0;
+	int tessellationControlShaderID = 0;
+	int tessellationEvaluationShaderID = 0;
+	int geometryShaderID = 0;
 
 	int getUniformLocation(const std::string& uniformName);
 
@@ -31,6 +57,9 @@ protected:
 
 
 public:
+	static const std::uint32_t MAGIC;
+	static const std::uint32_t VERSION;
+
 	ShaderProgram() = default;
 
 	ShaderProgram(const std::string& vertexFilename, const std::string& fragmentFilename, const std::string& tessellationControlFilename = "null", 
@@ -51,4 +80,8 @@ public:
 	int loadShader(const std::string& filename, const int type);
 
 	int getProgramID();
+
+	static ProgramCacheStats getCacheStats();
+
+	static void logCacheStats();
 };
@@ -1,7 +1,8 @@
 
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
-layout (location = 0) in vec3 position_vs;
+layout (location = 0) in vec4 position_vs;
 layout (location = 1) in vec2 textureCoords_vs;
 layout (location = 2) in vec3 normal_vs;
 layout (location = 3) in vec3 tangent_vs;
@@ -11,16 +12,49 @@ out vec2 textureCoords_fs;
 out vec3 surfaceNormal_fs;
 out vec3 toLightVector_fs;
 
-uniform mat4 transformationMatrix;
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
+layout (std140, binding = 1) uniform FrameBlock {
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjectionMatrix;
+	vec4 cameraPosition;
+	vec4 lightPositions[4];
+	vec4 lightColors[4];
+	float time;
+	int lightCount;
+};
+
+// packed vertices store positions relative to the mesh bounds and unit vectors octahedral encoded, float vertices use an identity offset and scale
+struct ObjectData {
+	mat4 transformationMatrix;
+	mat4 normalMatrix;
+	vec4 positionOffset; // w is 1 for packed vertices
+	vec4 positionScale;
+};
+
+// one entry per instance from the bound range, indirect draws offset their instances with the base instance
+layout (std430, binding = 2) readonly buffer ObjectBlock {
+	ObjectData objects[];
+};
+
 uniform vec3 lightPosition;
 
+vec3 decodeOctahedral(vec2 encoded) {
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
 void main(void) {
-	vec4 worldPosition = transformationMatrix * vec4(position_vs.xyz, 1.0f);
-	gl_Position = projectionMatrix * viewMatrix * worldPosition;
+	ObjectData object = objects[gl_BaseInstanceARB + gl_InstanceID];
+	bool packedVertices = object.positionOffset.w > 0.5;
+	vec3 position = object.positionOffset.xyz + position_vs.xyz * object.positionScale.xyz;
+	vec3 normal = packedVertices ? decodeOctahedral(normal_vs.xy) : normal_vs;
+
+	vec4 worldPosition = object.transformationMatrix * vec4(position, 1.0f);
+	gl_Position = viewProjectionMatrix * worldPosition;
 	textureCoords_fs = textureCoords_vs;
 
-	surfaceNormal_fs = mat3(transpose(inverse(transformationMatrix))) * normal_vs;
+	surfaceNormal_fs = mat3(object.normalMatrix) * normal;
 	toLightVector_fs = lightPosition - worldPosition.xyz;
 }
@@ -16,8 +16,10 @@ uniform vec3 lightColor;
 uniform float gamma;
 
 void main(void) {
-	vec3 normal = texture(texture_normal0, texCoords_fs).rgb;
-	normal = normalize(normal * 2.0 - 1.0);
+	// normal maps may be two channel (bc5), rebuild z from x and y
+	vec3 normal;
+	normal.xy = texture(texture_normal0, texCoords_fs).rg * 2.0 - 1.0;
+	normal.z = sqrt(max(1.0 - dot(normal.xy, normal.xy), 0.0));
 
 	vec3 color = texture(texture_diffuse0, texCoords_fs).rgb;
 	vec3 ambient = 0.1 * color;
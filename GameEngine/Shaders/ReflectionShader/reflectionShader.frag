@@ -30,8 +30,16 @@ uniform float materialNi; // Optical Index
 uniform float materialD; // Alpha
 uniform int materialIllum; // Illumination Info
 
-uniform vec3 lightColors[4];
-uniform vec3 cameraPosition;
+layout (std140, binding = 1) uniform FrameBlock {
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjectionMatrix;
+	vec4 cameraPosition;
+	vec4 lightPositions[4];
+	vec4 lightColors[4];
+	float time;
+	int lightCount;
+};
 
 void main(void) {
 	float transparency = materialD;
@@ -56,13 +64,15 @@ void main(void) {
 
 	// normal mapping
 	if (normalBound) {
-		vec3 normal = texture(texture_normal0, textureCoords_fs).xyz;
-		normal = normalize(normal * 2.0 - 1.0);
+		// normal maps may be two channel (bc5), rebuild z from x and y
+		vec3 normal;
+		normal.xy = texture(texture_normal0, textureCoords_fs).rg * 2.0 - 1.0;
+		normal.z = sqrt(max(1.0 - dot(normal.xy, normal.xy), 0.0));
 		vec3 ambient = ambientFactor * color.rgb;
 
 		vec3 lightDir = normalize(tangentLightPos_fs[0] - tangentFragPos_fs);
 		float diff = max(dot(lightDir, normal), 0.0f);
-		vec3 diffuse = diff * color.rgb * lightColors[0];
+		vec3 diffuse = diff * color.rgb * lightColors[0].rgb;
 
 		vec3 viewDir = normalize(tangentViewPos_fs - tangentFragPos_fs);
 		vec3 reflectDir = reflect(-lightDir, normal);
@@ -81,7 +91,7 @@ void main(void) {
 		vec4 cubeMapColor = vec4(1.0f);
 		if (cubeMapBound) {
 			vec3 reflectNormalVector = normalize(reflectNormal_fs + normalSmoothing * normal);
-			vec3 I = normalize(fragmentPosition_fs - cameraPosition);
+			vec3 I = normalize(fragmentPosition_fs - cameraPosition.xyz);
 
 			vec3 R = reflect(I, normalize(reflectNormalVector));
 			vec4 cubeMapReflectColor = texture(texture_cubeMap0, normalize(R));
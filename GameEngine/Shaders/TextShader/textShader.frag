@@ -1,14 +1,21 @@
 #version 400 core
 
 in vec2 textureCoords_fs;
+in vec4 color_fs;
+flat in uint page_fs;
 
 out vec4 FragColor;
 
-uniform sampler2D text;
-uniform vec3 textColor;
+// signed distance fields, the outline is at 128 and the field saturates DISTANCE_SPREAD texels to either side
+uniform sampler2DArray text;
+
+const float EDGE = 128.0 / 255.0;
 
 void main()
 {
-	vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, textureCoords_fs).r);
-	FragColor = vec4(textColor.rgb, 1.0) * sampled;
+	// the edge is blended over about one pixel on screen whatever the scale the glyph is drawn at
+	float distance = texture(text, vec3(textureCoords_fs, page_fs)).r;
+	float width = max(fwidth(distance) * 0.5, 1e-4);
+	float alpha = smoothstep(EDGE - width, EDGE + width, distance);
+	FragColor = vec4(color_fs.rgb, color_fs.a * alpha);
 }
\ No newline at end of file
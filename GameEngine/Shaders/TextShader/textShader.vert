@@ -1,15 +1,25 @@
 #version 400 core
 
-layout (location = 0) in vec4 vertex_vs;
+// one instance per glyph, position and size in xy and zw
+layout (location = 0) in vec4 glyphRect_vs;
+layout (location = 1) in vec4 atlasRect_vs;
+layout (location = 2) in vec4 color_vs;
+layout (location = 3) in uint page_vs;
 
 out vec2 textureCoords_fs;
+out vec4 color_fs;
+flat out uint page_fs;
 
 uniform mat4 transformationMatrix;
 uniform mat4 projectionMatrix;
 uniform mat4 viewMatrix;
 
 void main(void) {
-	vec4 worldPosition = transformationMatrix * vec4(vertex_vs.xy, 0.0, 1.0);
+	// triangle strip over the corners (0, 0), (1, 0), (0, 1), (1, 1)
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec4 worldPosition = transformationMatrix * vec4(glyphRect_vs.xy + corner * glyphRect_vs.zw, 0.0, 1.0);
 	gl_Position = projectionMatrix * viewMatrix * worldPosition;
-	textureCoords_fs = vertex_vs.zw;
+	textureCoords_fs = mix(atlasRect_vs.xy, atlasRect_vs.zw, corner);
+	color_fs = color_vs;
+	page_fs = page_vs;
 }
\ No newline at end of file
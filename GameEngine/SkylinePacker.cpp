@@ -0,0 +1,116 @@
+#include "SkylinePacker.h"
+
+#include <algorithm>
+#include <climits>
+
+SkylinePacker::SkylinePacker(const glm::ivec2& size) : size(size)
+{
+	this->clear();
+}
+
+void SkylinePacker::clear()
+{
+	this->skyline.clear();
+	this->skyline.push_back({ 0, 0, this->size.x });
+	this->usedArea = 0;
+}
+
+int SkylinePacker::fit(const std::size_t index, const glm::ivec2& rectSize) const
+{
+	int x = this->skyline[index].x;
+	if (x + rectSize.x > this->size.x)
+	{
+		return -1;
+	}
+
+	// the rectangle rests on the highest segment below its width
+	int y = 0;
+	int remaining = rectSize.x;
+	for (std::size_t i = index; remaining > 0; i++)
+	{
+		y = std::max(y, this->skyline[i].y);
+		if (y + rectSize.y > this->size.y)
+		{
+			return -1;
+		}
+		remaining -= this->skyline[i].width;
+	}
+	return y;
+}
+
+bool SkylinePacker::pack(const glm::ivec2& rectSize, glm::ivec2& position)
+{
+	if (rectSize.x <= 0 || rectSize.y <= 0)
+	{
+		position = glm::ivec2(0);
+		return true;
+	}
+
+	int bestIndex = -1;
+	int bestTop = INT_MAX;
+	int bestWidth = INT_MAX;
+	for (std::size_t i = 0; i < this->skyline.size(); i++)
+	{
+		int y = this->fit(i, rectSize);
+		if (y < 0)
+		{
+			continue;
+		}
+
+		int top = y + rectSize.y;
+		if (top < bestTop || (top == bestTop && this->skyline[i].width < bestWidth))
+		{
+			bestIndex = (int)i;
+			bestTop = top;
+			bestWidth = this->skyline[i].width;
+			position = glm::ivec2(this->skyline[i].x, y);
+		}
+	}
+	if (bestIndex < 0)
+	{
+		return false;
+	}
+
+	// the new segment covers the rectangle's width, segments below it are shortened or removed
+	this->skyline.insert(this->skyline.begin() + bestIndex, { position.x, bestTop, rectSize.x });
+	int right = position.x + rectSize.x;
+	for (std::size_t i = bestIndex + 1; i < this->skyline.size(); )
+	{
+		Segment& segment = this->skyline[i];
+		if (segment.x >= right)
+		{
+			break;
+		}
+
+		int shrink = right - segment.x;
+		if (shrink < segment.width)
+		{
+			segment.x += shrink;
+			segment.width -= shrink;
+			break;
+		}
+		this->skyline.erase(this->skyline.begin() + i);
+	}
+
+	// neighbouring segments at the same height are merged
+	for (std::size_t i = 0; i + 1 < this->skyline.size(); )
+	{
+		if (this->skyline[i].y == this->skyline[i + 1].y)
+		{
+			this->skyline[i].width += this->skyline[i + 1].width;
+			this->skyline.erase(this->skyline.begin() + i + 1);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	this->usedArea += (std::size_t)rectSize.x * rectSize.y;
+	return true;
+}
+
+float SkylinePacker::getOccupancy() const
+{
+	return (float)this->usedArea / std::max((float)this->size.x * this->size.y, 1.0f);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// bottom left skyline packer over a fixed size page, the top edge of everything packed so far is kept as a list of
+// horizontal segments and each rectangle goes where it leaves the lowest top, ties broken by the narrowest segment
+//
+// rectangles cannot be freed one by one, a page is reused by clearing it as a whole
+class SkylinePacker
+{
+private:
+	// a segment starts at x and spans width texels at height y
+	struct Segment
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	glm::ivec2 size;
+	std::vector<Segment> skyline;
+	std::size_t usedArea = 0;
+
+	// height the rectangle would rest at when its left edge is placed on the segment, -1 when it does not fit
+	int fit(const std::size_t index, const glm::ivec2& rectSize) const;
+
+public:
+	SkylinePacker(const glm::ivec2& size = glm::ivec2(0));
+
+	void clear();
+
+	// finds a place for the rectangle and returns its bottom left corner in position, false when the page is full
+	bool pack(const glm::ivec2& rectSize, glm::ivec2& position);
+
+	// fraction of the page covered by packed rectangles
+	float getOccupancy() const;
+};
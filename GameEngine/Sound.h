@@ -2,6 +2,8 @@
 
 #include <openAL\al.h>
 
+#include <cstdint>
+#include <vector>
 #include <string>
 
 struct Sound
@@ -11,5 +13,5 @@ struct Sound
 	std::uint8_t BitsPerSample;
 	ALsizei DataSize;
 	ALenum Format;
-	char* RawSoundData;
+	std::vector<char> Data;
 };
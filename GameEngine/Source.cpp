@@ -3,80 +3,96 @@
 #include <spdlog/spdlog.h>
 
 #include "OpenALFunctions.h"
+#include "AudioStreamer.h"
 #include "Loader.h"
 
 Source::Source(const std::string& filename, const glm::vec3& position, const glm::vec3& velocity,
 	const ALfloat pitch, const ALfloat gain, const ALfloat referenceDistance, const ALfloat maxDistance,
-	const ALfloat rolloffFactor, const ALboolean looping) :
+	const ALfloat rolloffFactor, const ALboolean looping, const bool streaming) :
 	position(position), velocity(velocity), pitch(pitch), gain(gain), referenceDistance(referenceDistance),
 	maxDistance(maxDistance), rolloffFactor(rolloffFactor), looping(looping)
 {
-	this->sound = Loader::loadWav(filename);
-	if (this->sound.RawSoundData == nullptr || this->sound.DataSize == 0)
-	{
-		spdlog::error("Loaded audio file '{}'", filename);
-	}
-	alCall(alGenBuffers, 1, &this->buffer);
-
-	ALenum format;
-	if (sound.Channels == 1 && sound.BitsPerSample == 8)
-	{
-		format = AL_FORMAT_MONO8;
-	}
-	else if (sound.Channels == 1 && sound.BitsPerSample == 16)
-	{
-		format = AL_FORMAT_MONO16;
-	}
-	else if (sound.Channels == 2 && sound.BitsPerSample == 8)
-	{
-		format = AL_FORMAT_STEREO8;
-	}
-	else if (sound.Channels == 2 && sound.BitsPerSample == 16)
-	{
-		format = AL_FORMAT_STEREO16;
-	}
-	else
-	{
-		spdlog::error("Unrecognized wave format '{}'", filename);
-		format = NULL;
-	}
-
-	std::vector<char> soundData(this->sound.RawSoundData, this->sound.RawSoundData + this->sound.DataSize);
-	alCall(alBufferData, buffer, format, soundData.data(), soundData.size(), sound.SampleRate);
-	soundData.clear();
-
 	alCall(alGenSources, 1, &this->id);
 	alCall(alSourcef, this->id, AL_PITCH, this->pitch);
 	alCall(alSourcef, this->id, AL_GAIN, this->gain);
 	alCall(alSource3f, this->id, AL_POSITION, this->position.x, this->position.y, this->position.z);
 	alCall(alSource3f, this->id, AL_VELOCITY, this->velocity.x, this->velocity.y, this->velocity.z);
-	alCall(alSourcei, this->id, AL_LOOPING, this->looping);
 	alCall(alSourcef, this->id, AL_ROLLOFF_FACTOR, this->rolloffFactor);
 	alCall(alSourcef, this->id, AL_REFERENCE_DISTANCE, this->referenceDistance);
 	alCall(alSourcef, this->id, AL_MAX_DISTANCE, this->maxDistance);
-	alCall(alSourcei, this->id, AL_BUFFER, buffer);
-
 	this->state = AL_FALSE;
+
+	if (streaming)
+	{
+		// looping is handled by the streamer rewinding the file, the source only ever sees a queue
+		this->stream = std::make_unique<AudioStream>();
+		if (!AudioStreamer::open(*this->stream, filename, this->id, this->looping == AL_TRUE))
+		{
+			this->stream.reset();
+		}
+		return;
+	}
+
+	this->sound = Loader::loadWav(filename);
+	if (this->sound.Data.empty() || this->sound.Format == AL_NONE)
+	{
+		spdlog::error("Failed to load audio file '{}'", filename);
+		return;
+	}
+
+	alCall(alGenBuffers, 1, &this->buffer);
+	alCall(alBufferData, this->buffer, this->sound.Format, this->sound.Data.data(), (ALsizei)this->sound.Data.size(), this->sound.SampleRate);
+	alCall(alSourcei, this->id, AL_LOOPING, this->looping);
+	alCall(alSourcei, this->id, AL_BUFFER, this->buffer);
+
+	// openAL keeps its own copy of the samples
+	this->sound.Data.clear();
+	this->sound.Data.shrink_to_fit();
 }
 
 Source::~Source() 
 {
-	alCall(alDeleteSources, 1, &this->id);
-	alCall(alDeleteBuffers, 1, &this->buffer);
+	if (this->stream)
+	{
+		AudioStreamer::close(*this->stream);
+	}
+	if (this->id != 0)
+	{
+		alCall(alDeleteSources, 1, &this->id);
+	}
+	if (this->buffer != 0)
+	{
+		alCall(alDeleteBuffers, 1, &this->buffer);
+	}
 }
 
 void Source::play()
 {
+	if (this->stream)
+	{
+		AudioStreamer::play(*this->stream);
+		return;
+	}
 	alCall(alSourcePlay, this->id);
 }
 
 void Source::pause()
 {
+	if (this->stream)
+	{
+		AudioStreamer::pause(*this->stream);
+		return;
+	}
 	alCall(alSourcePause, this->id);
 }
 
 void Source::stop()
 {
+	if (this->stream)
+	{
+		AudioStreamer::stop(*this->stream);
+		return;
+	}
 	alCall(alSourceStop, this->id);
 }
 
@@ -2,10 +2,13 @@
 
 #include "Sound.h"
 
+struct AudioStream;
+
 #include <openAL/al.h>
 
 #include <vector>
 #include <string>
+#include <memory>
 
 #include <glm/common.hpp>
 
@@ -22,16 +25,23 @@ private:
 	ALboolean looping;
 
 	Sound sound;
-	ALuint buffer;
-	ALuint id;
+	ALuint buffer = 0;
+	ALuint id = 0;
 	ALint state;
 
+	// set for sources fed from disk in chunks instead of one buffer holding the whole file
+	std::unique_ptr<AudioStream> stream;
+
 public:
 	Source() = default;
 
 	Source(const std::string& filename, const glm::vec3& position = glm::vec3(0.0f), const glm::vec3& velocity = glm::vec3(0.0f),
 		const ALfloat pitch = 1.0f, const ALfloat gain = 1.0f, const ALfloat referenceDistance = 0.0f, const ALfloat maxDistance = 10.0f,
-		const ALfloat rolloffFactor = 1.0f, const ALboolean looping = AL_FALSE);
+		const ALfloat rolloffFactor = 1.0f, const ALboolean looping = AL_FALSE, const bool streaming = false);
+
+	Source(const Source&) = delete;
+
+	Source& operator=(const Source&) = delete;
 
 	~Source();
 
@@ -1,9 +1,6 @@
 
 #include "TessellationShader.h"
 
-#include "Camera.h"
-#include "Maths.h"
-
 TessellationShader::TessellationShader(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
 	const std::string& tessellationControlFilename, const std::string& tessellationEvaluationFilename, const std::string& geometryFilename)
 	: ShaderProgram::ShaderProgram(vertexShaderFilename, fragmentShaderFilename, tessellationControlFilename,
@@ -24,8 +21,6 @@ void TessellationShader::bindAttributes()
 void TessellationShader::getAllUniformLocations() 
 {
 	this->location_transformationMatrix = this->getUniformLocation("transformationMatrix");
-	this->location_projectionMatrix = this->getUniformLocation("projectionMatrix");
-	this->location_viewMatrix = this->getUniformLocation("viewMatrix");
 	this->location_eyePos = this->getUniformLocation("eyePos");
 	this->location_lightPosition = this->getUniformLocation("lightPosition");
 	this->location_lightColor = this->getUniformLocation("lightColor");
@@ -38,18 +33,6 @@ void TessellationShader::loadTransformationMatrix(const glm::mat4& matrix)
 	this->loadMat4(this->location_transformationMatrix, matrix); 
 }
 
-void TessellationShader::loadProjectionMatrix(const glm::mat4& matrix)
-{ 
-	this->loadMat4(this->location_projectionMatrix, matrix); 
-}
-
-void TessellationShader::loadViewMatrix() 
-{
-	glm::mat4 view;
-	Maths::createViewMatrix(view);
-	this->loadMat4(this->location_viewMatrix, view);
-}
-
 void TessellationShader::loadCameraPosition(const glm::vec3& pos)
 { 
 	this->loadVec3(this->location_eyePos, pos); 
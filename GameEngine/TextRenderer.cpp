@@ -1,147 +1,488 @@
 #include "TextRenderer.h"
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-#include <freetype/ftglyph.h>
+#include FT_MODULE_H
 #include <spdlog/spdlog.h>
 
+#include <filesystem>
 #include <algorithm>
+#include <fstream>
+#include <cstddef>
+#include <cstring>
 #include <format>
+#include <array>
 
 #include "OpenGLFunctions.h"
+#include "OpenGLState.h"
+#include "RenderStats.h"
+#include "AssetCache.h"
 #include "TextShader.h"
+#include "RingBuffer.h"
 #include "Camera.h"
 #include "Maths.h"
 
-Font::Font(const std::string& fontName, unsigned int fontQuality = 24)
+namespace
 {
+	struct BakedAtlasHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t glyphCount;
+		std::uint32_t pageCount;
+	};
+
+	// followed by the pixels of every page
+	struct BakedGlyph
+	{
+		std::uint32_t codePoint;
+		Character character;
+	};
+
+	static_assert(sizeof(BakedGlyph) == 48, "Baked glyphs are written as they are laid out in memory");
+
+	// decodes the code point starting at index and moves index past it, malformed sequences decode to U+FFFD
+	char32_t decodeUtf8(const std::string& text, std::size_t& index)
+	{
+		unsigned char lead = (unsigned char)text[index++];
+		if (lead < 0x80)
+		{
+			return lead;
+		}
+
+		int continuations = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+		if (continuations == 0 || lead >= 0xF8)
+		{
+			return 0xFFFD;
+		}
+
+		char32_t codePoint = lead & (0x3F >> continuations);
+		for (int i = 0; i < continuations; i++)
+		{
+			if (index >= text.size() || ((unsigned char)text[index] & 0xC0) != 0x80)
+			{
+				return 0xFFFD;
+			}
+			codePoint = (codePoint << 6) | ((unsigned char)text[index++] & 0x3F);
+		}
+		return codePoint <= 0x10FFFF ? codePoint : 0xFFFD;
+	}
+}
+
+const std::uint32_t Font::MAGIC = 0x544E4647; // "GFNT"
+const std::uint32_t Font::VERSION = 1;
+
+Font::Font(const std::string& fontName, const unsigned int fontQuality) :
+	fontPath(std::format("C:\\Windows\\fonts\\{}.ttf", fontName)), fontQuality(fontQuality)
+{
+	// create the atlas up front, pages only get their cpu copy and packer once a glyph lands in them
+	glCall(glGenTextures, 1, &this->textureID);
+	OpenGLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->textureID);
+	glCall(glTexStorage3D, GL_TEXTURE_2D_ARRAY, 1, GL_R8, Font::PAGE_SIZE, Font::PAGE_SIZE, Font::PAGE_COUNT);
+	glCall(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glCall(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glCall(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glCall(glTexParameteri, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	OpenGLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	std::string cookedPath = this->getCookedPath();
+	if (!cookedPath.empty() && this->loadBakedAtlas(cookedPath))
+	{
+		spdlog::debug("Loaded baked atlas of font '{}' from '{}'", fontName, cookedPath);
+		return;
+	}
+
+	// bake the common glyphs, they are packed in code point order so loading can replay the packing
+	for (char32_t codePoint = Font::BAKED_FIRST; codePoint <= Font::BAKED_LAST; codePoint++)
+	{
+		this->getCharacter(codePoint);
+	}
+	if (this->face && !cookedPath.empty())
+	{
+		this->saveBakedAtlas(cookedPath);
+	}
+}
+
+Font::~Font()
+{
+	if (this->face)
+	{
+		FT_Done_Face(this->face);
+	}
+	if (this->library)
+	{
+		FT_Done_FreeType(this->library);
+	}
+	OpenGLState::deleteTextures(1, &this->textureID);
+}
+
+bool Font::openFace()
+{
+	if (this->face || this->faceFailed)
+	{
+		return this->face != nullptr;
+	}
+	this->faceFailed = true;
+
 	// load library
-	FT_Library library;
-	if (FT_Init_FreeType(&library))
+	if (FT_Init_FreeType(&this->library))
 	{
 		spdlog::error("Could not init FreeType library");
-		return;
+		this->library = nullptr;
+		return false;
 	}
 	spdlog::debug("Loaded FreeType library");
 
 	// load font
-	FT_Face face;
-	FT_Error error = FT_New_Face(library, std::format("C:\\Windows\\fonts\\{}.ttf", fontName).c_str(), 0, &face);
+	FT_Error error = FT_New_Face(this->library, this->fontPath.c_str(), 0, &this->face);
 	if (error == FT_Err_Unknown_File_Format)
 	{
-		spdlog::error("Could not load font '{}' because format is not supported", fontName);
-		return;
+		spdlog::error("Could not load font '{}' because format is not supported", this->fontPath);
+		this->face = nullptr;
+		return false;
 	}
 	else if (error)
 	{
-		spdlog::error("Could not load font '{}' because it (does not exist / cannot be opened / is broken)", fontName);
-		return;
+		spdlog::error("Could not load font '{}' because it (does not exist / cannot be opened / is broken)", this->fontPath);
+		this->face = nullptr;
+		return false;
 	}
-	spdlog::debug("Loaded font '{}'", fontName);
+	spdlog::debug("Loaded font '{}'", this->fontPath);
 
 	// configure font
-	if (FT_Set_Char_Size(face, 0, fontQuality << 6, 0, 0))
+	FT_Int spread = Font::DISTANCE_SPREAD;
+	if (FT_Set_Char_Size(this->face, 0, this->fontQuality << 6, 0, 0) || FT_Property_Set(this->library, "bsdf", "spread", &spread))
 	{
-		spdlog::error("Could not configure font '{}'", fontName);
-		return;
+		spdlog::error("Could not configure font '{}'", this->fontPath);
+		FT_Done_Face(this->face);
+		this->face = nullptr;
+		return false;
+	}
+	spdlog::debug("Configured font '{}'", this->fontPath);
+
+	this->faceFailed = false;
+	return true;
+}
+
+std::string Font::getCookedPath() const
+{
+	std::string settings = std::format("quality={:d};spread={:d};page={:d};glyphs={:d}-{:d}", this->fontQuality, Font::DISTANCE_SPREAD, Font::PAGE_SIZE,
+		(unsigned int)Font::BAKED_FIRST, (unsigned int)Font::BAKED_LAST);
+	std::string key = AssetCache::getKey({ this->fontPath }, settings, Font::VERSION);
+	return key.empty() ? "" : AssetCache::getEntryPath(key, ".glyphs");
+}
+
+bool Font::loadBakedAtlas(const std::string& cookedPath)
+{
+	BakedAtlasHeader header;
+	std::ifstream in(cookedPath, std::ios::binary);
+	if (!in.is_open() || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != Font::MAGIC || header.version != Font::VERSION ||
+		header.pageCount > Font::PAGE_COUNT)
+	{
+		AssetCache::recordMiss();
+		return false;
+	}
+
+	// the counts come from the file, so they have to fit the baked range and account for every byte of it before anything is allocated
+	std::error_code error;
+	std::uintmax_t fileSize = std::filesystem::file_size(cookedPath, error);
+	std::uintmax_t expectedSize = sizeof(header) + (std::uintmax_t)header.glyphCount * sizeof(BakedGlyph) +
+		(std::uintmax_t)header.pageCount * Font::PAGE_SIZE * Font::PAGE_SIZE;
+	if (error || header.glyphCount > Font::BAKED_LAST - Font::BAKED_FIRST + 1 || fileSize != expectedSize)
+	{
+		spdlog::warn("Baked font atlas '{}' has an invalid size, baking it again", cookedPath);
+		AssetCache::recordMiss();
+		return false;
+	}
+
+	std::vector<BakedGlyph> bakedGlyphs(header.glyphCount);
+	bool valid = (bool)in.read(reinterpret_cast<char*>(bakedGlyphs.data()), bakedGlyphs.size() * sizeof(BakedGlyph));
+
+	// packing the same sizes in the same order gives the same places, the pages are then taken as they were written
+	for (std::size_t i = 0; valid && i < bakedGlyphs.size(); i++)
+	{
+		const Character& character = bakedGlyphs[i].character;
+		unsigned int page;
+		glm::ivec2 position;
+		valid = character.textureSize.x == 0 ||
+			(this->packGlyph(character.textureSize, page, position) && page == character.page && position == character.atlasPosition);
+	}
+	valid = valid && this->pages.size() == header.pageCount;
+	for (std::size_t i = 0; valid && i < this->pages.size(); i++)
+	{
+		valid = (bool)in.read(reinterpret_cast<char*>(this->pages[i].pixels.data()), this->pages[i].pixels.size());
+		this->pages[i].dirty = glm::ivec4(0, 0, Font::PAGE_SIZE, Font::PAGE_SIZE);
+	}
+
+	if (!valid)
+	{
+		spdlog::warn("Baked font atlas '{}' does not match, baking it again", cookedPath);
+		this->pages.clear();
+		AssetCache::recordMiss();
+		return false;
 	}
-	spdlog::debug("Configured font '{}'", fontName);
 
-	// render bitmaps
-	std::vector<FT_BitmapGlyph> bitmapGlyphs;
-	this->textureWidth = 0;
-	this->textureHeight = 0;
-	for (unsigned char i = 0; i < 128; i++)
+	for (const BakedGlyph& bakedGlyph : bakedGlyphs)
 	{
-		// load character
-		if (FT_Load_Char(face, i, FT_LOAD_RENDER))
+		this->setSlot(bakedGlyph.codePoint, (std::int32_t)this->characters.size());
+		this->characters.push_back(bakedGlyph.character);
+		if (bakedGlyph.character.textureSize.x > 0)
 		{
-			spdlog::error("Failed to load character '{}' for font '{}'", (char)i, fontName);
-			return;
+			this->pages[bakedGlyph.character.page].codePoints.push_back(bakedGlyph.codePoint);
 		}
+	}
+	AssetCache::recordHit();
+	return true;
+}
 
-		// load glyph
-		FT_Glyph glyph;
-		if (FT_Get_Glyph(face->glyph, &glyph))
+void Font::saveBakedAtlas(const std::string& cookedPath)
+{
+	std::vector<BakedGlyph> bakedGlyphs;
+	for (char32_t codePoint = Font::BAKED_FIRST; codePoint <= Font::BAKED_LAST; codePoint++)
+	{
+		std::int32_t slot = this->findSlot(codePoint);
+		if (slot >= 0)
 		{
-			spdlog::error("Failed to load glyph '{}' for font '{}'", (char)i, fontName);
+			bakedGlyphs.push_back({ (std::uint32_t)codePoint, this->characters[slot] });
+		}
+	}
+	BakedAtlasHeader header = { Font::MAGIC, Font::VERSION, (std::uint32_t)bakedGlyphs.size(), (std::uint32_t)this->pages.size() };
+
+	// write to a temporary file first so a partially written file is never picked up as valid
+	if (!AssetCache::prepareEntry(cookedPath))
+	{
+		spdlog::error("Could not write baked atlas for font '{}'", this->fontPath);
+		return;
+	}
+	std::string temporaryPath = AssetCache::getTemporaryPath(cookedPath);
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(bakedGlyphs.data()), bakedGlyphs.size() * sizeof(BakedGlyph));
+		for (const Page& page : this->pages)
+		{
+			out.write(reinterpret_cast<const char*>(page.pixels.data()), page.pixels.size());
+		}
+
+		if (!out)
+		{
+			spdlog::error("Could not write baked font atlas '{}'", cookedPath);
 			return;
 		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	if (error)
+	{
+		spdlog::error("Could not write baked font atlas '{}', {}", cookedPath, error.message());
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	AssetCache::recordWrite();
+	spdlog::debug("Baked atlas of font '{}' to '{}' ({:d} glyphs, {:d} pages)", this->fontPath, cookedPath, bakedGlyphs.size(), this->pages.size());
+}
 
-		// render bitmap if necessary
-		if (glyph->format != FT_GLYPH_FORMAT_BITMAP)
+std::int32_t Font::findSlot(const char32_t codePoint) const
+{
+	if (codePoint < Font::TABLE_SIZE)
+	{
+		return codePoint < this->table.size() ? this->table[codePoint] : -1;
+	}
+
+	auto it = this->map.find(codePoint);
+	return it != this->map.end() ? it->second : -1;
+}
+
+void Font::setSlot(const char32_t codePoint, const std::int32_t slot)
+{
+	if (codePoint >= Font::TABLE_SIZE)
+	{
+		if (slot < 0)
 		{
-			if (FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, 0, 1))
-			{
-				spdlog::error("Failed to render bitmap '{}' for font '{}'", (char)i, fontName);
-				return;
-			}
+			this->map.erase(codePoint);
+		}
+		else
+		{
+			this->map[codePoint] = slot;
 		}
+		return;
+	}
 
-		// cache bitmap
-		FT_BitmapGlyph bitmapGlyph = (FT_BitmapGlyph)glyph;
-		bitmapGlyphs.push_back((FT_BitmapGlyph)bitmapGlyph);
+	if (codePoint >= this->table.size())
+	{
+		// grown in steps of 256 code points so ascii text only needs a small table
+		this->table.resize(std::min<std::size_t>((codePoint | 0xFF) + 1, Font::TABLE_SIZE), -1);
+	}
+	this->table[codePoint] = slot;
+}
 
-		// cache character
-		Character character = {
-			this->textureWidth,
-			glm::ivec2(bitmapGlyph->bitmap.width, bitmapGlyph->bitmap.rows),
-			glm::vec2((float)bitmapGlyph->bitmap.width / fontQuality, (float)bitmapGlyph->bitmap.rows / fontQuality),
-			glm::vec2((float)bitmapGlyph->left / fontQuality, (float)bitmapGlyph->top / fontQuality),
-			glm::vec2((float)(face->glyph->advance.x >> 6) / fontQuality, (float)(face->glyph->advance.y >> 6) / fontQuality)
-		};
-		this->characters.insert(std::pair<char, Character>(i, character));
+bool Font::packGlyph(const glm::ivec2& size, unsigned int& page, glm::ivec2& position)
+{
+	// one texel of gutter on the right and bottom keeps linear filtering from reading the neighbouring glyph
+	glm::ivec2 paddedSize = size + glm::ivec2(1);
+	if (paddedSize.x > Font::PAGE_SIZE || paddedSize.y > Font::PAGE_SIZE)
+	{
+		return false;
+	}
 
-		// update texture size
-		this->textureWidth += bitmapGlyph->bitmap.width + 1;
-		this->textureHeight = std::max(this->textureHeight, bitmapGlyph->bitmap.rows);
+	for (page = 0; page < this->pages.size(); page++)
+	{
+		if (this->pages[page].packer.pack(paddedSize, position))
+		{
+			return true;
+		}
 	}
 
-	// create empty texture atlas
-	glCall(glGenTextures, 1, &this->textureID);
-	glCall(glBindTexture, GL_TEXTURE_2D, this->textureID);
-	glCall(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, this->textureWidth, this->textureHeight, 0, GL_RED, GL_UNSIGNED_BYTE, 0);
-	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (this->pages.size() < Font::PAGE_COUNT)
+	{
+		Page newPage;
+		newPage.packer = SkylinePacker(glm::ivec2(Font::PAGE_SIZE));
+		newPage.pixels.resize((std::size_t)Font::PAGE_SIZE * Font::PAGE_SIZE, 0);
+		this->pages.push_back(std::move(newPage));
+		page = (unsigned int)this->pages.size() - 1;
+		return this->pages[page].packer.pack(paddedSize, position);
+	}
 
-	// fill texture atlas
-	for (unsigned char i = 0; i < bitmapGlyphs.size(); i++)
+	// every page is full, clear the least recently used one unless the current frame still samples it
+	page = 0;
+	for (unsigned int i = 1; i < this->pages.size(); i++)
+	{
+		if (this->pages[i].lastUsed < this->pages[page].lastUsed)
+		{
+			page = i;
+		}
+	}
+	if (this->pages[page].lastUsed >= this->frame)
 	{
-		glCall(glTexSubImage2D, GL_TEXTURE_2D, 0, this->characters[i].textureAtlasOffset, 0, bitmapGlyphs[i]->bitmap.width, bitmapGlyphs[i]->bitmap.rows, GL_RED, GL_UNSIGNED_BYTE, bitmapGlyphs[i]->bitmap.buffer);
+		return false;
 	}
+	this->evictPage(page);
+	return this->pages[page].packer.pack(paddedSize, position);
 }
 
-std::array<std::array<float, 4>, 6> Font::generateVertices(const char c, glm::vec2& cursorPos, const glm::vec2& scale)
+void Font::evictPage(const unsigned int page)
 {
-	Character character = this->characters.at(c);
+	Page& evicted = this->pages[page];
+	for (char32_t codePoint : evicted.codePoints)
+	{
+		std::int32_t slot = this->findSlot(codePoint);
+		this->setSlot(codePoint, -1);
+		this->freeSlots.push_back(slot);
+	}
+	evicted.codePoints.clear();
+	evicted.packer.clear();
 
-	// calculate vertex coords
-	glm::vec2 pos = glm::vec2(
-		cursorPos.x + character.bearing.x * scale.x,
-		cursorPos.y - (character.size.y - character.bearing.y) * scale.y);
-	glm::vec2 size = character.size * scale;
+	// the gutters rely on the page being cleared
+	std::fill(evicted.pixels.begin(), evicted.pixels.end(), (unsigned char)0);
+	evicted.dirty = glm::ivec4(0, 0, Font::PAGE_SIZE, Font::PAGE_SIZE);
+
+	this->generation++;
+	RenderStats::current.atlasEvictions++;
+}
+
+const Character& Font::loadCharacter(const char32_t codePoint)
+{
+	this->unpacked = Character();
+	if (!this->openFace())
+	{
+		return this->unpacked;
+	}
 
-	// calculate texture coords
-	float s0 = character.textureAtlasOffset / this->textureWidth;
-	float s1 = (character.textureAtlasOffset + character.textureSize.x) / this->textureWidth;
-	float t1 = (float)character.textureSize.y / this->textureHeight;
+	// unhinted outlines since the glyphs are scaled freely, the coverage bitmap is turned into a distance field by the
+	// bsdf renderer which copes with the overlapping contours the outline based sdf renderer breaks on
+	FT_GlyphSlot glyph = this->face->glyph;
+	if (FT_Load_Char(this->face, codePoint, FT_LOAD_NO_HINTING) || FT_Render_Glyph(glyph, FT_RENDER_MODE_NORMAL) ||
+		(glyph->bitmap.width > 0 && glyph->bitmap.rows > 0 && FT_Render_Glyph(glyph, FT_RENDER_MODE_SDF)))
+	{
+		spdlog::error("Failed to load character U+{:04X}", (unsigned int)codePoint);
+		return this->unpacked;
+	}
 
-	// create vertices
-	std::array<std::array<float, 4>, 6> vertices = { {
-		{ pos.x,          pos.y + size.y, s0, 0.0f },
-		{ pos.x,          pos.y,          s0, t1 },
-		{ pos.x + size.x, pos.y,          s1, t1 },
+	Character character;
+	character.textureSize = glm::ivec2(glyph->bitmap.width, glyph->bitmap.rows);
+	character.size = glm::vec2(character.textureSize) / (float)this->fontQuality;
+	character.bearing = glm::vec2((float)glyph->bitmap_left / this->fontQuality, (float)glyph->bitmap_top / this->fontQuality);
+	character.advance = glm::vec2(glyph->advance.x / 64.0f / this->fontQuality, glyph->advance.y / 64.0f / this->fontQuality);
+	RenderStats::current.glyphsRasterized++;
 
-		{ pos.x,          pos.y + size.y, s0, 0.0f },
-		{ pos.x + size.x, pos.y,          s1, t1 },
-		{ pos.x + size.x, pos.y + size.y, s1, 0.0f }
-	} };
+	if (character.textureSize.x > 0 && character.textureSize.y > 0)
+	{
+		if (!this->packGlyph(character.textureSize, character.page, character.atlasPosition))
+		{
+			// not cached, the glyph is rasterized again on its next use in a later frame
+			spdlog::warn("No room in the font atlas for character U+{:04X}", (unsigned int)codePoint);
+			this->unpacked.advance = character.advance;
+			return this->unpacked;
+		}
+
+		// the bitmap's first row is the top of the glyph
+		Page& page = this->pages[character.page];
+		for (int y = 0; y < character.textureSize.y; y++)
+		{
+			std::memcpy(&page.pixels[(std::size_t)(character.atlasPosition.y + y) * Font::PAGE_SIZE + character.atlasPosition.x],
+				glyph->bitmap.buffer + (std::ptrdiff_t)y * glyph->bitmap.pitch, character.textureSize.x);
+		}
+		page.dirty = glm::ivec4(glm::min(glm::ivec2(page.dirty), character.atlasPosition),
+			glm::max(glm::ivec2(page.dirty.z, page.dirty.w), character.atlasPosition + character.textureSize));
+		page.codePoints.push_back(codePoint);
+		page.lastUsed = this->frame;
+	}
+	else
+	{
+		character.textureSize = glm::ivec2(0);
+	}
+
+	std::int32_t slot;
+	if (!this->freeSlots.empty())
+	{
+		slot = this->freeSlots.back();
+		this->freeSlots.pop_back();
+		this->characters[slot] = character;
+	}
+	else
+	{
+		slot = (std::int32_t)this->characters.size();
+		this->characters.push_back(character);
+	}
+	this->setSlot(codePoint, slot);
+	return this->characters[slot];
+}
+
+const Character& Font::getCharacter(const char32_t codePoint)
+{
+	std::int32_t slot = this->findSlot(codePoint);
+	if (slot < 0)
+	{
+		return this->loadCharacter(codePoint);
+	}
+
+	const Character& character = this->characters[slot];
+	if (character.textureSize.x > 0)
+	{
+		this->pages[character.page].lastUsed = this->frame;
+	}
+	return character;
+}
+
+GlyphInstance Font::generateGlyph(const char32_t codePoint, glm::vec2& cursorPos, const glm::vec2& scale, const glm::vec4& color)
+{
+	const Character& character = this->getCharacter(codePoint);
+
+	GlyphInstance glyph;
+	glyph.position = glm::vec2(
+		cursorPos.x + character.bearing.x * scale.x,
+		cursorPos.y - (character.size.y - character.bearing.y) * scale.y);
+	glyph.size = character.size * scale;
+
+	// the bitmap's first row is the top of the glyph
+	glm::vec2 bottomLeft = glm::vec2(character.atlasPosition.x, character.atlasPosition.y + character.textureSize.y) / (float)Font::PAGE_SIZE;
+	glm::vec2 topRight = glm::vec2(character.atlasPosition.x + character.textureSize.x, character.atlasPosition.y) / (float)Font::PAGE_SIZE;
+	glyph.atlasRect = glm::vec4(bottomLeft, topRight);
+	glyph.color = color;
+	glyph.page = character.page;
 
 	cursorPos.x += character.advance.x * scale.x;
-	return vertices;
+	return glyph;
 }
 
 GLuint Font::getTextureID()
@@ -152,9 +493,9 @@ GLuint Font::getTextureID()
 float Font::calculateLineWidth(const std::string& text, const glm::vec2& scale)
 {
 	float lineWidth = 0.0f;
-	for (char c : text)
+	for (std::size_t i = 0; i < text.size(); )
 	{
-		lineWidth += this->characters.at(c).advance.x * scale.x;
+		lineWidth += this->getCharacter(decodeUtf8(text, i)).advance.x * scale.x;
 	}
 	return lineWidth;
 }
@@ -164,21 +505,70 @@ float Font::getLineHeight(const glm::vec2 scale)
 	return this->lineSpacing * scale.y;
 }
 
-TextRenderer::TextRenderer()
+void Font::touchPages(const std::uint32_t pageMask)
+{
+	for (unsigned int i = 0; i < this->pages.size(); i++)
+	{
+		if (pageMask & (1u << i))
+		{
+			this->pages[i].lastUsed = this->frame;
+		}
+	}
+}
+
+std::size_t Font::getGeneration() const
+{
+	return this->generation;
+}
+
+void Font::flushUploads()
+{
+	for (unsigned int i = 0; i < this->pages.size(); i++)
+	{
+		Page& page = this->pages[i];
+		if (page.dirty.x >= page.dirty.z || page.dirty.y >= page.dirty.w)
+		{
+			continue;
+		}
+
+		// the rectangle is read straight out of the page's cpu copy
+		OpenGLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->textureID);
+		glCall(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+		glCall(glPixelStorei, GL_UNPACK_ROW_LENGTH, Font::PAGE_SIZE);
+		glCall(glTexSubImage3D, GL_TEXTURE_2D_ARRAY, 0, page.dirty.x, page.dirty.y, (GLint)i, page.dirty.z - page.dirty.x, page.dirty.w - page.dirty.y, 1,
+			GL_RED, GL_UNSIGNED_BYTE, page.pixels.data() + (std::size_t)page.dirty.y * Font::PAGE_SIZE + page.dirty.x);
+		glCall(glPixelStorei, GL_UNPACK_ROW_LENGTH, 0);
+		glCall(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+
+		page.dirty = glm::ivec4(Font::PAGE_SIZE, Font::PAGE_SIZE, 0, 0);
+		RenderStats::current.atlasUploads++;
+	}
+}
+
+void Font::endFrame()
+{
+	this->frame++;
+}
+
+TextRenderer::TextRenderer() : font("arial")
 {
-	this->font = Font("arial");
 	this->cursorPos = glm::vec2(0.0f);
 
 	// create render object
 	glCall(glGenVertexArrays, 1, &this->vao);
-	glCall(glGenBuffers, 1, &this->vbo);
-	glCall(glBindVertexArray, this->vao);
-	glCall(glBindBuffer, GL_ARRAY_BUFFER, this->vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-	glCall(glEnableVertexAttribArray, 0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-	glCall(glBindBuffer, GL_ARRAY_BUFFER, 0);
-	glCall(glBindVertexArray, 0);
+	OpenGLState::bindVertexArray(this->vao);
+	const std::array<GLuint, 3> offsets = { offsetof(GlyphInstance, position), offsetof(GlyphInstance, atlasRect), offsetof(GlyphInstance, color) };
+	for (GLuint i = 0; i < offsets.size(); i++)
+	{
+		glCall(glEnableVertexAttribArray, i);
+		glCall(glVertexAttribFormat, i, 4, GL_FLOAT, GL_FALSE, offsets[i]);
+		glCall(glVertexAttribBinding, i, 0);
+	}
+	glCall(glEnableVertexAttribArray, 3);
+	glCall(glVertexAttribIFormat, 3, 1, GL_UNSIGNED_INT, offsetof(GlyphInstance, page));
+	glCall(glVertexAttribBinding, 3, 0);
+	glCall(glVertexBindingDivisor, 0, 1);
+	OpenGLState::bindVertexArray(0);
 }
 
 std::vector<std::string> TextRenderer::splitString(const std::string& text, const std::string& delimiter)
@@ -195,12 +585,10 @@ std::vector<std::string> TextRenderer::splitString(const std::string& text, cons
 	return elements;
 }
 
-void TextRenderer::drawText(const std::string& text, const glm::vec2& pos, const glm::vec2& scale, const Align alignment, const Origin origin)
+void TextRenderer::layoutText(const std::string& text, const glm::vec2& pos, const glm::vec2& scale, const glm::vec3& color, const Align alignment,
+	const Origin origin, std::vector<GlyphInstance>& glyphs)
 {
-	// bind vao and texture atlas
-	glCall(glActiveTexture, GL_TEXTURE0);
-	glCall(glBindVertexArray, this->vao);
-	glCall(glBindTexture, GL_TEXTURE_2D, this->font.getTextureID());
+	glyphs.clear();
 
 	// calculate text bounding box
 	glm::vec2 boundingBox(0.0f);
@@ -257,59 +645,187 @@ void TextRenderer::drawText(const std::string& text, const glm::vec2& pos, const
 		yOffset -= boundingBox.y;
 	}
 
-	// draw each character
+	glm::vec4 glyphColor = glm::vec4(color, 1.0f);
 	this->cursorPos.y = pos.y + yOffset;
 	for (unsigned int i = 0; i < lines.size(); i++)
 	{
 		this->cursorPos.x = pos.x + lineOffsets[i];
-		for (char& c : lines[i])
+		for (std::size_t j = 0; j < lines[i].size(); )
 		{
-			std::array<std::array<float, 4>, 6> vertices = this->font.generateVertices(c, cursorPos, scale);
+			glyphs.push_back(this->font.generateGlyph(decodeUtf8(lines[i], j), cursorPos, scale, glyphColor));
+		}
+		this->cursorPos.y -= this->font.getLineHeight(scale);
+	}
+	RenderStats::current.textLayouts++;
+}
+
+void TextRenderer::drawGlyphs(const GLuint buffer, const std::size_t offset, const std::size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// glyphs rasterized since the last draw reach the atlas together
+	this->font.flushUploads();
 
-			glCall(glBindBuffer, GL_ARRAY_BUFFER, this->vbo);
-			glCall(glBufferSubData, GL_ARRAY_BUFFER, 0, sizeof(vertices), &vertices);
-			glCall(glBindBuffer, GL_ARRAY_BUFFER, 0);
+	// every glyph is an instanced quad sampling its atlas page
+	OpenGLState::activeTexture(GL_TEXTURE0);
+	OpenGLState::bindVertexArray(this->vao);
+	OpenGLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->font.getTextureID());
 
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+	glCall(glBindVertexBuffer, 0, buffer, (GLintptr)offset, (GLsizei)sizeof(GlyphInstance));
+	glCall(glDrawArraysInstanced, GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+
+	OpenGLState::bindVertexArray(0);
+	OpenGLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+bool TextRenderer::updateText(TextObject& object, const std::string& text, const glm::vec2& scale, const glm::vec3& color, const Align alignment,
+	const Origin origin)
+{
+	// a page cleared since the layout may hold other glyphs now, the layout is redone and only the moved glyphs are written
+	if (object.buffer != 0 && object.text == text && object.scale == scale && object.color == color && object.alignment == alignment && object.origin == origin &&
+		object.atlasGeneration == this->font.getGeneration())
+	{
+		this->font.touchPages(object.pageMask);
+		return false;
+	}
+	object.text = text;
+	object.scale = scale;
+	object.color = color;
+	object.alignment = alignment;
+	object.origin = origin;
+
+	this->layoutText(text, glm::vec2(0.0f), scale, color, alignment, origin, this->glyphs);
+	object.atlasGeneration = this->font.getGeneration();
+	object.pageMask = 0;
+	for (const GlyphInstance& glyph : this->glyphs)
+	{
+		object.pageMask |= 1u << glyph.page;
+	}
+
+	// a larger string moves to a new buffer, otherwise only the glyphs between the first and last difference are written
+	std::size_t first = 0;
+	std::size_t last = this->glyphs.size();
+	if (object.buffer == 0 || this->glyphs.size() > object.capacity)
+	{
+		object.destroy();
+		object.capacity = std::max(this->glyphs.size() * 2, (std::size_t)16);
+		glCall(glGenBuffers, 1, &object.buffer);
+		OpenGLState::bindBuffer(GL_COPY_WRITE_BUFFER, object.buffer);
+		glCall(glBufferData, GL_COPY_WRITE_BUFFER, object.capacity * sizeof(GlyphInstance), nullptr, GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		std::size_t common = std::min(this->glyphs.size(), object.glyphs.size());
+		while (first < common && std::memcmp(&this->glyphs[first], &object.glyphs[first], sizeof(GlyphInstance)) == 0)
+		{
+			first++;
+		}
+		if (this->glyphs.size() == object.glyphs.size())
+		{
+			while (last > first && std::memcmp(&this->glyphs[last - 1], &object.glyphs[last - 1], sizeof(GlyphInstance)) == 0)
+			{
+				last--;
+			}
 		}
-		this->cursorPos.y -= this->font.getLineHeight(scale);
 	}
 
-	// unbind
-	glCall(glBindVertexArray, 0);
-	glCall(glBindTexture, GL_TEXTURE_2D, 0);
+	if (last > first)
+	{
+		OpenGLState::bindBuffer(GL_COPY_WRITE_BUFFER, object.buffer);
+		glCall(glBufferSubData, GL_COPY_WRITE_BUFFER, first * sizeof(GlyphInstance), (last - first) * sizeof(GlyphInstance), this->glyphs.data() + first);
+		RenderStats::current.bufferUploads++;
+		RenderStats::current.glyphUploads += last - first;
+	}
+	object.glyphs.swap(this->glyphs);
+	return true;
 }
 
-void TextRenderer::drawText(const Display& display, TextShader shader, const std::string& text, const glm::vec3& pos, const glm::vec3& rot,
-	const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin)
+void TextRenderer::endFrame()
+{
+	this->font.endFrame();
+}
+
+void TextRenderer::drawText(TextShader shader, const TextObject& object, const glm::mat4& transformationMatrix, const glm::mat4& viewMatrix,
+	const glm::mat4& projectionMatrix)
 {
 	shader.start();
 
-	glm::mat4 transformationMatrix;
-	Maths::createTransformationMatrix(transformationMatrix, pos, rot.x, rot.y, rot.z, 1.0f);
+	shader.loadTransformationMatrix(transformationMatrix);
+	shader.loadProjectionMatrix(projectionMatrix);
+	shader.loadViewMatrix(viewMatrix);
+
+	this->drawGlyphs(object.buffer, 0, object.glyphs.size());
+
+	shader.stop();
+}
+
+void TextRenderer::drawText(TextShader shader, const std::string& text, const glm::mat4& transformationMatrix, const glm::mat4& viewMatrix,
+	const glm::mat4& projectionMatrix, const glm::vec2& pos, const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin)
+{
+	shader.start();
 
 	shader.loadTransformationMatrix(transformationMatrix);
-	shader.loadProjectionMatrix(display.getProjectionMatrix());
-	shader.loadViewMatrix(Camera::viewMatrix);
-	shader.loadTextColor(color);
+	shader.loadProjectionMatrix(projectionMatrix);
+	shader.loadViewMatrix(viewMatrix);
 
-	this->drawText(text, glm::vec2(0.0f), scale, alignment, origin);
+	// laid out again on every call, the glyphs only live in the ring buffer for this frame
+	this->layoutText(text, pos, scale, color, alignment, origin, this->glyphs);
+	RingAllocation allocation = RingBuffer::write(this->glyphs.data(), this->glyphs.size() * sizeof(GlyphInstance), sizeof(glm::vec4));
+	RenderStats::current.glyphUploads += this->glyphs.size();
+	this->drawGlyphs(allocation.buffer, allocation.offset, this->glyphs.size());
 
 	shader.stop();
 }
 
+void TextRenderer::drawText(const Display& display, TextShader shader, const std::string& text, const glm::vec3& pos, const glm::vec3& rot,
+	const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin)
+{
+	glm::mat4 transformationMatrix;
+	Maths::createTransformationMatrix(transformationMatrix, pos, rot.x, rot.y, rot.z, 1.0f);
+
+	this->drawText(shader, text, transformationMatrix, Camera::viewMatrix, display.getProjectionMatrix(), glm::vec2(0.0f), scale, color, alignment, origin);
+}
+
 void TextRenderer::drawTextOnHUD(const Display& display, TextShader shader, const std::string& text, const glm::vec2& pos, const glm::vec2& scale,
 	const glm::vec3& color, const Align alignment, const Origin origin)
 {
-	shader.start();
+	glm::mat4 projectionMatrix = glm::ortho(0.0f, (float)display.getResolution().x, 0.0f, (float)display.getResolution().y);
+	this->drawText(shader, text, glm::mat4(1.0f), glm::mat4(1.0f), projectionMatrix, pos, scale, color, alignment, origin);
+}
+
+void TextRenderer::drawText(const Display& display, TextShader shader, TextObject& object, const std::string& text, const glm::vec3& pos, const glm::vec3& rot,
+	const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin)
+{
+	this->updateText(object, text, scale, color, alignment, origin);
+
+	glm::mat4 transformationMatrix;
+	Maths::createTransformationMatrix(transformationMatrix, pos, rot.x, rot.y, rot.z, 1.0f);
+	this->drawText(shader, object, transformationMatrix, Camera::viewMatrix, display.getProjectionMatrix());
+}
+
+void TextRenderer::drawTextOnHUD(const Display& display, TextShader shader, TextObject& object, const std::string& text, const glm::vec2& pos,
+	const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin)
+{
+	this->updateText(object, text, scale, color, alignment, origin);
 
+	// laid out around the origin, the position only moves the text
 	glm::mat4 projectionMatrix = glm::ortho(0.0f, (float)display.getResolution().x, 0.0f, (float)display.getResolution().y);
-	shader.loadTransformationMatrix(glm::mat4(1.0f));
-	shader.loadProjectionMatrix(projectionMatrix);
-	shader.loadViewMatrix(glm::mat4(1.0f));
-	shader.loadTextColor(color);
+	this->drawText(shader, object, glm::translate(glm::mat4(1.0f), glm::vec3(pos, 0.0f)), glm::mat4(1.0f), projectionMatrix);
+}
 
-	this->drawText(text, pos, scale, alignment, origin);
+TextObject::~TextObject()
+{
+	this->destroy();
+}
 
-	shader.stop();
-}
\ No newline at end of file
+void TextObject::destroy()
+{
+	OpenGLState::deleteBuffers(1, &this->buffer);
+	this->buffer = 0;
+	this->capacity = 0;
+	this->pageMask = 0;
+	this->glyphs.clear();
+}
@@ -1,16 +1,20 @@
 #pragma once
 
 #include "DisplayManager.h"
+#include "SkylinePacker.h"
 #include "TextShader.h"
 
 #include <glad/glad.h>
 
 #include <glm/common.hpp>
 
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <unordered_map>
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <array>
-#include <map>
 
 
 enum class Align {
@@ -23,54 +27,201 @@ enum class Origin {
 	bottomLeft, bottom, bottomRight
 };
 
+// a glyph in the atlas, textureSize is zero for glyphs without pixels which take no atlas space
 struct Character
 {
-	float textureAtlasOffset;
-	glm::ivec2 textureSize;
+	unsigned int page = 0;
+	glm::ivec2 atlasPosition = glm::ivec2(0);
+	glm::ivec2 textureSize = glm::ivec2(0);
+
+	// metrics in units of the font size
+	glm::vec2 size = glm::vec2(0.0f);
+	glm::vec2 bearing = glm::vec2(0.0f);
+	glm::vec2 advance = glm::vec2(0.0f);
+};
 
+// per instance attributes of one glyph quad, the corner is picked in the vertex shader from gl_VertexID
+struct GlyphInstance
+{
+	glm::vec2 position;
 	glm::vec2 size;
-	glm::vec2 bearing;
-	glm::vec2 advance;
+	glm::vec4 atlasRect; // texture coordinates of the bottom left and top right corners
+	glm::vec4 color;
+	unsigned int page; // layer of the atlas texture array
 };
 
+// glyphs are signed distance fields rasterized through FreeType the first time they are laid out and packed into fixed
+// size pages, the layers of one texture array, so one atlas serves text at any scale, when no page has room the least
+// recently used page no text of the current frame has touched is cleared as a whole
+//
+// printable ascii is baked once and kept in the asset cache, later runs restore those pages without opening the font and
+// FreeType is only loaded for glyphs outside that set
+//
+// packing only writes the glyph into a cpu copy of its page and grows the page's dirty rectangle, flushUploads sends
+// every dirty rectangle with one sub image upload before the next text draw
 class Font
 {
+public:
+	static const int PAGE_SIZE = 512;
+	static const unsigned int PAGE_COUNT = 8;
+
+	// code points below this are looked up in a flat table, the rest in a map
+	static const char32_t TABLE_SIZE = 0x10000;
+
+	// distance in texels from the outline to where the field saturates, texels of a glyph's bitmap extend this far past its outline
+	static const int DISTANCE_SPREAD = 4;
+
+	// range of code points in the baked atlas
+	static const char32_t BAKED_FIRST = 0x20;
+	static const char32_t BAKED_LAST = 0x7E;
+
+	static const std::uint32_t MAGIC;
+	static const std::uint32_t VERSION;
+
 private:
-	std::map<char, Character> characters;
+	struct Page
+	{
+		SkylinePacker packer;
+		std::vector<unsigned char> pixels;
+		std::vector<char32_t> codePoints;
+		std::size_t lastUsed = 0;
+
+		// min and max corner of the texels written since the last flush, empty when min > max
+		glm::ivec4 dirty = glm::ivec4(Font::PAGE_SIZE, Font::PAGE_SIZE, 0, 0);
+	};
+
+	std::string fontPath;
+	FT_Library library = nullptr;
+	FT_Face face = nullptr;
+	bool faceFailed = false;
+	unsigned int fontQuality = 32;
 	float lineSpacing = 1.0f;
 
-	unsigned int textureWidth = 0;
-	unsigned int textureHeight = 0;
+	// cached glyphs addressed by slot, slots of evicted glyphs are reused
+	std::vector<Character> characters;
+	std::vector<std::int32_t> freeSlots;
+	std::vector<std::int32_t> table;
+	std::unordered_map<char32_t, std::int32_t> map;
+
+	std::vector<Page> pages;
 	GLuint textureID = 0;
+	std::size_t frame = 1;
+	std::size_t generation = 0;
+
+	// handed out for glyphs that did not fit, they keep their advance and are drawn empty
+	Character unpacked;
+
+	// loads FreeType and the font the first time a glyph has to be rasterized
+	bool openFace();
+
+	std::string getCookedPath() const;
+	bool loadBakedAtlas(const std::string& cookedPath);
+	void saveBakedAtlas(const std::string& cookedPath);
+
+	std::int32_t findSlot(const char32_t codePoint) const;
+	void setSlot(const char32_t codePoint, const std::int32_t slot);
+	const Character& loadCharacter(const char32_t codePoint);
+	bool packGlyph(const glm::ivec2& size, unsigned int& page, glm::ivec2& position);
+	void evictPage(const unsigned int page);
 
 public:
-	Font() = default;
-	Font(const std::string& fontName, const unsigned int fontQuality);
-	~Font() = default;
+	// the quality is the size in texels of the em square the distance fields are rasterized at
+	Font(const std::string& fontName, const unsigned int fontQuality = 32);
+	~Font();
 
-	std::array<std::array<float, 4>, 6> generateVertices(const char c, glm::vec2& cursorPos, const glm::vec2& scale);
+	Font(const Font&) = delete;
+	Font& operator=(const Font&) = delete;
+
+	// rasterizes the glyph when it is not cached and marks its page as used this frame
+	const Character& getCharacter(const char32_t codePoint);
+	GlyphInstance generateGlyph(const char32_t codePoint, glm::vec2& cursorPos, const glm::vec2& scale, const glm::vec4& color);
 	GLuint getTextureID();
 	float calculateLineWidth(const std::string& text, const glm::vec2& scale);
 	float getLineHeight(const glm::vec2 scale);
+
+	// marks the pages in the mask as used this frame, for text drawn from glyphs laid out in an earlier frame
+	void touchPages(const std::uint32_t pageMask);
+
+	// bumped whenever a page is cleared, glyphs laid out under an older generation may point at other glyphs
+	std::size_t getGeneration() const;
+
+	// uploads the dirty rectangle of every page written since the last flush
+	void flushUploads();
+
+	// pages used in this frame become candidates for eviction
+	void endFrame();
+};
+
+// string laid out once into its own vertex buffer, kept until one of the inputs it was laid out with changes
+class TextObject
+{
+private:
+	std::string text;
+	glm::vec2 scale = glm::vec2(0.0f);
+	glm::vec3 color = glm::vec3(0.0f);
+	Align alignment = Align::left;
+	Origin origin = Origin::topLeft;
+
+	// glyphs in the buffer, laid out around the origin
+	std::vector<GlyphInstance> glyphs;
+	GLuint buffer = 0;
+	std::size_t capacity = 0;
+
+	// atlas pages the glyphs sample and the atlas generation they were laid out under
+	std::uint32_t pageMask = 0;
+	std::size_t atlasGeneration = 0;
+
+	friend class TextRenderer;
+
+public:
+	TextObject() = default;
+	TextObject(const TextObject&) = delete;
+	TextObject& operator=(const TextObject&) = delete;
+	~TextObject();
+
+	void destroy();
 };
 
 class TextRenderer
 {
 private:
 	glm::vec2 cursorPos;
+	// reads one GlyphInstance per instance from the ring buffer, bound at each string's allocation
 	GLuint vao;
-	GLuint vbo;
 	Font font;
 
+	// scratch for layouts, kept between calls to avoid reallocating
+	std::vector<GlyphInstance> glyphs;
+
 	std::vector<std::string> splitString(const std::string& text, const std::string& delimiter);
-	void drawText(const std::string& text, const glm::vec2& pos, const glm::vec2& scale, const Align alignment, const Origin origin);
+	void layoutText(const std::string& text, const glm::vec2& pos, const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin,
+		std::vector<GlyphInstance>& glyphs);
+	void drawGlyphs(const GLuint buffer, const std::size_t offset, const std::size_t count);
 
 public:
 	TextRenderer();
 	~TextRenderer() = default;
 
+	// called once at the end of every frame, lets the font evict pages that were not used in it
+	void endFrame();
+
+	// lays the object out again when any input differs from its last layout, only the changed run of glyphs is uploaded, returns whether it changed
+	bool updateText(TextObject& object, const std::string& text, const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin);
+
+	void drawText(TextShader shader, const TextObject& object, const glm::mat4& transformationMatrix, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+
+	// every glyph of the string in one instanced draw, the other overloads fill in the matrices
+	void drawText(TextShader shader, const std::string& text, const glm::mat4& transformationMatrix, const glm::mat4& viewMatrix,
+		const glm::mat4& projectionMatrix, const glm::vec2& pos, const glm::vec2& scale, const glm::vec3& color, const Align alignment, const Origin origin);
+
 	void drawText(const Display& display, TextShader shader, const std::string& text, const glm::vec3& pos, const glm::vec3& rot,
 		const glm::vec2& scale = glm::vec2(24.0f), const glm::vec3& color = glm::vec3(1.0f), const Align = Align::center, const Origin origin = Origin::center);
 	void drawTextOnHUD(const Display& display, TextShader shader, const std::string& text, const glm::vec2& pos, const glm::vec2& scale = glm::vec2(24.0f),
 		const glm::vec3& color = glm::vec3(1.0f), const Align alignment = Align::center, const Origin origin = Origin::center);
+
+	// the same as above for text that is drawn every frame, laid out again only when the string or its style changes
+	void drawText(const Display& display, TextShader shader, TextObject& object, const std::string& text, const glm::vec3& pos, const glm::vec3& rot,
+		const glm::vec2& scale = glm::vec2(24.0f), const glm::vec3& color = glm::vec3(1.0f), const Align = Align::center, const Origin origin = Origin::center);
+	void drawTextOnHUD(const Display& display, TextShader shader, TextObject& object, const std::string& text, const glm::vec2& pos,
+		const glm::vec2& scale = glm::vec2(24.0f), const glm::vec3& color = glm::vec3(1.0f), const Align alignment = Align::center, const Origin origin = Origin::center);
 };
\ No newline at end of file
@@ -9,7 +9,10 @@ TextShader::TextShader(const std::string& vertexShaderFilename, const std::strin
 
 void TextShader::bindAttributes()
 {
-	this->bindAttribute(0, "vertex_vs");
+	this->bindAttribute(0, "glyphRect_vs");
+	this->bindAttribute(1, "atlasRect_vs");
+	this->bindAttribute(2, "color_vs");
+	this->bindAttribute(3, "page_vs");
 }
 
 void TextShader::getAllUniformLocations()
@@ -17,7 +20,6 @@ void TextShader::getAllUniformLocations()
 	this->location_transformationMatrix = this->getUniformLocation("transformationMatrix");
 	this->location_projectionMatrix = this->getUniformLocation("projectionMatrix");
 	this->location_viewMatrix = this->getUniformLocation("viewMatrix");
-	this->location_textColor = this->getUniformLocation("textColor");
 }
 
 void TextShader::loadTransformationMatrix(const glm::mat4& matrix)
@@ -34,8 +36,3 @@ void TextShader::loadViewMatrix(const glm::mat4& matrix)
 {
 	this->loadMat4(this->location_viewMatrix, matrix);
 }
-
-void TextShader::loadTextColor(const glm::vec3& color)
-{
-	this->loadVec3(this->location_textColor, color);
-}
@@ -13,7 +13,6 @@ public:
 	int location_transformationMatrix;
 	int location_projectionMatrix;
 	int location_viewMatrix;
-	int location_textColor;
 
 	TextShader() = default;
 
@@ -30,6 +29,4 @@ public:
 	void loadProjectionMatrix(const glm::mat4& matrix);
 
 	void loadViewMatrix(const glm::mat4& matrix);
-
-	void loadTextColor(const glm::vec3& color);
 };
@@ -0,0 +1,414 @@
+#include "TextureCache.h"
+
+#include "stb_image.h"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <format>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#include "AssetCache.h"
+#include "MappedFile.h"
+#include "Config.h"
+#include "Loader.h"
+
+namespace
+{
+	const std::uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+	const std::uint32_t DDS_FOURCC_DX10 = 0x30315844; // "DX10"
+
+	const std::uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+	const std::uint32_t DDPF_FOURCC = 0x4;
+	const std::uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+	const std::uint32_t DDSCAPS2_CUBEMAP_ALL_FACES = 0xFE00;
+	const std::uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+	const std::uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+	const std::uint32_t DXGI_FORMAT_BC1_UNORM = 71, DXGI_FORMAT_BC3_UNORM = 77, DXGI_FORMAT_BC5_UNORM = 83, DXGI_FORMAT_BC7_UNORM = 98;
+
+	struct DDSPixelFormat
+	{
+		std::uint32_t size;
+		std::uint32_t flags;
+		std::uint32_t fourCC;
+		std::uint32_t rgbBitCount;
+		std::uint32_t bitMasks[4];
+	};
+
+	// engine fields live in the reserved block of the dds header so other tools can still open the files
+	struct CookInfo
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t unused[9];
+	};
+
+	struct DDSHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t size;
+		std::uint32_t flags;
+		std::uint32_t height;
+		std::uint32_t width;
+		std::uint32_t pitchOrLinearSize;
+		std::uint32_t depth;
+		std::uint32_t mipMapCount;
+		CookInfo cookInfo;
+		DDSPixelFormat pixelFormat;
+		std::uint32_t caps[4];
+		std::uint32_t reserved;
+		std::uint32_t dxgiFormat;
+		std::uint32_t resourceDimension;
+		std::uint32_t miscFlag;
+		std::uint32_t arraySize;
+		std::uint32_t miscFlags2;
+	};
+
+	static_assert(sizeof(DDSHeader) == 4 + 124 + 20, "DDS header must match the file layout");
+
+	std::uint32_t getDXGIFormat(const TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			return DXGI_FORMAT_BC1_UNORM;
+		case TextureFormat::BC3:
+			return DXGI_FORMAT_BC3_UNORM;
+		case TextureFormat::BC5:
+			return DXGI_FORMAT_BC5_UNORM;
+		default:
+			return DXGI_FORMAT_BC7_UNORM;
+		}
+	}
+
+	bool getTextureFormat(const std::uint32_t dxgiFormat, TextureFormat& format)
+	{
+		switch (dxgiFormat)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+			format = TextureFormat::BC1;
+			return true;
+		case DXGI_FORMAT_BC3_UNORM:
+			format = TextureFormat::BC3;
+			return true;
+		case DXGI_FORMAT_BC5_UNORM:
+			format = TextureFormat::BC5;
+			return true;
+		case DXGI_FORMAT_BC7_UNORM:
+			format = TextureFormat::BC7;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// expands to rgba the same way gl fills missing channels for GL_RED / GL_RG / GL_RGB uploads
+	std::vector<unsigned char> expandToRGBA(const unsigned char* data, const int width, const int height, const int nrComponents)
+	{
+		std::vector<unsigned char> rgba((std::size_t)width * height * 4);
+		for (std::size_t i = 0; i < (std::size_t)width * height; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				rgba[i * 4 + c] = c < nrComponents ? data[i * nrComponents + c] : (c == 3 ? 255 : 0);
+			}
+		}
+		return rgba;
+	}
+
+	// 2x2 box filter, normal maps are renormalised so lower mips do not flatten out
+	std::vector<unsigned char> downsample(const std::vector<unsigned char>& rgba, const int width, const int height, const bool normalMap)
+	{
+		int mipWidth = std::max(width / 2, 1);
+		int mipHeight = std::max(height / 2, 1);
+		std::vector<unsigned char> mip((std::size_t)mipWidth * mipHeight * 4);
+
+		for (int y = 0; y < mipHeight; y++)
+		{
+			for (int x = 0; x < mipWidth; x++)
+			{
+				float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (int sampleY = 0; sampleY < 2; sampleY++)
+				{
+					for (int sampleX = 0; sampleX < 2; sampleX++)
+					{
+						int sourceX = std::min(x * 2 + sampleX, width - 1);
+						int sourceY = std::min(y * 2 + sampleY, height - 1);
+						const unsigned char* pixel = &rgba[((std::size_t)sourceY * width + sourceX) * 4];
+						for (int c = 0; c < 4; c++)
+						{
+							sum[c] += pixel[c] / 4.0f;
+						}
+					}
+				}
+
+				if (normalMap)
+				{
+					float normal[3] = { sum[0] / 127.5f - 1.0f, sum[1] / 127.5f - 1.0f, sum[2] / 127.5f - 1.0f };
+					float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+					if (length > 0.0f)
+					{
+						for (int c = 0; c < 3; c++)
+						{
+							sum[c] = (normal[c] / length + 1.0f) * 127.5f;
+						}
+					}
+				}
+
+				unsigned char* pixel = &mip[((std::size_t)y * mipWidth + x) * 4];
+				for (int c = 0; c < 4; c++)
+				{
+					pixel[c] = (unsigned char)std::clamp((int)std::lround(sum[c]), 0, 255);
+				}
+			}
+		}
+
+		return mip;
+	}
+}
+
+const std::uint32_t TextureCache::MAGIC = 0x58544547; // "GETX"
+const std::uint32_t TextureCache::VERSION = 2;
+
+std::string TextureCache::getCookedPath(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically)
+{
+	// only the settings that change the cooked output are part of the key
+	std::string settings = std::format("flip={:d};normal={:d};highQuality={:d}", flipVertically, typeName == "texture_normal", Config::Textures::HIGH_QUALITY_COMPRESSION);
+	std::string key = AssetCache::getKey(sources, settings, TextureCache::VERSION);
+	return key.empty() ? "" : AssetCache::getEntryPath(key, ".dds");
+}
+
+bool TextureCache::isCookedFileValid(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically)
+{
+	DDSHeader header;
+	std::ifstream in(TextureCache::getCookedPath(sources, typeName, flipVertically), std::ios::binary);
+	bool valid = in.is_open() && in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+		header.magic == DDS_MAGIC && header.cookInfo.magic == TextureCache::MAGIC && header.cookInfo.version == TextureCache::VERSION;
+
+	if (valid)
+	{
+		AssetCache::recordHit();
+	}
+	else
+	{
+		AssetCache::recordMiss();
+	}
+	return valid;
+}
+
+TextureFormat TextureCache::chooseFormat(const std::string& typeName, const unsigned char* rgba, const int width, const int height)
+{
+	if (typeName == "texture_normal")
+	{
+		return TextureFormat::BC5;
+	}
+	else if (Config::Textures::HIGH_QUALITY_COMPRESSION)
+	{
+		return TextureFormat::BC7;
+	}
+
+	for (std::size_t i = 0; i < (std::size_t)width * height; i++)
+	{
+		if (rgba[i * 4 + 3] != 255)
+		{
+			return TextureFormat::BC3;
+		}
+	}
+	return TextureFormat::BC1;
+}
+
+bool TextureCache::cook(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically)
+{
+	const std::string& path = sources[0];
+	std::vector<std::vector<unsigned char>> faces;
+	int width = 0, height = 0;
+	for (const std::string& source : sources)
+	{
+		int faceWidth, faceHeight, nrComponents;
+		unsigned char* data = Loader::decodeImage(source, flipVertically, faceWidth, faceHeight, nrComponents);
+		if (!data)
+		{
+			spdlog::error("Failed to cook texture '{}', could not load '{}'", path, source);
+			return false;
+		}
+
+		if (!faces.empty() && (faceWidth != width || faceHeight != height))
+		{
+			spdlog::error("Failed to cook texture '{}', faces differ in size", path);
+			stbi_image_free(data);
+			return false;
+		}
+		width = faceWidth;
+		height = faceHeight;
+
+		faces.push_back(expandToRGBA(data, width, height, nrComponents));
+		stbi_image_free(data);
+	}
+
+	TextureFormat format = TextureCache::chooseFormat(typeName, faces[0].data(), width, height);
+	bool normalMap = format == TextureFormat::BC5;
+	std::uint32_t mipMapCount = (std::uint32_t)std::floor(std::log2(std::max(width, height))) + 1;
+
+	DDSHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.magic = DDS_MAGIC;
+	header.size = 124;
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = (std::uint32_t)TextureCompressor::getCompressedSize(format, width, height);
+	header.mipMapCount = mipMapCount;
+	header.cookInfo.magic = TextureCache::MAGIC;
+	header.cookInfo.version = TextureCache::VERSION;
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = DDPF_FOURCC;
+	header.pixelFormat.fourCC = DDS_FOURCC_DX10;
+	header.caps[0] = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+	header.caps[1] = faces.size() == 6 ? DDSCAPS2_CUBEMAP_ALL_FACES : 0;
+	header.dxgiFormat = getDXGIFormat(format);
+	header.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	header.miscFlag = faces.size() == 6 ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+	header.arraySize = 1;
+
+	// write to a temporary file first so a partially written file is never picked up as valid
+	std::string cookedPath = TextureCache::getCookedPath(sources, typeName, flipVertically);
+	if (cookedPath.empty() || !AssetCache::prepareEntry(cookedPath))
+	{
+		spdlog::error("Could not write cooked texture for '{}'", path);
+		return false;
+	}
+	std::string temporaryPath = AssetCache::getTemporaryPath(cookedPath);
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open() || !out.write(reinterpret_cast<const char*>(&header), sizeof(header)))
+		{
+			spdlog::error("Could not write cooked texture '{}'", cookedPath);
+			return false;
+		}
+
+		// dds stores every mip of the first face, then every mip of the next
+		for (std::vector<unsigned char>& face : faces)
+		{
+			int mipWidth = width, mipHeight = height;
+			for (std::uint32_t level = 0; level < mipMapCount; level++)
+			{
+				if (level > 0)
+				{
+					face = downsample(face, mipWidth, mipHeight, normalMap);
+					mipWidth = std::max(mipWidth / 2, 1);
+					mipHeight = std::max(mipHeight / 2, 1);
+				}
+
+				std::vector<unsigned char> compressed = TextureCompressor::compress(format, face.data(), mipWidth, mipHeight);
+				out.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+			}
+		}
+
+		if (!out)
+		{
+			spdlog::error("Could not write cooked texture '{}'", cookedPath);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	if (error)
+	{
+		spdlog::error("Could not write cooked texture '{}', {}", cookedPath, error.message());
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	AssetCache::recordWrite();
+	spdlog::debug("Cooked texture '{}' to '{}' ({:d}x{:d}, {:d} mips)", path, cookedPath, width, height, mipMapCount);
+	return true;
+}
+
+bool TextureCache::load(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically, const GLenum target, std::vector<TextureImage>& images)
+{
+	MappedFile file;
+	if (!file.open(TextureCache::getCookedPath(sources, typeName, flipVertically)))
+	{
+		return false;
+	}
+
+	const unsigned char* data = file.getData();
+	const std::size_t size = file.getSize();
+
+	DDSHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+
+	TextureFormat format;
+	if (header.magic != DDS_MAGIC || header.pixelFormat.fourCC != DDS_FOURCC_DX10 || !getTextureFormat(header.dxgiFormat, format))
+	{
+		return false;
+	}
+
+	bool cubeMap = (header.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+	if (cubeMap != (target == GL_TEXTURE_CUBE_MAP))
+	{
+		return false;
+	}
+
+	std::size_t offset = sizeof(header);
+	unsigned int faceCount = cubeMap ? 6 : 1;
+	std::uint32_t mipMapCount = std::max(header.mipMapCount, 1u);
+
+	images.clear();
+	for (unsigned int face = 0; face < faceCount; face++)
+	{
+		int mipWidth = header.width, mipHeight = header.height;
+		for (std::uint32_t level = 0; level < mipMapCount; level++)
+		{
+			std::size_t levelSize = TextureCompressor::getCompressedSize(format, mipWidth, mipHeight);
+			if (offset + levelSize > size)
+			{
+				images.clear();
+				return false;
+			}
+
+			TextureImage image;
+			image.target = cubeMap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+			image.level = level;
+			image.width = mipWidth;
+			image.height = mipHeight;
+			image.nrComponents = format == TextureFormat::BC5 ? 2 : 4;
+			image.internalFormat = TextureCompressor::getInternalFormat(format);
+			image.size = levelSize;
+			image.pixels = std::unique_ptr<unsigned char, void(*)(void*)>((unsigned char*)std::malloc(levelSize), std::free);
+			std::memcpy(image.pixels.get(), data + offset, levelSize);
+			images.push_back(std::move(image));
+
+			offset += levelSize;
+			mipWidth = std::max(mipWidth / 2, 1);
+			mipHeight = std::max(mipHeight / 2, 1);
+		}
+	}
+
+	return true;
+}
+
+bool TextureCache::loadOrCook(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically, const GLenum target, std::vector<TextureImage>& images)
+{
+	if (!TextureCache::isCookedFileValid(sources, typeName, flipVertically) && !TextureCache::cook(sources, typeName, flipVertically))
+	{
+		return false;
+	}
+
+	if (!TextureCache::load(sources, typeName, flipVertically, target, images))
+	{
+		spdlog::error("Cooked texture '{}' is corrupt", TextureCache::getCookedPath(sources, typeName, flipVertically));
+		return false;
+	}
+	return true;
+}
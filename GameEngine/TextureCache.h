@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include "TextureCompressor.h"
+#include "TextureImage.h"
+
+struct TextureCache
+{
+	static const std::uint32_t MAGIC;
+	static const std::uint32_t VERSION;
+
+	// cache entry for a texture, sources are the image(s) with six faces for a cube map, empty if a source cannot be read
+	static std::string getCookedPath(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically);
+
+	static bool isCookedFileValid(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically);
+
+	static TextureFormat chooseFormat(const std::string& typeName, const unsigned char* rgba, const int width, const int height);
+
+	static bool cook(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically);
+
+	static bool load(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically, const GLenum target, std::vector<TextureImage>& images);
+
+	static bool loadOrCook(const std::vector<std::string>& sources, const std::string& typeName, const bool flipVertically, const GLenum target, std::vector<TextureImage>& images);
+};
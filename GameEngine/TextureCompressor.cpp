@@ -0,0 +1,542 @@
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_COMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// pixels of a 4x4 block in planar layout so the palette search can test 4 pixels per instruction
+	struct BlockPixels
+	{
+		alignas(16) float channels[4][16];
+	};
+
+	const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	void loadBlock(const unsigned char* block, BlockPixels& pixels)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				pixels.channels[c][i] = (float)block[i * 4 + c];
+			}
+		}
+	}
+
+	// writes the closest palette entry for every pixel and returns the summed squared error
+	float findClosest(const BlockPixels& pixels, const int firstChannel, const int channelCount, const float palette[][4], const int paletteSize, unsigned char* indices)
+	{
+		float error = 0.0f;
+#ifdef TEXTURE_COMPRESSOR_SSE2
+		for (int p = 0; p < 16; p += 4)
+		{
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int i = 0; i < paletteSize; i++)
+			{
+				__m128 distance = _mm_setzero_ps();
+				for (int c = firstChannel; c < firstChannel + channelCount; c++)
+				{
+					__m128 difference = _mm_sub_ps(_mm_load_ps(&pixels.channels[c][p]), _mm_set1_ps(palette[i][c]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+				}
+
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+				best = _mm_min_ps(distance, best);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(i)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			alignas(16) float bestDistance[4];
+			alignas(16) std::int32_t bestIndices[4];
+			_mm_store_ps(bestDistance, best);
+			_mm_store_si128(reinterpret_cast<__m128i*>(bestIndices), bestIndex);
+			for (int k = 0; k < 4; k++)
+			{
+				indices[p + k] = (unsigned char)bestIndices[k];
+				error += bestDistance[k];
+			}
+		}
+#else
+		for (int p = 0; p < 16; p++)
+		{
+			float best = FLT_MAX;
+			for (int i = 0; i < paletteSize; i++)
+			{
+				float distance = 0.0f;
+				for (int c = firstChannel; c < firstChannel + channelCount; c++)
+				{
+					float difference = pixels.channels[c][p] - palette[i][c];
+					distance += difference * difference;
+				}
+
+				if (distance < best)
+				{
+					best = distance;
+					indices[p] = (unsigned char)i;
+				}
+			}
+			error += best;
+		}
+#endif
+		return error;
+	}
+
+	// fits a line through the block with a few power iterations on the covariance matrix and returns its end points
+	void findEndpoints(const BlockPixels& pixels, const int channelCount, float start[4], float end[4])
+	{
+		float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int c = 0; c < channelCount; c++)
+		{
+			for (int p = 0; p < 16; p++)
+			{
+				mean[c] += pixels.channels[c][p];
+			}
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for (int p = 0; p < 16; p++)
+		{
+			for (int i = 0; i < channelCount; i++)
+			{
+				for (int j = 0; j < channelCount; j++)
+				{
+					covariance[i][j] += (pixels.channels[i][p] - mean[i]) * (pixels.channels[j][p] - mean[j]);
+				}
+			}
+		}
+
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float length = 0.0f;
+			for (int i = 0; i < channelCount; i++)
+			{
+				for (int j = 0; j < channelCount; j++)
+				{
+					next[i] += covariance[i][j] * axis[j];
+				}
+				length = std::max(length, std::abs(next[i]));
+			}
+
+			if (length < FLT_EPSILON)
+			{
+				break;
+			}
+			for (int i = 0; i < channelCount; i++)
+			{
+				axis[i] = next[i] / length;
+			}
+		}
+
+		float axisLength = 0.0f;
+		for (int c = 0; c < channelCount; c++)
+		{
+			axisLength += axis[c] * axis[c];
+		}
+		axisLength = std::sqrt(axisLength);
+		for (int c = 0; c < channelCount; c++)
+		{
+			axis[c] /= axisLength;
+		}
+
+		float minProjection = FLT_MAX;
+		float maxProjection = -FLT_MAX;
+		for (int p = 0; p < 16; p++)
+		{
+			float projection = 0.0f;
+			for (int c = 0; c < channelCount; c++)
+			{
+				projection += (pixels.channels[c][p] - mean[c]) * axis[c];
+			}
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (int c = 0; c < 4; c++)
+		{
+			start[c] = c < channelCount ? std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f) : 255.0f;
+			end[c] = c < channelCount ? std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f) : 255.0f;
+		}
+	}
+
+	// least squares fit of both end points for fixed indices, weights give how far along the line each index lies
+	bool refineEndpoints(const BlockPixels& pixels, const int channelCount, const unsigned char* indices, const float* weights, float start[4], float end[4])
+	{
+		float alpha2 = 0.0f, beta2 = 0.0f, alphaBeta = 0.0f;
+		float alphaX[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float betaX[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int p = 0; p < 16; p++)
+		{
+			float beta = weights[indices[p]];
+			float alpha = 1.0f - beta;
+			alpha2 += alpha * alpha;
+			beta2 += beta * beta;
+			alphaBeta += alpha * beta;
+			for (int c = 0; c < channelCount; c++)
+			{
+				alphaX[c] += alpha * pixels.channels[c][p];
+				betaX[c] += beta * pixels.channels[c][p];
+			}
+		}
+
+		float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+		if (std::abs(determinant) < FLT_EPSILON)
+		{
+			return false;
+		}
+
+		for (int c = 0; c < channelCount; c++)
+		{
+			start[c] = std::clamp((alphaX[c] * beta2 - betaX[c] * alphaBeta) / determinant, 0.0f, 255.0f);
+			end[c] = std::clamp((betaX[c] * alpha2 - alphaX[c] * alphaBeta) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	std::uint16_t packColor565(const float color[4])
+	{
+		std::uint16_t r = (std::uint16_t)std::lround(color[0] * 31.0f / 255.0f);
+		std::uint16_t g = (std::uint16_t)std::lround(color[1] * 63.0f / 255.0f);
+		std::uint16_t b = (std::uint16_t)std::lround(color[2] * 31.0f / 255.0f);
+		return (std::uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void unpackColor565(const std::uint16_t packed, float color[4])
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (float)((r << 3) | (r >> 2));
+		color[1] = (float)((g << 2) | (g >> 4));
+		color[2] = (float)((b << 3) | (b >> 2));
+		color[3] = 255.0f;
+	}
+
+	float encodeColorEndpoints(const BlockPixels& pixels, std::uint16_t& color0, std::uint16_t& color1, unsigned char* indices)
+	{
+		// four colour mode requires color0 > color1
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		float palette[4][4];
+		unpackColor565(color0, palette[0]);
+		unpackColor565(color1, palette[1]);
+		if (color0 == color1)
+		{
+			return findClosest(pixels, 0, 3, palette, 1, indices);
+		}
+
+		for (int c = 0; c < 4; c++)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+		return findClosest(pixels, 0, 3, palette, 4, indices);
+	}
+
+	void compressColorBlock(const BlockPixels& pixels, unsigned char* output)
+	{
+		float start[4], end[4];
+		findEndpoints(pixels, 3, start, end);
+
+		std::uint16_t color0 = packColor565(end);
+		std::uint16_t color1 = packColor565(start);
+		unsigned char indices[16];
+		float error = encodeColorEndpoints(pixels, color0, color1, indices);
+
+		const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		if (color0 != color1 && refineEndpoints(pixels, 3, indices, weights, start, end))
+		{
+			std::uint16_t refinedColor0 = packColor565(start);
+			std::uint16_t refinedColor1 = packColor565(end);
+			unsigned char refinedIndices[16];
+			float refinedError = encodeColorEndpoints(pixels, refinedColor0, refinedColor1, refinedIndices);
+			if (refinedError < error)
+			{
+				color0 = refinedColor0;
+				color1 = refinedColor1;
+				std::memcpy(indices, refinedIndices, sizeof(indices));
+			}
+		}
+
+		std::uint32_t packedIndices = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			packedIndices |= (std::uint32_t)indices[i] << (i * 2);
+		}
+
+		std::memcpy(output, &color0, 2);
+		std::memcpy(output + 2, &color1, 2);
+		std::memcpy(output + 4, &packedIndices, 4);
+	}
+
+	void compressChannelBlock(const BlockPixels& pixels, const int channel, unsigned char* output)
+	{
+		float minValue = 255.0f, maxValue = 0.0f;
+		for (int p = 0; p < 16; p++)
+		{
+			minValue = std::min(minValue, pixels.channels[channel][p]);
+			maxValue = std::max(maxValue, pixels.channels[channel][p]);
+		}
+
+		unsigned char endpoint0 = (unsigned char)std::lround(maxValue);
+		unsigned char endpoint1 = (unsigned char)std::lround(minValue);
+		output[0] = endpoint0;
+		output[1] = endpoint1;
+
+		unsigned char indices[16] = {};
+		if (endpoint0 != endpoint1)
+		{
+			// eight value mode, endpoint0 > endpoint1 with six interpolated values between them
+			float palette[8][4];
+			palette[0][channel] = endpoint0;
+			palette[1][channel] = endpoint1;
+			for (int i = 2; i < 8; i++)
+			{
+				palette[i][channel] = ((8 - i) * endpoint0 + (i - 1) * endpoint1) / 7.0f;
+			}
+			findClosest(pixels, channel, 1, palette, 8, indices);
+		}
+
+		std::uint64_t packedIndices = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			packedIndices |= (std::uint64_t)indices[i] << (i * 3);
+		}
+		for (int i = 0; i < 6; i++)
+		{
+			output[2 + i] = (unsigned char)(packedIndices >> (i * 8));
+		}
+	}
+
+	// bc7 end points are stored as 7 bits per channel plus one shared low bit per end point
+	float quantizeBC7Endpoint(const float endpoint[4], unsigned char quantized[4], unsigned char& pBit)
+	{
+		float bestError = FLT_MAX;
+		for (unsigned char p = 0; p < 2; p++)
+		{
+			unsigned char candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				candidate[c] = (unsigned char)std::clamp((int)std::lround((endpoint[c] - p) / 2.0f), 0, 127);
+				float difference = (float)((candidate[c] << 1) | p) - endpoint[c];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				std::memcpy(quantized, candidate, 4);
+			}
+		}
+		return bestError;
+	}
+
+	float encodeBC7Endpoints(const BlockPixels& pixels, const float start[4], const float end[4], unsigned char quantized[2][4], unsigned char pBits[2], unsigned char* indices)
+	{
+		quantizeBC7Endpoint(start, quantized[0], pBits[0]);
+		quantizeBC7Endpoint(end, quantized[1], pBits[1]);
+
+		float palette[16][4];
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				int value0 = (quantized[0][c] << 1) | pBits[0];
+				int value1 = (quantized[1][c] << 1) | pBits[1];
+				palette[i][c] = (float)(((64 - BC7_WEIGHTS[i]) * value0 + BC7_WEIGHTS[i] * value1 + 32) >> 6);
+			}
+		}
+		return findClosest(pixels, 0, 4, palette, 16, indices);
+	}
+
+	struct BitWriter
+	{
+		unsigned char* output;
+		int position = 0;
+
+		void write(const unsigned int value, const int bitCount)
+		{
+			for (int i = 0; i < bitCount; i++)
+			{
+				if ((value >> i) & 1)
+				{
+					this->output[this->position >> 3] |= (unsigned char)(1 << (this->position & 7));
+				}
+				this->position++;
+			}
+		}
+	};
+}
+
+GLenum TextureCompressor::getInternalFormat(const TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1:
+		return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case TextureFormat::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TextureFormat::BC5:
+		return GL_COMPRESSED_RG_RGTC2;
+	default:
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+
+std::size_t TextureCompressor::getBlockSize(const TextureFormat format)
+{
+	return format == TextureFormat::BC1 ? 8 : 16;
+}
+
+std::size_t TextureCompressor::getCompressedSize(const TextureFormat format, const int width, const int height)
+{
+	std::size_t blocksX = std::max((width + 3) / 4, 1);
+	std::size_t blocksY = std::max((height + 3) / 4, 1);
+	return blocksX * blocksY * TextureCompressor::getBlockSize(format);
+}
+
+std::vector<unsigned char> TextureCompressor::compress(const TextureFormat format, const unsigned char* rgba, const int width, const int height)
+{
+	std::vector<unsigned char> output(TextureCompressor::getCompressedSize(format, width, height));
+	std::size_t blockSize = TextureCompressor::getBlockSize(format);
+	unsigned char* blockOutput = output.data();
+
+	unsigned char block[64];
+	for (int blockY = 0; blockY < height; blockY += 4)
+	{
+		for (int blockX = 0; blockX < width; blockX += 4)
+		{
+			for (int y = 0; y < 4; y++)
+			{
+				for (int x = 0; x < 4; x++)
+				{
+					int sourceX = std::min(blockX + x, width - 1);
+					int sourceY = std::min(blockY + y, height - 1);
+					std::memcpy(block + (y * 4 + x) * 4, rgba + ((std::size_t)sourceY * width + sourceX) * 4, 4);
+				}
+			}
+
+			switch (format)
+			{
+			case TextureFormat::BC1:
+				TextureCompressor::compressBlockBC1(block, blockOutput);
+				break;
+			case TextureFormat::BC3:
+				TextureCompressor::compressBlockBC3(block, blockOutput);
+				break;
+			case TextureFormat::BC5:
+				TextureCompressor::compressBlockBC5(block, blockOutput);
+				break;
+			case TextureFormat::BC7:
+				TextureCompressor::compressBlockBC7(block, blockOutput);
+				break;
+			}
+			blockOutput += blockSize;
+		}
+	}
+
+	return output;
+}
+
+void TextureCompressor::compressBlockBC1(const unsigned char* block, unsigned char* output)
+{
+	BlockPixels pixels;
+	loadBlock(block, pixels);
+	compressColorBlock(pixels, output);
+}
+
+void TextureCompressor::compressBlockBC3(const unsigned char* block, unsigned char* output)
+{
+	BlockPixels pixels;
+	loadBlock(block, pixels);
+	compressChannelBlock(pixels, 3, output);
+	compressColorBlock(pixels, output + 8);
+}
+
+void TextureCompressor::compressBlockBC5(const unsigned char* block, unsigned char* output)
+{
+	BlockPixels pixels;
+	loadBlock(block, pixels);
+	compressChannelBlock(pixels, 0, output);
+	compressChannelBlock(pixels, 1, output + 8);
+}
+
+void TextureCompressor::compressBlockBC7(const unsigned char* block, unsigned char* output)
+{
+	// only mode 6 is used, a single subset with rgba end points and 4 bit indices suits most colour content
+	BlockPixels pixels;
+	loadBlock(block, pixels);
+
+	float start[4], end[4];
+	findEndpoints(pixels, 4, start, end);
+
+	unsigned char quantized[2][4];
+	unsigned char pBits[2];
+	unsigned char indices[16];
+	float error = encodeBC7Endpoints(pixels, start, end, quantized, pBits, indices);
+
+	float weights[16];
+	for (int i = 0; i < 16; i++)
+	{
+		weights[i] = BC7_WEIGHTS[i] / 64.0f;
+	}
+	if (refineEndpoints(pixels, 4, indices, weights, start, end))
+	{
+		unsigned char refinedQuantized[2][4];
+		unsigned char refinedPBits[2];
+		unsigned char refinedIndices[16];
+		float refinedError = encodeBC7Endpoints(pixels, start, end, refinedQuantized, refinedPBits, refinedIndices);
+		if (refinedError < error)
+		{
+			std::memcpy(quantized, refinedQuantized, sizeof(quantized));
+			std::memcpy(pBits, refinedPBits, sizeof(pBits));
+			std::memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	// the first index is stored with its top bit implied zero, swap end points if it is set
+	if (indices[0] >= 8)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			std::swap(quantized[0][c], quantized[1][c]);
+		}
+		std::swap(pBits[0], pBits[1]);
+		for (int i = 0; i < 16; i++)
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	std::memset(output, 0, 16);
+	BitWriter writer = { output };
+	writer.write(1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		writer.write(quantized[0][c], 7);
+		writer.write(quantized[1][c], 7);
+	}
+	writer.write(pBits[0], 1);
+	writer.write(pBits[1], 1);
+	writer.write(indices[0], 3);
+	for (int i = 1; i < 16; i++)
+	{
+		writer.write(indices[i], 4);
+	}
+}
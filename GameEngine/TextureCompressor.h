@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// s3tc is an extension in the core profile loader but is available on every desktop driver
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+enum class TextureFormat {
+	BC1, BC3, BC5, BC7
+};
+
+struct TextureCompressor
+{
+	static GLenum getInternalFormat(const TextureFormat format);
+
+	static std::size_t getBlockSize(const TextureFormat format);
+
+	static std::size_t getCompressedSize(const TextureFormat format, const int width, const int height);
+
+	// input is 4 bytes per pixel rgba, edge pixels are repeated when the size is not a multiple of the block size
+	static std::vector<unsigned char> compress(const TextureFormat format, const unsigned char* rgba, const int width, const int height);
+
+	// block functions take 16 rgba pixels in row order
+	static void compressBlockBC1(const unsigned char* block, unsigned char* output);
+
+	static void compressBlockBC3(const unsigned char* block, unsigned char* output);
+
+	static void compressBlockBC5(const unsigned char* block, unsigned char* output);
+
+	static void compressBlockBC7(const unsigned char* block, unsigned char* output);
+};
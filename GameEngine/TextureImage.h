@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <memory>
+
+// one face / mip level of a texture held in cpu memory, internalFormat is 0 for uncompressed pixels
+struct TextureImage
+{
+	GLenum target;
+	GLint level = 0;
+	int width;
+	int height;
+	int nrComponents;
+	GLenum internalFormat = 0;
+	std::size_t size;
+	std::unique_ptr<unsigned char, void(*)(void*)> pixels = { nullptr, nullptr };
+};
@@ -0,0 +1,384 @@
+#include "TextureStreamer.h"
+
+#include "stb_image.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <array>
+
+#include "OpenGLFunctions.h"
+#include "TextureCache.h"
+#include "OpenGLState.h"
+#include "Loader.h"
+#include "Config.h"
+
+std::vector<std::thread> TextureStreamer::workers;
+std::deque<TextureRequest> TextureStreamer::requests;
+std::deque<DecodedTexture> TextureStreamer::decoded;
+std::mutex TextureStreamer::requestMutex;
+std::mutex TextureStreamer::decodedMutex;
+std::condition_variable TextureStreamer::requestCondition;
+bool TextureStreamer::running = false;
+
+std::vector<StagingBuffer> TextureStreamer::stagingBuffers;
+std::size_t TextureStreamer::stagingBufferSize = 0;
+std::size_t TextureStreamer::nextStagingBuffer = 0;
+std::size_t TextureStreamer::uploadBudget = 0;
+std::size_t TextureStreamer::pending = 0;
+
+namespace
+{
+	std::size_t getTextureSize(const DecodedTexture& texture)
+	{
+		std::size_t size = 0;
+		for (const TextureImage& image : texture.images)
+		{
+			size += image.size;
+		}
+		return size;
+	}
+}
+
+void TextureStreamer::init(const unsigned int workerCount, const std::size_t uploadBudget, const std::size_t stagingBufferSize, const unsigned int stagingBufferCount)
+{
+	if (TextureStreamer::running)
+	{
+		return;
+	}
+
+	TextureStreamer::uploadBudget = uploadBudget;
+	TextureStreamer::stagingBufferSize = stagingBufferSize;
+	TextureStreamer::nextStagingBuffer = 0;
+
+	// pixel buffer ring, each buffer is fenced after use so it is only rewritten once the gpu has consumed it
+	TextureStreamer::stagingBuffers.resize(stagingBufferCount);
+	for (StagingBuffer& staging : TextureStreamer::stagingBuffers)
+	{
+		glCall(glGenBuffers, 1, &staging.pbo);
+		OpenGLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.pbo);
+		glCall(glBufferData, GL_PIXEL_UNPACK_BUFFER, stagingBufferSize, nullptr, GL_STREAM_DRAW);
+	}
+	OpenGLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	TextureStreamer::running = true;
+	unsigned int threadCount = std::max(workerCount, 1u);
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		TextureStreamer::workers.emplace_back(TextureStreamer::workerLoop);
+	}
+
+	spdlog::debug("Started texture streamer with {:d} decode threads and {:d} staging buffers", threadCount, stagingBufferCount);
+}
+
+Texture TextureStreamer::requestTexture(const std::string& filename, const std::string& typeName, const bool flipVertically, const GLint wrapMode)
+{
+	TextureRequest request;
+	glCall(glGenTextures, 1, &request.textureID);
+	request.target = GL_TEXTURE_2D;
+	request.typeName = typeName;
+	request.paths = { filename };
+	request.flipVertically = flipVertically;
+	request.generateMipmaps = true;
+	request.compressed = Config::Textures::COMPRESSION;
+
+	TextureStreamer::createPlaceholder(request, typeName);
+	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glCall(glTexParameteri, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	Texture texture;
+	texture.ID = request.textureID;
+	texture.Type = typeName;
+	texture.Path = filename;
+
+	{
+		std::lock_guard<std::mutex> lock(TextureStreamer::requestMutex);
+		TextureStreamer::requests.push_back(std::move(request));
+	}
+	TextureStreamer::requestCondition.notify_one();
+	TextureStreamer::pending++;
+
+	return texture;
+}
+
+Texture TextureStreamer::requestCubeMap(const std::vector<std::string>& faces, const std::string& path)
+{
+	TextureRequest request;
+	glCall(glGenTextures, 1, &request.textureID);
+	request.target = GL_TEXTURE_CUBE_MAP;
+	request.typeName = "texture_cubeMap";
+	request.paths = faces;
+	request.flipVertically = false;
+	request.generateMipmaps = false;
+	request.compressed = Config::Textures::COMPRESSION;
+
+	TextureStreamer::createPlaceholder(request, "texture_cubeMap");
+	glCall(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glCall(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glCall(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glCall(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glCall(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	Texture texture;
+	texture.ID = request.textureID;
+	texture.Type = "texture_cubeMap";
+	texture.Path = path;
+
+	{
+		std::lock_guard<std::mutex> lock(TextureStreamer::requestMutex);
+		TextureStreamer::requests.push_back(std::move(request));
+	}
+	TextureStreamer::requestCondition.notify_one();
+	TextureStreamer::pending++;
+
+	return texture;
+}
+
+void TextureStreamer::createPlaceholder(const TextureRequest& request, const std::string& typeName)
+{
+	// 1x1 stand in until the decoded image arrives, flat normal for normal maps and mid grey for everything else
+	std::array<GLubyte, 4> texel = { 128, 128, 128, 255 };
+	if (typeName == "texture_normal")
+	{
+		texel = { 128, 128, 255, 255 };
+	}
+
+	OpenGLState::bindTexture(request.target, request.textureID);
+	if (request.target == GL_TEXTURE_CUBE_MAP)
+	{
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			glCall(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel.data());
+		}
+	}
+	else
+	{
+		glCall(glTexImage2D, request.target, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel.data());
+	}
+}
+
+void TextureStreamer::workerLoop()
+{
+	while (true)
+	{
+		TextureRequest request;
+		{
+			std::unique_lock<std::mutex> lock(TextureStreamer::requestMutex);
+			TextureStreamer::requestCondition.wait(lock, [] { return !TextureStreamer::running || !TextureStreamer::requests.empty(); });
+			if (!TextureStreamer::running)
+			{
+				return;
+			}
+
+			request = std::move(TextureStreamer::requests.front());
+			TextureStreamer::requests.pop_front();
+		}
+
+		DecodedTexture texture;
+		if (request.compressed && TextureCache::loadOrCook(request.paths, request.typeName, request.flipVertically, request.target, texture.images))
+		{
+			texture.request = std::move(request);
+
+			std::lock_guard<std::mutex> lock(TextureStreamer::decodedMutex);
+			TextureStreamer::decoded.push_back(std::move(texture));
+			continue;
+		}
+
+		for (unsigned int i = 0; i < request.paths.size(); i++)
+		{
+			TextureImage image;
+			image.target = (request.target == GL_TEXTURE_CUBE_MAP) ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + i : request.target;
+
+			unsigned char* data = Loader::decodeImage(request.paths[i], request.flipVertically, image.width, image.height, image.nrComponents);
+			if (!data)
+			{
+				spdlog::error("Failed to load texture at '{}'", request.paths[i]);
+				continue;
+			}
+
+			image.size = (std::size_t)image.width * image.height * image.nrComponents;
+			image.pixels = std::unique_ptr<unsigned char, void(*)(void*)>(data, stbi_image_free);
+			texture.images.push_back(std::move(image));
+		}
+		texture.request = std::move(request);
+
+		std::lock_guard<std::mutex> lock(TextureStreamer::decodedMutex);
+		TextureStreamer::decoded.push_back(std::move(texture));
+	}
+}
+
+void TextureStreamer::update()
+{
+	std::size_t uploaded = 0;
+	while (true)
+	{
+		DecodedTexture texture;
+		{
+			std::lock_guard<std::mutex> lock(TextureStreamer::decodedMutex);
+			if (TextureStreamer::decoded.empty())
+			{
+				break;
+			}
+
+			// always allow one upload per frame so textures larger than the budget still make progress
+			std::size_t size = getTextureSize(TextureStreamer::decoded.front());
+			if (uploaded > 0 && uploaded + size > TextureStreamer::uploadBudget)
+			{
+				break;
+			}
+
+			texture = std::move(TextureStreamer::decoded.front());
+			TextureStreamer::decoded.pop_front();
+		}
+
+		if (!TextureStreamer::upload(texture))
+		{
+			std::lock_guard<std::mutex> lock(TextureStreamer::decodedMutex);
+			TextureStreamer::decoded.push_front(std::move(texture));
+			break;
+		}
+
+		uploaded += getTextureSize(texture);
+		TextureStreamer::pending--;
+	}
+}
+
+bool TextureStreamer::upload(const DecodedTexture& texture)
+{
+	if (texture.images.empty())
+	{
+		return true;
+	}
+
+	// claim the next staging buffer, skip this frame rather than stall if the gpu is still reading from it
+	std::size_t totalSize = getTextureSize(texture);
+	StagingBuffer* staging = nullptr;
+	if (totalSize <= TextureStreamer::stagingBufferSize && !TextureStreamer::stagingBuffers.empty())
+	{
+		staging = &TextureStreamer::stagingBuffers[TextureStreamer::nextStagingBuffer];
+		if (staging->fence != nullptr)
+		{
+			if (glCall(glClientWaitSync, staging->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			{
+				return false;
+			}
+			glCall(glDeleteSync, staging->fence);
+			staging->fence = nullptr;
+		}
+		TextureStreamer::nextStagingBuffer = (TextureStreamer::nextStagingBuffer + 1) % TextureStreamer::stagingBuffers.size();
+	}
+
+	OpenGLState::bindTexture(texture.request.target, texture.request.textureID);
+	glCall(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+
+	unsigned char* mapped = nullptr;
+	if (staging != nullptr)
+	{
+		OpenGLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, staging->pbo);
+		mapped = (unsigned char*)glCall(glMapBufferRange, GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)totalSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+		// a failed map leaves nothing mapped, the pixels then go up straight from client memory
+		if (mapped == nullptr)
+		{
+			spdlog::warn("Failed to map a texture staging buffer, uploading directly");
+			OpenGLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+	}
+
+	if (mapped != nullptr)
+	{
+		std::size_t offset = 0;
+		for (const TextureImage& image : texture.images)
+		{
+			std::memcpy(mapped + offset, image.pixels.get(), image.size);
+			offset += image.size;
+		}
+		glCall(glUnmapBuffer, GL_PIXEL_UNPACK_BUFFER);
+
+		offset = 0;
+		for (const TextureImage& image : texture.images)
+		{
+			TextureStreamer::uploadImage(image, (void*)offset);
+			offset += image.size;
+		}
+
+		staging->fence = glCall(glFenceSync, GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		OpenGLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else
+	{
+		for (const TextureImage& image : texture.images)
+		{
+			TextureStreamer::uploadImage(image, image.pixels.get());
+		}
+	}
+
+	glCall(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+
+	// cooked textures carry their own mip chain
+	if (texture.images.front().internalFormat != 0)
+	{
+		GLint maxLevel = 0;
+		for (const TextureImage& image : texture.images)
+		{
+			maxLevel = std::max(maxLevel, image.level);
+		}
+		glCall(glTexParameteri, texture.request.target, GL_TEXTURE_MAX_LEVEL, maxLevel);
+	}
+	else if (texture.request.generateMipmaps)
+	{
+		glCall(glGenerateMipmap, texture.request.target);
+	}
+
+	return true;
+}
+
+void TextureStreamer::uploadImage(const TextureImage& image, const void* pixels)
+{
+	if (image.internalFormat != 0)
+	{
+		glCall(glCompressedTexImage2D, image.target, image.level, image.internalFormat, image.width, image.height, 0, (GLsizei)image.size, pixels);
+	}
+	else
+	{
+		GLenum format = Loader::getTextureFormat(image.nrComponents);
+		glCall(glTexImage2D, image.target, image.level, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+	}
+}
+
+std::size_t TextureStreamer::getPendingCount()
+{
+	return TextureStreamer::pending;
+}
+
+void TextureStreamer::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(TextureStreamer::requestMutex);
+		TextureStreamer::running = false;
+		TextureStreamer::requests.clear();
+	}
+	TextureStreamer::requestCondition.notify_all();
+
+	for (std::thread& worker : TextureStreamer::workers)
+	{
+		worker.join();
+	}
+	TextureStreamer::workers.clear();
+	TextureStreamer::decoded.clear();
+	TextureStreamer::pending = 0;
+
+	for (StagingBuffer& staging : TextureStreamer::stagingBuffers)
+	{
+		if (staging.fence != nullptr)
+		{
+			glCall(glDeleteSync, staging.fence);
+		}
+		OpenGLState::deleteBuffers(1, &staging.pbo);
+	}
+	TextureStreamer::stagingBuffers.clear();
+}
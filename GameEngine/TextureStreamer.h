@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <deque>
+
+#include "TextureImage.h"
+#include "Texture.h"
+
+struct TextureRequest
+{
+	GLuint textureID;
+	GLenum target;
+	std::string typeName;
+	std::vector<std::string> paths;
+	bool flipVertically;
+	bool generateMipmaps;
+	bool compressed;
+};
+
+struct DecodedTexture
+{
+	TextureRequest request;
+	std::vector<TextureImage> images;
+};
+
+struct StagingBuffer
+{
+	GLuint pbo = 0;
+	GLsync fence = nullptr;
+};
+
+struct TextureStreamer
+{
+private:
+	static std::vector<std::thread> workers;
+	static std::deque<TextureRequest> requests;
+	static std::deque<DecodedTexture> decoded;
+	static std::mutex requestMutex;
+	static std::mutex decodedMutex;
+	static std::condition_variable requestCondition;
+	static bool running;
+
+	static std::vector<StagingBuffer> stagingBuffers;
+	static std::size_t stagingBufferSize;
+	static std::size_t nextStagingBuffer;
+	static std::size_t uploadBudget;
+	static std::size_t pending;
+
+	static void workerLoop();
+
+	static void createPlaceholder(const TextureRequest& request, const std::string& typeName);
+
+	static bool upload(const DecodedTexture& texture);
+
+	static void uploadImage(const TextureImage& image, const void* pixels);
+
+public:
+	static void init(const unsigned int workerCount, const std::size_t uploadBudget, const std::size_t stagingBufferSize, const unsigned int stagingBufferCount);
+
+	static Texture requestTexture(const std::string& filename, const std::string& typeName, const bool flipVertically, const GLint wrapMode);
+
+	static Texture requestCubeMap(const std::vector<std::string>& faces, const std::string& path);
+
+	static void update();
+
+	static std::size_t getPendingCount();
+
+	static void shutdown();
+};
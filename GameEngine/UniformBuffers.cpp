@@ -0,0 +1,106 @@
+#include "UniformBuffers.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "OpenGLFunctions.h"
+#include "OpenGLState.h"
+#include "RenderStats.h"
+#include "RingBuffer.h"
+#include "Camera.h"
+
+std::size_t UniformBuffers::frameAlignment = 0;
+std::size_t UniformBuffers::objectAlignment = 0;
+std::vector<unsigned char> UniformBuffers::objectStaging;
+GLuint UniformBuffers::objectBuffer = 0;
+
+const GLuint UniformBuffers::FRAME_BINDING = 1;
+const GLuint UniformBuffers::OBJECT_BINDING = 2;
+const unsigned int UniformBuffers::MAX_LIGHTS = 4;
+
+static_assert(sizeof(FrameUniforms) == 352, "FrameUniforms must match the std140 layout of FrameBlock");
+static_assert(sizeof(ObjectUniforms) == 160, "ObjectUniforms must match the std430 layout of ObjectBlock");
+
+void UniformBuffers::init()
+{
+	// both blocks live in the ring buffer and are bound by range, so each write starts on the driver's offset alignment
+	GLint alignment = 256;
+	glCall(glGetIntegerv, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	UniformBuffers::frameAlignment = std::max((std::size_t)alignment, sizeof(glm::vec4));
+
+	alignment = 256;
+	glCall(glGetIntegerv, GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	UniformBuffers::objectAlignment = std::max((std::size_t)alignment, sizeof(glm::vec4));
+	UniformBuffers::objectStaging.clear();
+	UniformBuffers::objectBuffer = 0;
+}
+
+void UniformBuffers::updateFrame(const glm::mat4& projectionMatrix, const std::vector<Light>& lights, const float time)
+{
+	FrameUniforms frame;
+	std::memset(&frame, 0, sizeof(frame));
+	frame.viewMatrix = Camera::viewMatrix;
+	frame.projectionMatrix = projectionMatrix;
+	frame.viewProjectionMatrix = projectionMatrix * Camera::viewMatrix;
+	frame.cameraPosition = glm::vec4(Camera::position, 1.0f);
+	frame.lightCount = (int)std::min((std::size_t)UniformBuffers::MAX_LIGHTS, lights.size());
+	for (int i = 0; i < frame.lightCount; i++)
+	{
+		frame.lightPositions[i] = glm::vec4(lights[i].position, 1.0f);
+		frame.lightColors[i] = glm::vec4(lights[i].color, 1.0f);
+	}
+	frame.time = time;
+
+	RingAllocation allocation = RingBuffer::write(&frame, sizeof(frame), UniformBuffers::frameAlignment);
+	OpenGLState::bindBufferRange(GL_UNIFORM_BUFFER, UniformBuffers::FRAME_BINDING, allocation.buffer, allocation.offset, sizeof(FrameUniforms));
+	RenderStats::current.bufferUploads++;
+}
+
+ObjectUniforms UniformBuffers::createObject(const glm::mat4& transformationMatrix, const VertexQuantization& quantization)
+{
+	ObjectUniforms object;
+	object.transformationMatrix = transformationMatrix;
+	object.normalMatrix = glm::transpose(glm::inverse(transformationMatrix));
+	object.positionOffset = glm::vec4(quantization.offset, quantization.packed ? 1.0f : 0.0f);
+	object.positionScale = glm::vec4(quantization.scale, 0.0f);
+	return object;
+}
+
+std::size_t UniformBuffers::alignObjects(const std::size_t offset)
+{
+	return (offset + UniformBuffers::objectAlignment - 1) / UniformBuffers::objectAlignment * UniformBuffers::objectAlignment;
+}
+
+std::size_t UniformBuffers::stageObjects(std::span<const ObjectUniforms> objects)
+{
+	std::size_t offset = UniformBuffers::alignObjects(UniformBuffers::objectStaging.size());
+	UniformBuffers::objectStaging.resize(offset + objects.size_bytes());
+	std::memcpy(UniformBuffers::objectStaging.data() + offset, objects.data(), objects.size_bytes());
+	return offset;
+}
+
+std::size_t UniformBuffers::uploadObjects()
+{
+	std::size_t size = UniformBuffers::objectStaging.size();
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	RingAllocation allocation = RingBuffer::write(UniformBuffers::objectStaging.data(), size, UniformBuffers::objectAlignment);
+	UniformBuffers::objectBuffer = allocation.buffer;
+	UniformBuffers::objectStaging.clear();
+	RenderStats::current.bufferUploads++;
+	return allocation.offset;
+}
+
+std::size_t UniformBuffers::pushObjects(std::span<const ObjectUniforms> objects)
+{
+	std::size_t offset = UniformBuffers::stageObjects(objects);
+	return UniformBuffers::uploadObjects() + offset;
+}
+
+void UniformBuffers::bindObjects(const std::size_t offset, const std::size_t count)
+{
+	OpenGLState::bindBufferRange(GL_SHADER_STORAGE_BUFFER, UniformBuffers::OBJECT_BINDING, UniformBuffers::objectBuffer, offset, count * sizeof(ObjectUniforms));
+}
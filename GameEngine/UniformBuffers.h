@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+#include "Light.h"
+
+// std140 layout of FrameBlock, written once per frame and shared by every scene shader
+struct FrameUniforms
+{
+	glm::mat4 viewMatrix;
+	glm::mat4 projectionMatrix;
+	glm::mat4 viewProjectionMatrix;
+	glm::vec4 cameraPosition;
+	glm::vec4 lightPositions[4];
+	glm::vec4 lightColors[4];
+	float time;
+	int lightCount;
+	float padding[2];
+};
+
+// std430 layout of an ObjectBlock entry, one per instance
+struct ObjectUniforms
+{
+	glm::mat4 transformationMatrix;
+	glm::mat4 normalMatrix;
+	glm::vec4 positionOffset; // w is 1 for packed vertices
+	glm::vec4 positionScale;
+};
+
+struct UniformBuffers
+{
+private:
+	static std::size_t frameAlignment;
+	static std::size_t objectAlignment;
+	static std::vector<unsigned char> objectStaging;
+
+	// ring buffer holding the runs of the last upload
+	static GLuint objectBuffer;
+
+	static std::size_t alignObjects(const std::size_t offset);
+
+public:
+	// binding points used by the layout qualifiers in the shaders
+	static const GLuint FRAME_BINDING;
+	static const GLuint OBJECT_BINDING;
+	static const unsigned int MAX_LIGHTS;
+
+	static void init();
+
+	static void updateFrame(const glm::mat4& projectionMatrix, const std::vector<Light>& lights, const float time);
+
+	static ObjectUniforms createObject(const glm::mat4& transformationMatrix, const VertexQuantization& quantization);
+
+	// appends a run of entries read by one draw, instance i reads entry i, returns the run's offset from the start of the upload
+	static std::size_t stageObjects(std::span<const ObjectUniforms> objects);
+
+	// copies every staged run into the ring buffer at once and returns the offset to add to their staged offsets, valid until the next upload
+	static std::size_t uploadObjects();
+
+	// stages and uploads a single run, returns its offset in the buffer
+	static std::size_t pushObjects(std::span<const ObjectUniforms> objects);
+
+	static void bindObjects(const std::size_t offset, const std::size_t count);
+
+};
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
 struct Vertex
 {
 	glm::vec3 Position;
@@ -8,3 +12,20 @@ struct Vertex
 	glm::vec3 Tangent;
 	glm::vec3 Bitangent;
 };
+
+// 20 byte gpu layout of a Vertex, decoded in the vertex shaders
+struct PackedVertex
+{
+	std::uint16_t Position[4];  // unorm16 within the mesh bounds, w is the bitangent sign
+	std::uint16_t TexCoords[2]; // half float
+	std::int16_t Normal[2];     // octahedral snorm16
+	std::int16_t Tangent[2];    // octahedral snorm16
+};
+
+// maps packed positions back to model space, identity for float vertices
+struct VertexQuantization
+{
+	glm::vec3 offset = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+	bool packed = false;
+};
@@ -0,0 +1,123 @@
+#include "VertexPacker.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+	std::uint16_t quantizeUnorm(const float value)
+	{
+		return (std::uint16_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+	}
+
+	std::int16_t quantizeSnorm(const float value)
+	{
+		return (std::int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	// matches the gl conversion of normalized shorts, -32768 and -32767 both map to -1
+	float dequantizeSnorm(const std::int16_t value)
+	{
+		return std::max(value / 32767.0f, -1.0f);
+	}
+}
+
+VertexQuantization VertexPacker::pack(std::span<const Vertex> vertices, std::vector<PackedVertex>& packed)
+{
+	VertexQuantization quantization;
+	quantization.packed = true;
+
+	glm::vec3 minimum(std::numeric_limits<float>::max()), maximum(std::numeric_limits<float>::lowest());
+	for (const Vertex& vertex : vertices)
+	{
+		minimum = glm::min(minimum, vertex.Position);
+		maximum = glm::max(maximum, vertex.Position);
+	}
+	if (vertices.empty())
+	{
+		minimum = maximum = glm::vec3(0.0f);
+	}
+	quantization.offset = minimum;
+	quantization.scale = maximum - minimum;
+
+	// flat axes would divide by zero, every vertex sits at the offset anyway
+	glm::vec3 inverseScale;
+	for (int i = 0; i < 3; i++)
+	{
+		inverseScale[i] = quantization.scale[i] > 0.0f ? 1.0f / quantization.scale[i] : 0.0f;
+	}
+
+	packed.resize(vertices.size());
+	for (std::size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& vertex = vertices[i];
+		PackedVertex& output = packed[i];
+
+		glm::vec3 position = (vertex.Position - quantization.offset) * inverseScale;
+		output.Position[0] = quantizeUnorm(position.x);
+		output.Position[1] = quantizeUnorm(position.y);
+		output.Position[2] = quantizeUnorm(position.z);
+
+		// shaders rebuild the bitangent as cross(normal, tangent), only its handedness is kept
+		bool flipped = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f;
+		output.Position[3] = flipped ? 0 : 65535;
+
+		output.TexCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+		output.TexCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+
+		glm::vec2 normal = VertexPacker::encodeOctahedral(vertex.Normal);
+		output.Normal[0] = quantizeSnorm(normal.x);
+		output.Normal[1] = quantizeSnorm(normal.y);
+
+		glm::vec2 tangent = VertexPacker::encodeOctahedral(vertex.Tangent);
+		output.Tangent[0] = quantizeSnorm(tangent.x);
+		output.Tangent[1] = quantizeSnorm(tangent.y);
+	}
+
+	return quantization;
+}
+
+Vertex VertexPacker::unpack(const PackedVertex& vertex, const VertexQuantization& quantization)
+{
+	Vertex output;
+	output.Position = VertexPacker::unpackPosition(vertex, quantization);
+	output.TexCoords = glm::vec2(glm::unpackHalf1x16(vertex.TexCoords[0]), glm::unpackHalf1x16(vertex.TexCoords[1]));
+	output.Normal = VertexPacker::decodeOctahedral(glm::vec2(dequantizeSnorm(vertex.Normal[0]), dequantizeSnorm(vertex.Normal[1])));
+	output.Tangent = VertexPacker::decodeOctahedral(glm::vec2(dequantizeSnorm(vertex.Tangent[0]), dequantizeSnorm(vertex.Tangent[1])));
+	output.Bitangent = glm::cross(output.Normal, output.Tangent) * (vertex.Position[3] == 0 ? -1.0f : 1.0f);
+	return output;
+}
+
+glm::vec3 VertexPacker::unpackPosition(const PackedVertex& vertex, const VertexQuantization& quantization)
+{
+	glm::vec3 position(vertex.Position[0], vertex.Position[1], vertex.Position[2]);
+	return quantization.offset + position / 65535.0f * quantization.scale;
+}
+
+glm::vec2 VertexPacker::encodeOctahedral(const glm::vec3& vector)
+{
+	float length = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+	if (length == 0.0f)
+	{
+		return glm::vec2(0.0f);
+	}
+
+	glm::vec3 n = vector / length;
+	if (n.z < 0.0f)
+	{
+		return glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+	}
+	return glm::vec2(n.x, n.y);
+}
+
+glm::vec3 VertexPacker::decodeOctahedral(const glm::vec2& encoded)
+{
+	glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
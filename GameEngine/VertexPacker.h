@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+
+struct VertexPacker
+{
+	// positions are quantized against the bounds of the given vertices, the returned quantization undoes it
+	static VertexQuantization pack(std::span<const Vertex> vertices, std::vector<PackedVertex>& packed);
+
+	static Vertex unpack(const PackedVertex& vertex, const VertexQuantization& quantization);
+
+	static glm::vec3 unpackPosition(const PackedVertex& vertex, const VertexQuantization& quantization);
+
+	// unit vector to the [-1, 1] square, the lower hemisphere is folded over the diagonals
+	static glm::vec2 encodeOctahedral(const glm::vec3& vector);
+
+	static glm::vec3 decodeOctahedral(const glm::vec2& encoded);
+};